@@ -0,0 +1,490 @@
+/*
+  ==============================================================================
+
+   Benchmarks for the juce_libvlc module
+
+   Measures player creation, open-to-first-frame time, seek latency, sustained
+   and offline decode rates, and the cost of the audio hot paths. Results are
+   printed as JSON on stdout (progress goes to stderr), so runs can be compared
+   across releases.
+
+   Usage: juce_libvlc_bench [--iterations N] [--seconds S] [--output file.json] media...
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../juce_libvlc.h"
+#include <vlc/vlc.h>
+#include <algorithm>
+#include <iostream>
+
+using namespace juce;
+
+namespace
+{
+    struct BenchOptions
+    {
+        int iterations = 10;
+        double decodeSeconds = 5.0;
+        File output;
+        Array<File> media;
+    };
+
+    double nowMs()
+    {
+        return Time::getMillisecondCounterHiRes();
+    }
+
+    void progress (const String& message)
+    {
+        std::cerr << message << std::endl;
+    }
+
+    // Runs the message loop, which the player's timers and async updates need, until a condition holds
+    bool waitUntil (const std::function<bool()>& condition, int timeoutMs)
+    {
+        auto deadline = nowMs() + timeoutMs;
+
+        while (! condition())
+        {
+            if (nowMs() >= deadline)
+                return false;
+
+            MessageManager::getInstance()->runDispatchLoopUntil (1);
+        }
+
+        return true;
+    }
+
+    void runFor (double ms)
+    {
+        auto deadline = nowMs() + ms;
+        waitUntil ([deadline] { return nowMs() >= deadline; }, static_cast<int>(ms) + 1);
+    }
+
+    /** Summarises a set of timings as count, min, mean, median, 90th percentile and max. */
+    var summarise (Array<double> samples, int numFailures = 0)
+    {
+        auto* result = new DynamicObject();
+        result->setProperty ("count", samples.size());
+        result->setProperty ("failures", numFailures);
+
+        if (! samples.isEmpty())
+        {
+            std::sort (samples.begin(), samples.end());
+
+            double total = 0.0;
+            for (auto sample : samples)
+                total += sample;
+
+            auto percentile = [&samples] (double p) { return samples[jmin (samples.size() - 1, static_cast<int>(p * samples.size()))]; };
+
+            result->setProperty ("min", samples.getFirst());
+            result->setProperty ("mean", total / samples.size());
+            result->setProperty ("median", percentile (0.5));
+            result->setProperty ("p90", percentile (0.9));
+            result->setProperty ("max", samples.getLast());
+        }
+
+        return var (result);
+    }
+
+    StringArray getUniqueArguments (int index)
+    {
+        // A distinct argument set can't share an instance, so each player starts libVLC afresh
+        auto arguments = VLCInstanceManager::getDefaultArguments();
+        arguments.add ("--meta-title=juce_libvlc_bench_" + String (index));
+        return arguments;
+    }
+
+    //==============================================================================
+    var benchPlayerCreation (const BenchOptions& options)
+    {
+        progress ("Player creation...");
+        Array<double> shared, unshared;
+
+        {
+            // Holds the default instance open, as an application with one player already would
+            VLCMediaPlayer holder;
+
+            for (int i = 0; i < options.iterations; ++i)
+            {
+                auto start = nowMs();
+                auto player = std::make_unique<VLCMediaPlayer>();
+                shared.add (nowMs() - start);
+            }
+        }
+
+        for (int i = 0; i < options.iterations; ++i)
+        {
+            auto start = nowMs();
+            auto player = std::make_unique<VLCMediaPlayer> (getUniqueArguments (i));
+            unshared.add (nowMs() - start);
+        }
+
+        auto* result = new DynamicObject();
+        result->setProperty ("sharedInstanceMs", summarise (shared));
+        result->setProperty ("ownInstanceMs", summarise (unshared));
+        return var (result);
+    }
+
+    var benchOpenToFirstFrame (const File& media, const BenchOptions& options)
+    {
+        progress ("Open to first frame...");
+        VLCMediaPlayer player;
+        Array<double> timings;
+        int failures = 0;
+
+        for (int i = 0; i < options.iterations; ++i)
+        {
+            auto start = nowMs();
+            auto opened = player.open (media);
+
+            if (opened)
+                player.play();
+
+            if (opened && waitUntil ([&player] { return player.getStats().framesDisplayed > 0; }, 10000))
+                timings.add (nowMs() - start);
+            else
+                ++failures;
+
+            player.close();
+        }
+
+        return summarise (timings, failures);
+    }
+
+    var benchSeekLatency (const File& media, ISeekableMedia::SeekMode mode, const BenchOptions& options)
+    {
+        progress (String ("Seek latency (") + (mode == ISeekableMedia::SeekMode::Fast ? "Fast" : "Precise") + ")...");
+        VLCMediaPlayer player;
+        Array<double> timings;
+        int failures = 0;
+
+        if (! player.open (media))
+            return summarise ({}, options.iterations);
+
+        player.play();
+        waitUntil ([&player] { return player.getStats().framesDisplayed > 0 && player.getTotalDuration() > 0.0; }, 10000);
+
+        // The same pseudo-random targets every run, so results are comparable
+        Random random (1234);
+        auto duration = player.getTotalDuration();
+
+        for (int i = 0; i < options.iterations && duration > 0.0; ++i)
+        {
+            auto seeksBefore = player.getStats().numSeeks;
+            player.seekToTime (random.nextDouble() * duration * 0.9, mode);
+
+            if (waitUntil ([&player, seeksBefore] { return player.getStats().numSeeks > seeksBefore; }, 10000))
+                timings.add (player.getStats().lastSeekLatencyMs);
+            else
+                ++failures;
+
+            // Let playback settle, so each seek starts from steady state
+            runFor (250.0);
+        }
+
+        player.close();
+        return summarise (timings, failures);
+    }
+
+    var benchSustainedDecode (const File& media, VLCMediaPlayer::VideoPixelFormat format, const BenchOptions& options)
+    {
+        VLCMediaPlayer player;
+        player.setVideoPixelFormat (format);
+
+        if (! player.open (media))
+            return {};
+
+        player.play();
+        waitUntil ([&player] { return player.getStats().framesDisplayed > 0; }, 10000);
+        player.resetStats();
+
+        // Consume frames like a 60 Hz UI would, through the path the format is meant for
+        auto start = nowMs();
+        VLCMediaPlayer::VideoFrameView view;
+
+        while (nowMs() - start < options.decodeSeconds * 1000.0)
+        {
+            if (format == VLCMediaPlayer::VideoPixelFormat::RGB32)
+                player.getCurrentVideoFrame();
+            else
+                player.getCurrentVideoFrameView (view);
+
+            runFor (1000.0 / 60.0);
+        }
+
+        auto elapsedSeconds = (nowMs() - start) / 1000.0;
+        auto stats = player.getStats();
+        auto size = player.getVideoSize();
+        auto mediaFps = player.getVideoFrameRate();
+        player.close();
+
+        auto* result = new DynamicObject();
+        result->setProperty ("width", size.getWidth());
+        result->setProperty ("height", size.getHeight());
+        result->setProperty ("mediaFps", mediaFps);
+        result->setProperty ("displayedFps", stats.framesDisplayed / elapsedSeconds);
+        result->setProperty ("framesDropped", stats.framesDropped);
+        result->setProperty ("framesLate", stats.framesLate);
+        return var (result);
+    }
+
+    var benchOfflineDecode (const File& media, const BenchOptions& options)
+    {
+        progress ("Offline decode...");
+
+        struct CountingSink : public VLCMediaReader::FrameSink
+        {
+            void videoFrameDecoded (const Image&, double timeInSeconds) override
+            {
+                ++numFrames;
+                lastTime = timeInSeconds;
+            }
+
+            std::atomic<int> numFrames { 0 };
+            std::atomic<double> lastTime { 0.0 };
+        };
+
+        VLCMediaReader::Options readerOptions;
+        readerOptions.decodeAudio = false;
+
+        VLCMediaReader reader (readerOptions);
+        CountingSink sink;
+        reader.setFrameSink (&sink);
+
+        auto start = nowMs();
+
+        if (! reader.open (media))
+            return {};
+
+        reader.waitForEnd (static_cast<int>(options.decodeSeconds * 1000.0));
+        auto elapsedSeconds = (nowMs() - start) / 1000.0;
+        reader.close();
+
+        auto* result = new DynamicObject();
+        result->setProperty ("decodedFps", sink.numFrames.load() / elapsedSeconds);
+        result->setProperty ("speedFactor", sink.lastTime.load() / elapsedSeconds);
+        return var (result);
+    }
+
+    var benchDeinterleave (const BenchOptions& options)
+    {
+        progress ("Deinterleave...");
+        constexpr int blockSize = 512;
+        auto* result = new DynamicObject();
+
+        for (auto numChannels : { 1, 2, 6, 8, 16 })
+        {
+            HeapBlock<float> interleaved (static_cast<size_t>(blockSize * numChannels), true);
+            juce::AudioBuffer<float> planar (numChannels, blockSize);
+            Array<double> timings;
+
+            for (int run = 0; run < options.iterations; ++run)
+            {
+                constexpr int blocksPerRun = 1000;
+                auto start = Time::getHighResolutionTicks();
+
+                for (int i = 0; i < blocksPerRun; ++i)
+                    AudioDeinterleaver::deinterleave (interleaved, planar.getArrayOfWritePointers(), numChannels, blockSize);
+
+                auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+                timings.add (seconds * 1.0e6 / blocksPerRun);
+            }
+
+            result->setProperty (String (numChannels) + "ch", summarise (timings));
+        }
+
+        return var (result);
+    }
+
+    var benchDeviceCallback (const File& media, const BenchOptions& options)
+    {
+        constexpr int blockSize = 512;
+        constexpr double sampleRate = 48000.0;
+        auto* result = new DynamicObject();
+
+        VLCMediaPlayer player;
+        VLCAudioSource source (player);
+        source.prepareToPlay (blockSize, sampleRate);
+
+        if (! player.open (media))
+            return var (result);
+
+        player.play();
+        waitUntil ([&player] { return player.getAudioBufferLevel() > 0.1; }, 10000);
+        waitUntil ([&player] { return ! player.getAudioTracks().isEmpty(); }, 5000);
+        player.resetStats();
+
+        // The ring keeps the media's own layout, so that's the channel count being measured.
+        // Extra output channels would only be cleared.
+        auto tracks = player.getAudioTracks();
+        auto numChannels = jlimit (1, AudioDeinterleaver::maxChannels, tracks.isEmpty() ? 2 : tracks.getFirst().numChannels);
+
+        // Pull blocks in real time, as a device would
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+        Array<double> timings;
+        auto blockMs = blockSize * 1000.0 / sampleRate;
+        auto start = nowMs();
+
+        for (int block = 0; nowMs() - start < options.decodeSeconds * 1000.0; ++block)
+        {
+            auto callbackStart = Time::getHighResolutionTicks();
+            source.getNextAudioBlock (AudioSourceChannelInfo (buffer));
+            timings.add (Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - callbackStart) * 1.0e6);
+
+            auto due = start + (block + 1) * blockMs;
+            waitUntil ([due] { return nowMs() >= due; }, static_cast<int>(blockMs) + 1);
+        }
+
+        result->setProperty ("mediaChannels", numChannels);
+        result->setProperty ("callbackUs", summarise (timings));
+        result->setProperty ("underruns", player.getStats().audioUnderruns);
+
+        player.close();
+        return var (result);
+    }
+
+    // Writes a WAV file with a quiet tone on every channel, long enough for one device callback run
+    bool writeTestTone (const File& file, int numChannels, const BenchOptions& options)
+    {
+        constexpr double sampleRate = 48000.0;
+        auto numSamples = static_cast<int>((options.decodeSeconds + 3.0) * sampleRate);
+
+        juce::AudioBuffer<float> tone (numChannels, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto increment = MathConstants<double>::twoPi * 220.0 * (channel + 1) / sampleRate;
+
+            for (int i = 0; i < numSamples; ++i)
+                tone.setSample (channel, i, 0.1f * static_cast<float>(std::sin (increment * i)));
+        }
+
+        file.deleteFile();
+        auto stream = file.createOutputStream();
+
+        if (stream == nullptr)
+            return false;
+
+        WavAudioFormat wav;
+        std::unique_ptr<AudioFormatWriter> writer (wav.createWriterFor (stream.get(), sampleRate, static_cast<unsigned int>(numChannels), 16, {}, 0));
+
+        if (writer == nullptr)
+            return false;
+
+        stream.release();   // Owned by the writer now
+        return writer->writeFromAudioSampleBuffer (tone, 0, numSamples);
+    }
+
+    var benchDeviceCallbackChannels (const BenchOptions& options)
+    {
+        progress ("Device callback by channel count...");
+        auto* result = new DynamicObject();
+
+        // The same layouts as the deinterleaver, played from generated files so any media will do
+        for (auto numChannels : { 1, 2, 6, 8, 16 })
+        {
+            TemporaryFile tone (".wav");
+
+            if (writeTestTone (tone.getFile(), numChannels, options))
+                result->setProperty (String (numChannels) + "ch", benchDeviceCallback (tone.getFile(), options));
+        }
+
+        return var (result);
+    }
+
+    //==============================================================================
+    bool parseArguments (const StringArray& arguments, BenchOptions& options)
+    {
+        for (int i = 0; i < arguments.size(); ++i)
+        {
+            auto& argument = arguments[i];
+
+            if (argument == "--iterations" && i + 1 < arguments.size())
+                options.iterations = jmax (1, arguments[++i].getIntValue());
+            else if (argument == "--seconds" && i + 1 < arguments.size())
+                options.decodeSeconds = jmax (0.5, arguments[++i].getDoubleValue());
+            else if (argument == "--output" && i + 1 < arguments.size())
+                options.output = File::getCurrentWorkingDirectory().getChildFile (arguments[++i]);
+            else if (argument.startsWith ("--"))
+                return false;
+            else
+                options.media.add (File::getCurrentWorkingDirectory().getChildFile (argument));
+        }
+
+        return true;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    const ScopedJuceInitialiser_GUI juceInitialiser;
+
+    StringArray arguments;
+    for (int i = 1; i < argc; ++i)
+        arguments.add (argv[i]);
+
+    BenchOptions options;
+
+    if (! parseArguments (arguments, options))
+    {
+        std::cerr << "Usage: juce_libvlc_bench [--iterations N] [--seconds S] [--output file.json] media..." << std::endl;
+        return 1;
+    }
+
+    auto* root = new DynamicObject();
+    root->setProperty ("libvlcVersion", String (libvlc_get_version()));
+    root->setProperty ("os", SystemStats::getOperatingSystemName());
+    root->setProperty ("cpu", SystemStats::getCpuModel());
+    root->setProperty ("numCpus", SystemStats::getNumCpus());
+    root->setProperty ("iterations", options.iterations);
+    root->setProperty ("playerCreation", benchPlayerCreation (options));
+    root->setProperty ("deinterleaveUsPerBlock", benchDeinterleave (options));
+    root->setProperty ("deviceCallbackByChannels", benchDeviceCallbackChannels (options));
+
+    Array<var> mediaResults;
+
+    for (auto& media : options.media)
+    {
+        if (! media.existsAsFile())
+        {
+            std::cerr << "File not found: " << media.getFullPathName() << std::endl;
+            continue;
+        }
+
+        progress ("Benchmarking " + media.getFileName());
+        auto* result = new DynamicObject();
+        result->setProperty ("file", media.getFileName());
+        result->setProperty ("openToFirstFrameMs", benchOpenToFirstFrame (media, options));
+        result->setProperty ("fastSeekMs", benchSeekLatency (media, ISeekableMedia::SeekMode::Fast, options));
+        result->setProperty ("preciseSeekMs", benchSeekLatency (media, ISeekableMedia::SeekMode::Precise, options));
+
+        auto* decode = new DynamicObject();
+        progress ("Sustained decode...");
+        decode->setProperty ("RV32", benchSustainedDecode (media, VLCMediaPlayer::VideoPixelFormat::RGB32, options));
+        decode->setProperty ("I420", benchSustainedDecode (media, VLCMediaPlayer::VideoPixelFormat::I420, options));
+        decode->setProperty ("NV12", benchSustainedDecode (media, VLCMediaPlayer::VideoPixelFormat::NV12, options));
+        decode->setProperty ("offline", benchOfflineDecode (media, options));
+        result->setProperty ("decode", var (decode));
+
+        progress ("Device callback...");
+        result->setProperty ("deviceCallback", benchDeviceCallback (media, options));
+        mediaResults.add (var (result));
+    }
+
+    root->setProperty ("media", mediaResults);
+
+    auto json = JSON::toString (var (root));
+    std::cout << json << std::endl;
+
+    if (options.output != File() && ! options.output.replaceWithText (json))
+    {
+        std::cerr << "Couldn't write " << options.output.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
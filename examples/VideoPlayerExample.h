@@ -90,6 +90,11 @@ public:
         pauseButton.setBounds (buttonArea.removeFromLeft (80));
         buttonArea.removeFromLeft (10);
         stopButton.setBounds (buttonArea.removeFromLeft (80));
+        buttonArea.removeFromLeft (10);
+        statsButton.setBounds (buttonArea.removeFromLeft (80));
+        
+        // Stats overlay in the top left corner of the video
+        statsLabel.setBounds (videoArea.reduced (10).removeFromTop (150).removeFromLeft (320));
         
         controlsArea.removeFromTop (10);
         positionSlider.setBounds (controlsArea.removeFromTop (30));
@@ -124,6 +129,10 @@ private:
         stopButton.setButtonText ("Stop");
         stopButton.addListener (this);
         
+        addAndMakeVisible (statsButton);
+        statsButton.setButtonText ("Stats");
+        statsButton.addListener (this);
+        
         // Position slider
         addAndMakeVisible (positionSlider);
         positionSlider.setRange (0.0, 1.0);
@@ -137,6 +146,14 @@ private:
         addAndMakeVisible (statusLabel);
         statusLabel.setText ("No media loaded", juce::dontSendNotification);
         
+        // Stats overlay, hidden until the Stats button is toggled on
+        addChildComponent (statsLabel);
+        statsLabel.setFont (juce::Font (juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain));
+        statsLabel.setJustificationType (juce::Justification::topLeft);
+        statsLabel.setColour (juce::Label::backgroundColourId, juce::Colours::black.withAlpha (0.6f));
+        statsLabel.setColour (juce::Label::textColourId, juce::Colours::white);
+        statsLabel.setInterceptsMouseClicks (false, false);
+        
         // Set video component for media player
         mediaPlayer->setVideoComponent (&videoComponent);
         
@@ -170,6 +187,11 @@ private:
         {
             mediaPlayer->stop();
         }
+        else if (button == &statsButton)
+        {
+            statsLabel.setVisible (statsButton.getToggleState());
+            updateStatsOverlay();
+        }
     }
     
     // Slider::Listener
@@ -225,6 +247,29 @@ private:
     {
         updateTimeDisplay();
         updatePositionSlider();
+        
+        if (statsLabel.isVisible())
+            updateStatsOverlay();
+    }
+    
+    void updateStatsOverlay()
+    {
+        auto stats = mediaPlayer->getStats();
+        
+        juce::StringArray lines;
+        lines.add ("Frames  decoded " + juce::String (stats.framesDecoded) + "  shown " + juce::String (stats.framesDisplayed)
+                    + "  late " + juce::String (stats.framesLate) + "  dropped " + juce::String (stats.framesDropped));
+        lines.add ("Copy    avg " + juce::String (stats.averageFrameCopyMs, 2) + " ms  max " + juce::String (stats.maxFrameCopyMs, 2) + " ms");
+        lines.add ("Audio   " + juce::String (stats.audioBufferLevel * 1000.0, 0) + " / " + juce::String (stats.audioBufferCapacity * 1000.0, 0)
+                    + " ms  underruns " + juce::String (stats.audioUnderruns));
+        lines.add ("Device  avg " + juce::String (stats.averageAudioCallbackMs, 3) + " ms  max " + juce::String (stats.maxAudioCallbackMs, 3) + " ms");
+        lines.add ("Seek    last " + juce::String (stats.lastSeekLatencyMs, 0) + " ms  avg " + juce::String (stats.averageSeekLatencyMs, 0)
+                    + " ms  max " + juce::String (stats.maxSeekLatencyMs, 0) + " ms");
+        lines.add ("A/V     " + juce::String (stats.avOffsetMs, 1) + " ms");
+        lines.add ("Input   " + juce::String (stats.inputBitrate / 1000.0, 0) + " kb/s  " + juce::String (stats.inputBytesRead / 1024) + " KB read");
+        lines.add ("Demux   corrupted " + juce::String (stats.demuxCorrupted) + "  discontinuities " + juce::String (stats.demuxDiscontinuities));
+        
+        statsLabel.setText (lines.joinIntoString ("\n"), juce::dontSendNotification);
     }
     
     // FileDragAndDropTarget interface
@@ -370,8 +415,9 @@ private:
     // Components
     juce::Component videoComponent;
     juce::TextButton openButton, playButton, pauseButton, stopButton;
+    juce::ToggleButton statsButton;
     juce::Slider positionSlider;
-    juce::Label timeLabel, statusLabel;
+    juce::Label timeLabel, statusLabel, statsLabel;
     
     // Media player and audio
     std::unique_ptr<juce::VLCMediaPlayer> mediaPlayer;
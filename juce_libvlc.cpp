@@ -1,7 +1,20 @@
 #include "juce_libvlc.h"
 
 // Implementation files are included here for the JUCE module system
+#include "juce_media/AudioDeinterleaver.cpp"
+#include "juce_media/FrameCache.cpp"
+#include "juce_media/KeyframeIndex.cpp"
+#include "juce_media/RealtimeChecks.cpp"
+#include "juce_media/ThumbnailExtractor.cpp"
+#include "juce_media/VLCAudioSource.cpp"
+#include "juce_media/VLCInstanceManager.cpp"
 #include "juce_media/VLCMediaPlayer.cpp"
+#include "juce_media/VLCMediaPlayerGroup.cpp"
+#include "juce_media/VLCMediaReader.cpp"
+
+#if JUCE_MODULE_AVAILABLE_juce_opengl
+ #include "juce_media/VLCOpenGLVideoComponent.cpp"
+#endif
 
 // VLC static module stub
 // When linking statically against libVLC, it expects a vlc_static_modules array.
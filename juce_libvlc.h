@@ -31,9 +31,26 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_graphics/juce_graphics.h>
 
+// Module configuration
+#include "juce_libvlc_config.h"
+
 // Module components
 #include "juce_media/ISeekableMedia.h"
+#include "juce_media/AudioDeinterleaver.h"
+#include "juce_media/RealtimeChecks.h"
+#include "juce_media/KeyframeIndex.h"
+#include "juce_media/FrameCache.h"
+#include "juce_media/VLCInstanceManager.h"
+#include "juce_media/ThumbnailExtractor.h"
 #include "juce_media/VLCMediaPlayer.h"
+#include "juce_media/VLCMediaPlayerGroup.h"
+#include "juce_media/VLCMediaReader.h"
+#include "juce_media/VLCAudioSource.h"
+
+// Optional GPU renderer, available when the host project also uses juce_opengl
+#if JUCE_MODULE_AVAILABLE_juce_opengl
+ #include "juce_media/VLCOpenGLVideoComponent.h"
+#endif
 
 /**
  * @file juce_libvlc.h
@@ -48,6 +65,8 @@
  * - Integration with JUCE's audio and video systems
  * - Thread-safe operation with proper callback handling
  * - Support for external playhead synchronization
+ * - Optional OpenGL renderer with YUV to RGB conversion on the GPU
+ * - Shared libVLC instances across players
  * 
  * Usage example:
  * @code
@@ -36,7 +36,14 @@
  #endif
 #endif
 
+// Set to 1 to count allocations, locks and worst-case times in the realtime callbacks.
+// This replaces the global operator new (see RealtimeChecks), so keep it to test builds.
+#ifndef JUCE_LIBVLC_REALTIME_CHECKS
+ #define JUCE_LIBVLC_REALTIME_CHECKS 0
+#endif
+
 // Audio buffer configuration
+// Smallest ring (in samples per channel) for LatencyProfile::Robust; the other profiles size it from the device
 #ifndef JUCE_LIBVLC_AUDIO_BUFFER_SIZE
  #define JUCE_LIBVLC_AUDIO_BUFFER_SIZE 96000  // 2 seconds at 48kHz
 #endif
@@ -45,7 +52,19 @@
  #define JUCE_LIBVLC_DEFAULT_SAMPLE_RATE 44100
 #endif
 
+// Media parsing configuration
+#ifndef JUCE_LIBVLC_PARSE_TIMEOUT_MS
+ #define JUCE_LIBVLC_PARSE_TIMEOUT_MS 5000  // How long open() lets libVLC look for metadata
+#endif
+
+// Seeking configuration
+// Set to 1 to have open() read keyframe tables in the background by default (and cache them next to the media)
+#ifndef JUCE_LIBVLC_KEYFRAME_INDEX
+ #define JUCE_LIBVLC_KEYFRAME_INDEX 0
+#endif
+
 // Video configuration
+// Set to 1 to make new players default to VideoOutputMode::NativeWindow instead of memory callbacks
 #ifndef JUCE_LIBVLC_USE_NATIVE_WINDOW
- #define JUCE_LIBVLC_USE_NATIVE_WINDOW 1
+ #define JUCE_LIBVLC_USE_NATIVE_WINDOW 0
 #endif
@@ -0,0 +1,223 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#include "AudioDeinterleaver.h"
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <emmintrin.h>
+ #if defined (__AVX2__)
+  #include <immintrin.h>
+  #define JUCE_LIBVLC_USE_AVX2 1
+ #endif
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
+
+#ifndef JUCE_LIBVLC_USE_AVX2
+ #define JUCE_LIBVLC_USE_AVX2 0
+#endif
+
+namespace juce
+{
+
+namespace
+{
+#if JUCE_USE_SSE_INTRINSICS || JUCE_USE_ARM_NEON
+    //==============================================================================
+    // The handful of 4-lane operations the kernels below are written in
+   #if JUCE_USE_SSE_INTRINSICS
+    using Vec4 = __m128;
+
+    inline Vec4 load4 (const float* p) noexcept                 { return _mm_loadu_ps (p); }
+    inline void store4 (float* p, Vec4 v) noexcept              { _mm_storeu_ps (p, v); }
+    inline Vec4 evens (Vec4 a, Vec4 b) noexcept                 { return _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0)); }
+    inline Vec4 odds (Vec4 a, Vec4 b) noexcept                  { return _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1)); }
+    inline Vec4 highOfAThenLowOfB (Vec4 a, Vec4 b) noexcept     { return _mm_shuffle_ps (a, b, _MM_SHUFFLE (1, 0, 3, 2)); }
+    inline Vec4 lowOfAThenHighOfB (Vec4 a, Vec4 b) noexcept     { return _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 2, 1, 0)); }
+
+    inline void transpose4 (Vec4& r0, Vec4& r1, Vec4& r2, Vec4& r3) noexcept
+    {
+        _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+    }
+   #else
+    using Vec4 = float32x4_t;
+
+    inline Vec4 load4 (const float* p) noexcept                 { return vld1q_f32 (p); }
+    inline void store4 (float* p, Vec4 v) noexcept              { vst1q_f32 (p, v); }
+    inline Vec4 evens (Vec4 a, Vec4 b) noexcept                 { return vuzpq_f32 (a, b).val[0]; }
+    inline Vec4 odds (Vec4 a, Vec4 b) noexcept                  { return vuzpq_f32 (a, b).val[1]; }
+    inline Vec4 highOfAThenLowOfB (Vec4 a, Vec4 b) noexcept     { return vcombine_f32 (vget_high_f32 (a), vget_low_f32 (b)); }
+    inline Vec4 lowOfAThenHighOfB (Vec4 a, Vec4 b) noexcept     { return vcombine_f32 (vget_low_f32 (a), vget_high_f32 (b)); }
+
+    inline void transpose4 (Vec4& r0, Vec4& r1, Vec4& r2, Vec4& r3) noexcept
+    {
+        auto t01 = vtrnq_f32 (r0, r1);
+        auto t23 = vtrnq_f32 (r2, r3);
+        r0 = vcombine_f32 (vget_low_f32 (t01.val[0]),  vget_low_f32 (t23.val[0]));
+        r1 = vcombine_f32 (vget_low_f32 (t01.val[1]),  vget_low_f32 (t23.val[1]));
+        r2 = vcombine_f32 (vget_high_f32 (t01.val[0]), vget_high_f32 (t23.val[0]));
+        r3 = vcombine_f32 (vget_high_f32 (t01.val[1]), vget_high_f32 (t23.val[1]));
+    }
+   #endif
+
+    //==============================================================================
+    // Each kernel handles whole blocks of four frames and returns how many it did
+    int deinterleaveStereo (const float* source, float* const* dest, int numFrames) noexcept
+    {
+        float* left = dest[0];
+        float* right = dest[1];
+        int i = 0;
+
+       #if JUCE_LIBVLC_USE_AVX2
+        for (; i + 8 <= numFrames; i += 8)
+        {
+            // Lanes come out as [0 1 4 5 | 2 3 6 7], so restore frame order across the halves
+            auto a = _mm256_loadu_ps (source + i * 2);
+            auto b = _mm256_loadu_ps (source + i * 2 + 8);
+            auto l = _mm256_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0));
+            auto r = _mm256_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1));
+            l = _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (l), _MM_SHUFFLE (3, 1, 2, 0)));
+            r = _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (r), _MM_SHUFFLE (3, 1, 2, 0)));
+            _mm256_storeu_ps (left + i, l);
+            _mm256_storeu_ps (right + i, r);
+        }
+       #endif
+
+       #if JUCE_USE_ARM_NEON && ! JUCE_USE_SSE_INTRINSICS
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            auto lr = vld2q_f32 (source + i * 2);
+            vst1q_f32 (left + i, lr.val[0]);
+            vst1q_f32 (right + i, lr.val[1]);
+        }
+       #else
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            auto a = load4 (source + i * 2);
+            auto b = load4 (source + i * 2 + 4);
+            store4 (left + i, evens (a, b));
+            store4 (right + i, odds (a, b));
+        }
+       #endif
+
+        return i;
+    }
+
+    int deinterleave5point1 (const float* source, float* const* dest, int numFrames) noexcept
+    {
+        int i = 0;
+
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            // Four 6-channel frames are six vectors; frames 1 and 3 straddle a vector boundary
+            const float* s = source + i * 6;
+            auto v0 = load4 (s);
+            auto v1 = load4 (s + 4);
+            auto v2 = load4 (s + 8);
+            auto v3 = load4 (s + 12);
+            auto v4 = load4 (s + 16);
+            auto v5 = load4 (s + 20);
+
+            auto c0 = v0;
+            auto c1 = highOfAThenLowOfB (v1, v2);
+            auto c2 = v3;
+            auto c3 = highOfAThenLowOfB (v4, v5);
+            transpose4 (c0, c1, c2, c3);
+
+            store4 (dest[0] + i, c0);
+            store4 (dest[1] + i, c1);
+            store4 (dest[2] + i, c2);
+            store4 (dest[3] + i, c3);
+
+            auto t0 = lowOfAThenHighOfB (v1, v2);
+            auto t1 = lowOfAThenHighOfB (v4, v5);
+            store4 (dest[4] + i, evens (t0, t1));
+            store4 (dest[5] + i, odds (t0, t1));
+        }
+
+        return i;
+    }
+
+    template <int numChannels>
+    int deinterleaveQuads (const float* source, float* const* dest, int numFrames) noexcept
+    {
+        static_assert (numChannels % 4 == 0, "Quad kernel needs a multiple of four channels");
+        int i = 0;
+
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            const float* s = source + i * numChannels;
+
+            // Transpose each 4x4 block of frames x channels
+            for (int group = 0; group < numChannels; group += 4)
+            {
+                auto r0 = load4 (s + group);
+                auto r1 = load4 (s + numChannels + group);
+                auto r2 = load4 (s + numChannels * 2 + group);
+                auto r3 = load4 (s + numChannels * 3 + group);
+                transpose4 (r0, r1, r2, r3);
+
+                store4 (dest[group] + i, r0);
+                store4 (dest[group + 1] + i, r1);
+                store4 (dest[group + 2] + i, r2);
+                store4 (dest[group + 3] + i, r3);
+            }
+        }
+
+        return i;
+    }
+#endif
+}
+
+//==============================================================================
+void AudioDeinterleaver::deinterleave (const float* source, float* const* dest, int numChannels, int numFrames) noexcept
+{
+    if (source == nullptr || numChannels <= 0 || numFrames <= 0)
+        return;
+
+    int done = 0;
+
+   #if JUCE_USE_SSE_INTRINSICS || JUCE_USE_ARM_NEON
+    switch (numChannels)
+    {
+        case 2:     done = deinterleaveStereo (source, dest, numFrames); break;
+        case 6:     done = deinterleave5point1 (source, dest, numFrames); break;
+        case 8:     done = deinterleaveQuads<8> (source, dest, numFrames); break;
+        case 16:    done = deinterleaveQuads<16> (source, dest, numFrames); break;
+        default:    break;
+    }
+   #endif
+
+    if (done < numFrames)
+    {
+        float* remaining[maxChannels];
+        int channelsToWrite = jmin (numChannels, (int) maxChannels);
+
+        for (int channel = 0; channel < channelsToWrite; ++channel)
+            remaining[channel] = dest[channel] + done;
+
+        deinterleaveScalar (source + done * numChannels, remaining, numChannels, numFrames - done);
+    }
+}
+
+void AudioDeinterleaver::deinterleaveScalar (const float* source, float* const* dest, int numChannels, int numFrames) noexcept
+{
+    // Channel-major so each destination is written sequentially
+    for (int channel = 0; channel < jmin (numChannels, (int) maxChannels); ++channel)
+    {
+        float* d = dest[channel];
+        const float* s = source + channel;
+
+        for (int i = 0; i < numFrames; ++i)
+            d[i] = s[i * numChannels];
+    }
+}
+
+} // namespace juce
@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace juce
+{
+
+/**
+ * Converts interleaved 32-bit float PCM, as delivered by libVLC, into planar
+ * channel buffers. The common 2, 6, 8 and 16 channel layouts use SSE/AVX2 or
+ * NEON kernels when available; every other channel count uses a scalar loop.
+ */
+struct AudioDeinterleaver
+{
+    /** Largest channel count the player will negotiate with libVLC (3rd order ambisonics). */
+    static constexpr int maxChannels = 16;
+
+    /**
+     * Deinterleaves numFrames frames of numChannels channels.
+     * @param source Interleaved samples, numChannels * numFrames floats
+     * @param dest One pointer per channel, each with room for numFrames floats
+     */
+    static void deinterleave (const float* source, float* const* dest, int numChannels, int numFrames) noexcept;
+
+    /** The plain per-sample version, used for uncommon layouts and leftover frames. */
+    static void deinterleaveScalar (const float* source, float* const* dest, int numChannels, int numFrames) noexcept;
+};
+
+} // namespace juce
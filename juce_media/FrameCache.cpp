@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#include "FrameCache.h"
+#include <limits>
+
+namespace juce
+{
+
+//==============================================================================
+FrameCache::FrameCache (size_t maxBytesToUse)
+    : maxBytes (maxBytesToUse)
+{
+}
+
+void FrameCache::setMaxBytes (size_t maxBytesToUse)
+{
+    const ScopedLock sl (lock);
+    maxBytes = maxBytesToUse;
+    evictToFit();
+}
+
+size_t FrameCache::getMaxBytes() const
+{
+    const ScopedLock sl (lock);
+    return maxBytes;
+}
+
+size_t FrameCache::getNumBytes() const
+{
+    const ScopedLock sl (lock);
+    return numBytes;
+}
+
+int FrameCache::getNumFrames() const
+{
+    const ScopedLock sl (lock);
+    return static_cast<int>(index.size());
+}
+
+void FrameCache::setCompressionQuality (float quality)
+{
+    const ScopedLock sl (lock);
+    compressionQuality = jlimit (0.0f, 1.0f, quality);
+}
+
+float FrameCache::getCompressionQuality() const
+{
+    const ScopedLock sl (lock);
+    return compressionQuality;
+}
+
+//==============================================================================
+void FrameCache::add (uint64 mediaId, int64 timeUs, const Image& frame)
+{
+    if (! frame.isValid())
+        return;
+
+    Key key (mediaId, timeUs);
+    Entry entry { key, frame, {}, getNumBytesFor (frame) };
+
+    // Compressed outside the lock, as it takes a while
+    if (auto quality = getCompressionQuality(); quality > 0.0f)
+    {
+        JPEGImageFormat jpeg;
+        jpeg.setQuality (quality);
+
+        MemoryOutputStream stream (entry.compressed, false);
+
+        if (jpeg.writeImageToStream (frame, stream))
+        {
+            stream.flush();
+            entry.frame = {};
+            entry.numBytes = entry.compressed.getSize();
+        }
+        else
+        {
+            entry.compressed.reset();
+        }
+    }
+
+    auto size = entry.numBytes;
+
+    const ScopedLock sl (lock);
+
+    auto existing = index.find (key);
+    if (existing != index.end())
+        erase (existing);
+
+    // A frame bigger than the whole budget would only evict everything else
+    if (size > maxBytes)
+        return;
+
+    entries.push_front (std::move (entry));
+    index[key] = entries.begin();
+    numBytes += size;
+
+    evictToFit();
+}
+
+Image FrameCache::get (uint64 mediaId, int64 timeUs) const
+{
+    Entry found;
+
+    {
+        const ScopedLock sl (lock);
+
+        auto it = index.find (Key (mediaId, timeUs));
+        if (it == index.end())
+            return {};
+
+        found = touch (it);
+    }
+
+    return found.frame.isValid() ? found.frame : decompress (found.compressed);
+}
+
+Image FrameCache::getAtOrBefore (uint64 mediaId, int64 timeUs, int64 maxDistanceUs, int64* frameTimeUs) const
+{
+    Entry found;
+
+    {
+        const ScopedLock sl (lock);
+
+        // The first key after the time, then one back
+        auto it = index.upper_bound (Key (mediaId, timeUs));
+
+        if (it == index.begin())
+            return {};
+
+        --it;
+
+        if (it->first.first != mediaId || timeUs - it->first.second > maxDistanceUs)
+            return {};
+
+        if (frameTimeUs != nullptr)
+            *frameTimeUs = it->first.second;
+
+        found = touch (it);
+    }
+
+    return found.frame.isValid() ? found.frame : decompress (found.compressed);
+}
+
+void FrameCache::remove (uint64 mediaId)
+{
+    const ScopedLock sl (lock);
+
+    auto it = index.lower_bound (Key (mediaId, std::numeric_limits<int64>::min()));
+
+    while (it != index.end() && it->first.first == mediaId)
+        erase (it++);
+}
+
+void FrameCache::clear()
+{
+    const ScopedLock sl (lock);
+
+    entries.clear();
+    index.clear();
+    numBytes = 0;
+}
+
+//==============================================================================
+size_t FrameCache::getNumBytesFor (const Image& frame) noexcept
+{
+    auto bytesPerPixel = frame.getFormat() == Image::SingleChannel ? 1 : (frame.getFormat() == Image::RGB ? 3 : 4);
+    return static_cast<size_t>(frame.getWidth()) * static_cast<size_t>(frame.getHeight()) * static_cast<size_t>(bytesPerPixel);
+}
+
+Image FrameCache::decompress (const MemoryBlock& data)
+{
+    if (data.isEmpty())
+        return {};
+
+    JPEGImageFormat jpeg;
+    MemoryInputStream stream (data, false);
+    return jpeg.decodeImage (stream);
+}
+
+FrameCache::Entry FrameCache::touch (std::map<Key, std::list<Entry>::iterator>::const_iterator it) const
+{
+    // Moving the node keeps every iterator in the index valid
+    entries.splice (entries.begin(), entries, it->second);
+    return *it->second;
+}
+
+void FrameCache::erase (std::map<Key, std::list<Entry>::iterator>::iterator it)
+{
+    numBytes -= it->second->numBytes;
+    entries.erase (it->second);
+    index.erase (it);
+}
+
+void FrameCache::evictToFit()
+{
+    while (numBytes > maxBytes && ! entries.empty())
+        erase (index.find (entries.back().key));
+}
+
+} // namespace juce
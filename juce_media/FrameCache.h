@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_graphics/juce_graphics.h>
+#include <list>
+#include <map>
+
+namespace juce
+{
+
+/**
+ * A least-recently-used cache of decoded video frames, limited by the memory
+ * its images use. Frames are keyed by a media id chosen by the caller and a
+ * time in microseconds. They can optionally be stored JPEG-compressed, which
+ * fits several times more frames into the budget at the cost of a decode on
+ * each lookup. Thread safe.
+ */
+class FrameCache
+{
+public:
+    //==============================================================================
+    explicit FrameCache (size_t maxBytesToUse);
+
+    /** Sets how much image memory the cache may hold, evicting frames to fit. */
+    void setMaxBytes (size_t maxBytesToUse);
+    size_t getMaxBytes() const;
+
+    /** Returns how much image memory the cached frames use. */
+    size_t getNumBytes() const;
+
+    /** Returns the number of cached frames. */
+    int getNumFrames() const;
+
+    /**
+     * Sets the JPEG quality (0 to 1) frames added from now on are compressed with,
+     * or 0 to store them uncompressed (the default). Alpha isn't kept.
+     */
+    void setCompressionQuality (float quality);
+    float getCompressionQuality() const;
+
+    //==============================================================================
+    /**
+     * Stores a frame, replacing any with the same key. The image shouldn't be
+     * shared with anything that goes on writing to it.
+     */
+    void add (uint64 mediaId, int64 timeUs, const Image& frame);
+
+    /** Returns the frame stored for exactly this time, or an invalid image. */
+    Image get (uint64 mediaId, int64 timeUs) const;
+
+    /**
+     * Returns the latest frame at or before a time, as long as it's no more than
+     * maxDistanceUs earlier. Useful when frames are keyed by presentation time.
+     * @param frameTimeUs set to the found frame's time, if not nullptr
+     */
+    Image getAtOrBefore (uint64 mediaId, int64 timeUs, int64 maxDistanceUs, int64* frameTimeUs = nullptr) const;
+
+    /** Drops every frame of one media. */
+    void remove (uint64 mediaId);
+
+    /** Drops every frame. */
+    void clear();
+
+private:
+    //==============================================================================
+    using Key = std::pair<uint64, int64>;
+
+    struct Entry
+    {
+        Key key;
+        Image frame;                // Invalid when the frame is compressed...
+        MemoryBlock compressed;     // ...into this instead
+        size_t numBytes = 0;
+    };
+
+    static size_t getNumBytesFor (const Image& frame) noexcept;
+    static Image decompress (const MemoryBlock& data);
+    Entry touch (std::map<Key, std::list<Entry>::iterator>::const_iterator it) const;
+    void erase (std::map<Key, std::list<Entry>::iterator>::iterator it);
+    void evictToFit();
+
+    // Most recently used at the front; both guarded by lock
+    mutable std::list<Entry> entries;
+    std::map<Key, std::list<Entry>::iterator> index;
+    size_t maxBytes = 0;
+    size_t numBytes = 0;
+    float compressionQuality = 0.0f;
+    CriticalSection lock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameCache)
+};
+
+} // namespace juce
@@ -28,6 +28,8 @@ struct ISeekableMedia
     
     /**
      * Opens a media file for playback.
+     * Implementations may load metadata in the background, in which case duration
+     * and stream information only become valid once Listener::mediaReady is called.
      * @param media The file to open
      * @param error Optional pointer to receive error messages
      * @return true if the file was opened successfully
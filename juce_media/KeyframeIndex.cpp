@@ -0,0 +1,504 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#include "KeyframeIndex.h"
+
+#include <algorithm>
+
+namespace juce
+{
+
+namespace
+{
+    //==============================================================================
+    constexpr uint32 makeBoxType (const char (&name)[5]) noexcept
+    {
+        return (static_cast<uint32>(static_cast<uint8>(name[0])) << 24)
+             | (static_cast<uint32>(static_cast<uint8>(name[1])) << 16)
+             | (static_cast<uint32>(static_cast<uint8>(name[2])) << 8)
+             |  static_cast<uint32>(static_cast<uint8>(name[3]));
+    }
+
+    constexpr int cacheMagic = 0x49464b56;              // "VKFI"
+    constexpr int cacheVersion = 2;                  // 2: edit lists are applied
+    constexpr uint64 maxMovieBoxSize = 256 * 1024 * 1024;
+
+    struct ByteRange
+    {
+        size_t start = 0, end = 0;
+
+        bool isEmpty() const noexcept                   { return end <= start; }
+        size_t getLength() const noexcept               { return end - start; }
+    };
+
+    /** Calls visitor (type, payload) for each box in a range, stopping when it returns false. */
+    template <typename Visitor>
+    void forEachBox (const uint8* data, ByteRange range, Visitor&& visitor)
+    {
+        auto position = range.start;
+
+        while (position + 8 <= range.end)
+        {
+            uint64 size = ByteOrder::bigEndianInt (data + position);
+            auto type = ByteOrder::bigEndianInt (data + position + 4);
+            size_t headerSize = 8;
+
+            if (size == 1)
+            {
+                if (position + 16 > range.end)
+                    return;
+
+                size = ByteOrder::bigEndianInt64 (data + position + 8);
+                headerSize = 16;
+            }
+            else if (size == 0)
+            {
+                size = range.end - position;
+            }
+
+            if (size < headerSize || size > range.end - position)
+                return;
+
+            if (! visitor (type, ByteRange { position + headerSize, position + static_cast<size_t>(size) }))
+                return;
+
+            position += static_cast<size_t>(size);
+        }
+    }
+
+    /** The sample tables of one track, as ranges into the moov payload. */
+    struct TrackTables
+    {
+        uint32 handlerType = 0;
+        uint32 timescale = 0;
+        ByteRange timeToSample, syncSamples, compositionOffsets, editList;
+    };
+
+    /** Reads the timescale from an mvhd or mdhd payload, or returns 0. */
+    uint32 readHeaderTimescale (const uint8* data, ByteRange payload) noexcept
+    {
+        if (payload.getLength() < 16)
+            return 0;
+
+        // Version 1 has 64-bit creation and modification times before the timescale
+        bool isVersion1 = data[payload.start] == 1;
+        auto timescaleOffset = payload.start + (isVersion1 ? 20 : 12);
+
+        return timescaleOffset + 4 <= payload.end ? ByteOrder::bigEndianInt (data + timescaleOffset) : 0;
+    }
+
+    void findTrackTables (const uint8* data, ByteRange range, TrackTables& tables)
+    {
+        forEachBox (data, range, [&] (uint32 type, ByteRange payload)
+        {
+            if (type == makeBoxType ("mdia") || type == makeBoxType ("minf") || type == makeBoxType ("stbl")
+                 || type == makeBoxType ("edts"))
+            {
+                findTrackTables (data, payload, tables);
+            }
+            else if (type == makeBoxType ("mdhd") && payload.getLength() >= 24)
+            {
+                tables.timescale = readHeaderTimescale (data, payload);
+            }
+            else if (type == makeBoxType ("elst"))
+            {
+                tables.editList = payload;
+            }
+            else if (type == makeBoxType ("hdlr") && payload.getLength() >= 12)
+            {
+                tables.handlerType = ByteOrder::bigEndianInt (data + payload.start + 8);
+            }
+            else if (type == makeBoxType ("stts"))
+            {
+                tables.timeToSample = payload;
+            }
+            else if (type == makeBoxType ("stss"))
+            {
+                tables.syncSamples = payload;
+            }
+            else if (type == makeBoxType ("ctts"))
+            {
+                tables.compositionOffsets = payload;
+            }
+
+            return true;
+        });
+    }
+
+    /** Returns the number of 'entrySize'-byte entries a full box table really holds. */
+    uint32 getNumTableEntries (const uint8* data, ByteRange table, size_t entrySize) noexcept
+    {
+        if (table.getLength() < 8)
+            return 0;
+
+        auto declared = ByteOrder::bigEndianInt (data + table.start + 4);
+        auto available = (table.getLength() - 8) / entrySize;
+        return static_cast<uint32>(jmin (static_cast<size_t>(declared), available));
+    }
+
+    /**
+     * Works out how far an edit list shifts media time to presentation time, in seconds.
+     * Leading empty edits (media time -1) delay the start, in the movie's timescale, and
+     * the first real edit starts part-way into the media, in the track's. Returns false
+     * for lists that don't reduce to one offset, e.g. several real edits.
+     */
+    bool getEditListOffset (const uint8* data, ByteRange editList, uint32 movieTimescale,
+                            uint32 mediaTimescale, double& offsetInSeconds) noexcept
+    {
+        offsetInSeconds = 0.0;
+
+        if (editList.getLength() < 8)
+            return true;
+
+        bool isVersion1 = data[editList.start] == 1;
+        size_t entrySize = isVersion1 ? 20 : 12;
+        auto numEdits = getNumTableEntries (data, editList, entrySize);
+
+        int64 emptyDuration = 0;
+        bool hasMediaEdit = false;
+
+        for (uint32 i = 0; i < numEdits; ++i)
+        {
+            auto* entry = data + editList.start + 8 + i * entrySize;
+            auto duration = isVersion1 ? static_cast<int64>(ByteOrder::bigEndianInt64 (entry))
+                                       : static_cast<int64>(ByteOrder::bigEndianInt (entry));
+            auto mediaTime = isVersion1 ? static_cast<int64>(ByteOrder::bigEndianInt64 (entry + 8))
+                                        : static_cast<int64>(static_cast<int32>(ByteOrder::bigEndianInt (entry + 4)));
+
+            // Anything after the first real edit makes the mapping non-linear
+            if (hasMediaEdit)
+                return false;
+
+            if (mediaTime == -1)
+            {
+                emptyDuration += duration;
+                continue;
+            }
+
+            hasMediaEdit = true;
+            offsetInSeconds = -static_cast<double>(mediaTime) / static_cast<double>(mediaTimescale);
+        }
+
+        if (emptyDuration > 0)
+        {
+            if (movieTimescale == 0)
+                return false;
+
+            offsetInSeconds += static_cast<double>(emptyDuration) / static_cast<double>(movieTimescale);
+        }
+
+        return true;
+    }
+
+    /** Walks a table of (count, value) runs, as used by stts and ctts. */
+    struct RunCursor
+    {
+        RunCursor (const uint8* d, ByteRange t) : data (d), table (t), numRuns (getNumTableEntries (d, t, 8)) {}
+
+        /** Moves to the run containing a 1-based sample number; returns false past the end. */
+        bool seekToSample (uint32 sampleNumber) noexcept
+        {
+            while (run < numRuns)
+            {
+                auto count = getRunCount();
+
+                if (sampleNumber < firstSampleOfRun + count)
+                    return true;
+
+                accumulated += static_cast<int64>(count) * static_cast<int64>(getRunValue());
+                firstSampleOfRun += count;
+                ++run;
+            }
+
+            return false;
+        }
+
+        /** For stts: the decode time of the sample seekToSample() found. */
+        int64 getDecodeTime (uint32 sampleNumber) const noexcept
+        {
+            return accumulated + static_cast<int64>(sampleNumber - firstSampleOfRun) * static_cast<int64>(getRunValue());
+        }
+
+        uint32 getRunCount() const noexcept         { return ByteOrder::bigEndianInt (data + table.start + 8 + run * 8); }
+        uint32 getRunValue() const noexcept         { return ByteOrder::bigEndianInt (data + table.start + 12 + run * 8); }
+
+        const uint8* data;
+        ByteRange table;
+        uint32 numRuns, run = 0;
+        uint32 firstSampleOfRun = 1;
+        int64 accumulated = 0;
+    };
+}
+
+//==============================================================================
+std::unique_ptr<KeyframeIndex> KeyframeIndex::loadOrBuild (const File& media, ShouldExitFunction shouldExit)
+{
+    auto cacheFile = getCacheFileFor (media);
+
+    std::unique_ptr<KeyframeIndex> index (new KeyframeIndex());
+    if (index->readFromCache (cacheFile, media))
+        return index;
+
+    index = build (media, shouldExit);
+
+    if (index != nullptr && ! index->writeToCache (cacheFile, media))
+        DBG ("KeyframeIndex::loadOrBuild - Couldn't write " + cacheFile.getFullPathName());
+
+    return index;
+}
+
+std::unique_ptr<KeyframeIndex> KeyframeIndex::build (const File& media, ShouldExitFunction shouldExit)
+{
+    FileInputStream input (media);
+    if (input.failedToOpen())
+        return nullptr;
+
+    // Find the movie box among the top-level boxes; it may come after the media data
+    MemoryBlock movieBox;
+    auto fileSize = input.getTotalLength();
+    int64 position = 0;
+
+    while (position + 8 <= fileSize)
+    {
+        if (shouldExit != nullptr && shouldExit())
+            return nullptr;
+
+        uint8 header[16];
+        input.setPosition (position);
+
+        if (input.read (header, 8) != 8)
+            break;
+
+        uint64 size = ByteOrder::bigEndianInt (header);
+        auto type = ByteOrder::bigEndianInt (header + 4);
+        int headerSize = 8;
+
+        if (size == 1)
+        {
+            if (input.read (header + 8, 8) != 8)
+                break;
+
+            size = ByteOrder::bigEndianInt64 (header + 8);
+            headerSize = 16;
+        }
+        else if (size == 0)
+        {
+            size = static_cast<uint64>(fileSize - position);
+        }
+
+        if (size < static_cast<uint64>(headerSize))
+            break;
+
+        if (type == makeBoxType ("moov"))
+        {
+            auto payloadSize = size - static_cast<uint64>(headerSize);
+
+            if (payloadSize > maxMovieBoxSize)
+                break;
+
+            movieBox.setSize (static_cast<size_t>(payloadSize));
+
+            if (input.read (movieBox.getData(), static_cast<int>(payloadSize)) != static_cast<int>(payloadSize))
+                movieBox.reset();
+
+            break;
+        }
+
+        position += static_cast<int64>(size);
+    }
+
+    if (movieBox.isEmpty())
+        return nullptr;
+
+    // Use the first video track with a time-to-sample table
+    auto* data = static_cast<const uint8*>(movieBox.getData());
+    TrackTables video;
+    uint32 movieTimescale = 0;
+
+    // The movie's timescale, which empty edits are measured in
+    forEachBox (data, ByteRange { 0, movieBox.getSize() }, [&] (uint32 type, ByteRange payload)
+    {
+        if (type != makeBoxType ("mvhd"))
+            return true;
+
+        movieTimescale = readHeaderTimescale (data, payload);
+        return false;
+    });
+
+    forEachBox (data, ByteRange { 0, movieBox.getSize() }, [&] (uint32 type, ByteRange payload)
+    {
+        if (type != makeBoxType ("trak"))
+            return true;
+
+        TrackTables tables;
+        findTrackTables (data, payload, tables);
+
+        if (tables.handlerType == makeBoxType ("vide") && tables.timescale > 0 && ! tables.timeToSample.isEmpty())
+        {
+            video = tables;
+            return false;
+        }
+
+        return true;
+    });
+
+    if (video.timescale == 0)
+        return nullptr;
+
+    std::unique_ptr<KeyframeIndex> index (new KeyframeIndex());
+
+    // Without a sync sample table every sample is a sync sample
+    if (video.syncSamples.isEmpty())
+    {
+        index->everyFrameIsKeyframe = true;
+        return index;
+    }
+
+    // Keyframe times are reported on the presentation timeline, which is what players seek on.
+    // An edit list too complex to map onto it gets no index rather than a wrong one.
+    double editOffset = 0.0;
+
+    if (! getEditListOffset (data, video.editList, movieTimescale, video.timescale, editOffset))
+        return nullptr;
+
+    RunCursor decodeTimes (data, video.timeToSample);
+    RunCursor compositionOffsets (data, video.compositionOffsets);
+
+    auto numSyncSamples = getNumTableEntries (data, video.syncSamples, 4);
+    index->keyframeTimes.reserve (numSyncSamples);
+
+    for (uint32 i = 0; i < numSyncSamples; ++i)
+    {
+        if ((i & 1023) == 0 && shouldExit != nullptr && shouldExit())
+            return nullptr;
+
+        auto sampleNumber = ByteOrder::bigEndianInt (data + video.syncSamples.start + 8 + i * 4);
+
+        if (sampleNumber == 0 || ! decodeTimes.seekToSample (sampleNumber))
+            break;
+
+        auto time = decodeTimes.getDecodeTime (sampleNumber);
+
+        // Presentation time is the decode time plus the composition offset (signed in practice)
+        if (compositionOffsets.seekToSample (sampleNumber))
+            time += static_cast<int32>(compositionOffsets.getRunValue());
+
+        index->keyframeTimes.push_back (static_cast<double>(time) / static_cast<double>(video.timescale) + editOffset);
+    }
+
+    if (index->keyframeTimes.empty())
+        return nullptr;
+
+    std::sort (index->keyframeTimes.begin(), index->keyframeTimes.end());
+    return index;
+}
+
+File KeyframeIndex::getCacheFileFor (const File& media)
+{
+    auto folder = media.getParentDirectory();
+
+    if (folder.hasWriteAccess())
+        return folder.getChildFile ("." + media.getFileName() + ".keyframes");
+
+    return File::getSpecialLocation (File::tempDirectory)
+               .getChildFile ("juce_libvlc")
+               .getChildFile (String::toHexString (media.getFullPathName().hashCode64()) + ".keyframes");
+}
+
+//==============================================================================
+double KeyframeIndex::getKeyframeAtOrBefore (double timeInSeconds) const noexcept
+{
+    if (everyFrameIsKeyframe || keyframeTimes.empty())
+        return timeInSeconds;
+
+    auto next = std::upper_bound (keyframeTimes.begin(), keyframeTimes.end(), timeInSeconds);
+    return next == keyframeTimes.begin() ? keyframeTimes.front() : *(next - 1);
+}
+
+double KeyframeIndex::getNearestKeyframe (double timeInSeconds) const noexcept
+{
+    if (everyFrameIsKeyframe || keyframeTimes.empty())
+        return timeInSeconds;
+
+    auto next = std::lower_bound (keyframeTimes.begin(), keyframeTimes.end(), timeInSeconds);
+
+    if (next == keyframeTimes.end())
+        return keyframeTimes.back();
+
+    if (next == keyframeTimes.begin())
+        return *next;
+
+    auto previous = *(next - 1);
+    return (timeInSeconds - previous) <= (*next - timeInSeconds) ? previous : *next;
+}
+
+double KeyframeIndex::getDecodeDistance (double timeInSeconds) const noexcept
+{
+    return jmax (0.0, timeInSeconds - getKeyframeAtOrBefore (timeInSeconds));
+}
+
+//==============================================================================
+bool KeyframeIndex::readFromCache (const File& cacheFile, const File& media)
+{
+    FileInputStream input (cacheFile);
+    if (input.failedToOpen())
+        return false;
+
+    // The cache is only valid for the exact file it was built from
+    if (input.readInt() != cacheMagic
+         || input.readInt() != cacheVersion
+         || input.readInt64() != media.getSize()
+         || input.readInt64() != media.getLastModificationTime().toMilliseconds())
+        return false;
+
+    everyFrameIsKeyframe = input.readBool();
+    auto numKeyframes = input.readInt();
+
+    if (numKeyframes < 0 || input.getNumBytesRemaining() < static_cast<int64>(numKeyframes) * 8)
+        return false;
+
+    keyframeTimes.resize (static_cast<size_t>(numKeyframes));
+
+    for (auto& time : keyframeTimes)
+        time = input.readDouble();
+
+    return everyFrameIsKeyframe || ! keyframeTimes.empty();
+}
+
+bool KeyframeIndex::writeToCache (const File& cacheFile, const File& media) const
+{
+    if (! cacheFile.getParentDirectory().createDirectory())
+        return false;
+
+    TemporaryFile temp (cacheFile);
+
+    {
+        FileOutputStream output (temp.getFile());
+        if (output.failedToOpen())
+            return false;
+
+        output.writeInt (cacheMagic);
+        output.writeInt (cacheVersion);
+        output.writeInt64 (media.getSize());
+        output.writeInt64 (media.getLastModificationTime().toMilliseconds());
+        output.writeBool (everyFrameIsKeyframe);
+        output.writeInt (static_cast<int>(keyframeTimes.size()));
+
+        for (auto time : keyframeTimes)
+            output.writeDouble (time);
+
+        output.flush();
+
+        if (output.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+} // namespace juce
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace juce
+{
+
+/**
+ * Keyframe (sync sample) timestamps of a media file's video track. Fast seeks
+ * snap to these so the decoder starts on a GOP boundary, and the distance back
+ * to the previous keyframe tells how much a Precise seek has to decode.
+ *
+ * The index is read from the container's sample tables, which currently means
+ * MP4/MOV (ISO base media) files with a non-fragmented moov box. Times are on
+ * the presentation timeline, after the track's edit list; files whose edit list
+ * is more than an initial delay and start offset get no index. It's cached in
+ * a small sidecar file next to the media, or in the temp directory when that
+ * folder isn't writable.
+ */
+class KeyframeIndex
+{
+public:
+    //==============================================================================
+    /** Returns true when the predicate asks the build to stop early. */
+    using ShouldExitFunction = std::function<bool()>;
+
+    /**
+     * Loads a cached index for the file or builds one by parsing it. Blocks while
+     * reading, so call it from a background thread.
+     * @return the index, or nullptr if the file has no readable keyframe table
+     */
+    static std::unique_ptr<KeyframeIndex> loadOrBuild (const File& media,
+                                                       ShouldExitFunction shouldExit = nullptr);
+
+    /** Parses the file without touching the cache. */
+    static std::unique_ptr<KeyframeIndex> build (const File& media, ShouldExitFunction shouldExit = nullptr);
+
+    /** Returns the sidecar file the index for a media file is cached in. */
+    static File getCacheFileFor (const File& media);
+
+    //==============================================================================
+    /** Returns the number of keyframes, or 0 if every frame is a keyframe. */
+    int getNumKeyframes() const noexcept                     { return static_cast<int>(keyframeTimes.size()); }
+
+    /** Returns true for intra-only video, where any frame can be seeked to directly. */
+    bool isEveryFrameAKeyframe() const noexcept              { return everyFrameIsKeyframe; }
+
+    /** Returns the keyframe at or before a time, in seconds. */
+    double getKeyframeAtOrBefore (double timeInSeconds) const noexcept;
+
+    /** Returns the keyframe closest to a time, in seconds. */
+    double getNearestKeyframe (double timeInSeconds) const noexcept;
+
+    /**
+     * Returns how many seconds of video have to be decoded to land exactly on a
+     * time, i.e. the distance back to the keyframe before it.
+     */
+    double getDecodeDistance (double timeInSeconds) const noexcept;
+
+private:
+    //==============================================================================
+    KeyframeIndex() = default;
+
+    bool readFromCache (const File& cacheFile, const File& media);
+    bool writeToCache (const File& cacheFile, const File& media) const;
+
+    std::vector<double> keyframeTimes;      // Ascending, in seconds
+    bool everyFrameIsKeyframe = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KeyframeIndex)
+};
+
+} // namespace juce
@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#include "RealtimeChecks.h"
+
+#if JUCE_LIBVLC_REALTIME_CHECKS
+ #include <cstdlib>
+ #include <new>
+#endif
+
+namespace juce
+{
+
+#if JUCE_LIBVLC_REALTIME_CHECKS
+namespace
+{
+    struct Counters
+    {
+        std::atomic<int64> numCalls { 0 };
+        std::atomic<int64> numAllocations { 0 };
+        std::atomic<int64> numLocks { 0 };
+        std::atomic<int64> worstTicks { 0 };
+    };
+
+    Counters counters[RealtimeChecks::numCallbacks];
+
+    // The callback this thread is inside, if any
+    thread_local RealtimeChecks::Callback* currentCallback = nullptr;
+
+    const char* getCallbackName (RealtimeChecks::Callback callback) noexcept
+    {
+        switch (callback)
+        {
+            case RealtimeChecks::audioDevice:   return "audio device";
+            case RealtimeChecks::audioPlay:     return "audio play";
+            case RealtimeChecks::audioFlush:    return "audio flush";
+            case RealtimeChecks::videoLock:     return "video lock";
+            case RealtimeChecks::videoDisplay:  return "video display";
+            case RealtimeChecks::numCallbacks:
+            default:                            return "unknown";
+        }
+    }
+}
+
+//==============================================================================
+RealtimeChecks::ScopedCallback::ScopedCallback (Callback callbackToMeasure) noexcept
+    : callback (callbackToMeasure),
+      previous (currentCallback),
+      startTicks (Time::getHighResolutionTicks())
+{
+    currentCallback = &callback;
+}
+
+RealtimeChecks::ScopedCallback::~ScopedCallback() noexcept
+{
+    auto elapsed = Time::getHighResolutionTicks() - startTicks;
+    auto& counter = counters[callback];
+
+    counter.numCalls.fetch_add (1, std::memory_order_relaxed);
+
+    auto worst = counter.worstTicks.load (std::memory_order_relaxed);
+    while (elapsed > worst && ! counter.worstTicks.compare_exchange_weak (worst, elapsed, std::memory_order_relaxed)) {}
+
+    currentCallback = previous;
+}
+
+void RealtimeChecks::noteLock() noexcept
+{
+    if (auto* callback = currentCallback)
+        counters[*callback].numLocks.fetch_add (1, std::memory_order_relaxed);
+}
+
+void RealtimeChecks::noteAllocation() noexcept
+{
+    if (auto* callback = currentCallback)
+        counters[*callback].numAllocations.fetch_add (1, std::memory_order_relaxed);
+}
+
+RealtimeChecks::Report RealtimeChecks::getReport (Callback callback) noexcept
+{
+    Report report;
+
+    if (callback >= 0 && callback < numCallbacks)
+    {
+        auto& counter = counters[callback];
+        report.numCalls = counter.numCalls.load();
+        report.numAllocations = counter.numAllocations.load();
+        report.numLocks = counter.numLocks.load();
+        report.worstMilliseconds = Time::highResolutionTicksToSeconds (counter.worstTicks.load()) * 1000.0;
+    }
+
+    return report;
+}
+
+String RealtimeChecks::getSummary()
+{
+    String summary;
+
+    for (int i = 0; i < numCallbacks; ++i)
+    {
+        auto callback = static_cast<Callback>(i);
+        auto report = getReport (callback);
+
+        summary << getCallbackName (callback) << ": " << report.numCalls << " calls, "
+                << report.numAllocations << " allocations, " << report.numLocks << " locks, worst "
+                << String (report.worstMilliseconds, 3) << " ms" << newLine;
+    }
+
+    return summary;
+}
+
+void RealtimeChecks::reset() noexcept
+{
+    for (auto& counter : counters)
+    {
+        counter.numCalls = 0;
+        counter.numAllocations = 0;
+        counter.numLocks = 0;
+        counter.worstTicks = 0;
+    }
+}
+
+#else
+
+//==============================================================================
+void RealtimeChecks::noteLock() noexcept                                {}
+void RealtimeChecks::noteAllocation() noexcept                          {}
+RealtimeChecks::Report RealtimeChecks::getReport (Callback) noexcept    { return {}; }
+String RealtimeChecks::getSummary()                                     { return {}; }
+void RealtimeChecks::reset() noexcept                                   {}
+
+#endif
+
+} // namespace juce
+
+#if JUCE_LIBVLC_REALTIME_CHECKS
+//==============================================================================
+// Replacing the global allocator is the only way to see allocations made inside
+// JUCE and the standard library while a callback runs
+void* operator new (std::size_t size)
+{
+    juce::RealtimeChecks::noteAllocation();
+
+    if (auto* memory = std::malloc (size > 0 ? size : 1))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void operator delete (void* memory) noexcept                    { std::free (memory); }
+void operator delete[] (void* memory) noexcept                  { std::free (memory); }
+void operator delete (void* memory, std::size_t) noexcept       { std::free (memory); }
+void operator delete[] (void* memory, std::size_t) noexcept     { std::free (memory); }
+#endif
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../juce_libvlc_config.h"
+#include <juce_core/juce_core.h>
+#include <atomic>
+
+namespace juce
+{
+
+/**
+ * Debug instrumentation for the realtime callback paths: the audio device
+ * callback and libVLC's audio and video callbacks. Each instrumented call is
+ * timed, and any heap allocation or blocking lock taken while it runs is counted
+ * against it, so regressions show up as non-zero counts rather than as rare glitches.
+ *
+ * Only active when JUCE_LIBVLC_REALTIME_CHECKS is 1. Allocations are counted by
+ * replacing the global operator new, so enable it in one test build at a time
+ * and not in an app that replaces operator new itself. When disabled, the
+ * scopes and macros compile to nothing.
+ */
+class RealtimeChecks
+{
+public:
+    //==============================================================================
+    /** The callbacks that are expected to be allocation and lock free. */
+    enum Callback
+    {
+        audioDevice = 0,    // Pulling from the ring into the device's buffers
+        audioPlay,          // libVLC handing over decoded audio
+        audioFlush,         // libVLC discarding buffered audio
+        videoLock,          // libVLC asking for a frame to decode into
+        videoDisplay,       // libVLC publishing a decoded frame
+        numCallbacks
+    };
+
+    /** What's been measured for one kind of callback since the last reset(). */
+    struct Report
+    {
+        int64 numCalls = 0;
+        int64 numAllocations = 0;
+        int64 numLocks = 0;
+        double worstMilliseconds = 0.0;
+    };
+
+    //==============================================================================
+    /** Marks the current thread as inside a callback for as long as it exists. */
+    class ScopedCallback
+    {
+    public:
+       #if JUCE_LIBVLC_REALTIME_CHECKS
+        explicit ScopedCallback (Callback callbackToMeasure) noexcept;
+        ~ScopedCallback() noexcept;
+
+    private:
+        Callback callback;
+        Callback* previous;
+        int64 startTicks;
+       #else
+        explicit ScopedCallback (Callback) noexcept {}
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedCallback)
+    };
+
+    //==============================================================================
+    /** Counts a lock against the callback running on this thread, if there is one. */
+    static void noteLock() noexcept;
+
+    /** Counts a heap allocation against the callback running on this thread, if there is one. */
+    static void noteAllocation() noexcept;
+
+    /** Returns the measurements for one kind of callback. */
+    static Report getReport (Callback callback) noexcept;
+
+    /** Returns a line per callback, for logging. Empty when the checks are disabled. */
+    static String getSummary();
+
+    /** Clears all measurements. */
+    static void reset() noexcept;
+
+    /** Returns true if this build was made with JUCE_LIBVLC_REALTIME_CHECKS. */
+    static constexpr bool isEnabled() noexcept              { return JUCE_LIBVLC_REALTIME_CHECKS != 0; }
+
+private:
+    RealtimeChecks() = delete;
+};
+
+// Lock sites on the realtime paths are marked with this, so taking a lock there gets counted
+#if JUCE_LIBVLC_REALTIME_CHECKS
+ #define JUCE_LIBVLC_NOTE_LOCK()        juce::RealtimeChecks::noteLock()
+#else
+ #define JUCE_LIBVLC_NOTE_LOCK()
+#endif
+
+} // namespace juce
@@ -0,0 +1,370 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#include "ThumbnailExtractor.h"
+#include "KeyframeIndex.h"
+
+#include <vlc/vlc.h>
+#include <algorithm>
+#include <vector>
+
+namespace juce
+{
+
+namespace
+{
+    int chooseNumWorkers (int requested)
+    {
+        if (requested > 0)
+            return requested;
+
+        return jlimit (1, 4, SystemStats::getNumCpus() / 2);
+    }
+
+    // Splits sorted times into at most numRuns contiguous runs of similar length,
+    // never separating times that decode from the same keyframe
+    std::vector<std::vector<double>> splitIntoRuns (const std::vector<double>& times, const KeyframeIndex* index, int numRuns)
+    {
+        std::vector<std::vector<double>> groups;
+        double groupKeyframe = -1.0;
+
+        for (auto time : times)
+        {
+            auto keyframe = index != nullptr ? index->getKeyframeAtOrBefore (time) : time;
+
+            if (groups.empty() || keyframe != groupKeyframe)
+                groups.emplace_back();
+
+            groups.back().push_back (time);
+            groupKeyframe = keyframe;
+        }
+
+        auto runLength = (times.size() + static_cast<size_t>(numRuns) - 1) / static_cast<size_t>(numRuns);
+        std::vector<std::vector<double>> runs;
+
+        for (auto& group : groups)
+        {
+            if (runs.empty() || runs.back().size() >= runLength)
+                runs.emplace_back();
+
+            runs.back().insert (runs.back().end(), group.begin(), group.end());
+        }
+
+        return runs;
+    }
+}
+
+//==============================================================================
+/**
+ * One headless libVLC player, decoding a run of times in ascending order. The
+ * player is held paused; each seek makes libVLC decode up to the target and
+ * display exactly one frame, which is copied out at thumbnail size.
+ */
+class ThumbnailExtractor::Worker : public ThreadPoolJob
+{
+public:
+    Worker (ThumbnailExtractor& ownerToUse, const File& mediaToUse, std::vector<double> timesToUse, Callback callbackToUse)
+        : ThreadPoolJob ("Thumbnail worker"),
+          owner (ownerToUse),
+          media (mediaToUse),
+          times (std::move (timesToUse)),
+          callback (std::move (callbackToUse)),
+          mediaId (getMediaId (mediaToUse))
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        size_t next = 0;
+
+        if (openPlayer())
+        {
+            // start-paused decodes the first frame and holds there
+            if (waitForFrame (0))
+            {
+                for (; next < times.size() && ! shouldExit(); ++next)
+                    deliver (times[next], grabFrameAt (times[next]));
+            }
+
+            closePlayer();
+        }
+
+        // Whatever couldn't be decoded is still reported, so callers aren't left waiting
+        for (; next < times.size() && ! shouldExit(); ++next)
+            deliver (times[next], {});
+
+        return jobHasFinished;
+    }
+
+private:
+    //==============================================================================
+    bool openPlayer()
+    {
+        auto* instance = owner.sharedInstance != nullptr ? owner.sharedInstance->get() : nullptr;
+
+        if (instance == nullptr)
+            return false;
+
+        auto* vlcMedia = libvlc_media_new_path (instance, media.getFullPathName().toRawUTF8());
+
+        if (vlcMedia == nullptr)
+            return false;
+
+        // Video only, and few enough decoder threads that the workers don't fight over cores
+        auto threadsPerWorker = jmax (1, SystemStats::getNumCpus() / owner.numWorkers);
+
+        for (auto option : { String (":start-paused"), String (":no-audio"), String (":no-spu"),
+                             String (":no-sub-autodetect-file"), ":avcodec-threads=" + String (threadsPerWorker) })
+            libvlc_media_add_option (vlcMedia, option.toRawUTF8());
+
+        player = libvlc_media_player_new_from_media (vlcMedia);
+        libvlc_media_release (vlcMedia);
+
+        if (player == nullptr)
+            return false;
+
+        libvlc_video_set_callbacks (player, lockCallback, unlockCallback, displayCallback, this);
+        libvlc_video_set_format_callbacks (player, formatCallback, nullptr);
+
+        return libvlc_media_player_play (player) == 0;
+    }
+
+    void closePlayer()
+    {
+        libvlc_media_player_stop (player);
+        libvlc_media_player_release (player);
+        player = nullptr;
+    }
+
+    Image grabFrameAt (double timeInSeconds)
+    {
+        auto cached = owner.cache.get (mediaId, getCacheTime (timeInSeconds));
+
+        if (cached.isValid())
+            return cached;
+
+        auto framesBefore = numFramesDisplayed.load();
+        auto timeInMs = static_cast<libvlc_time_t>(timeInSeconds * 1000.0);
+
+       #if LIBVLC_VERSION_INT >= LIBVLC_VERSION (4, 0, 0, 0)
+        libvlc_media_player_set_time (player, timeInMs, false);
+       #else
+        libvlc_media_player_set_time (player, timeInMs);
+       #endif
+
+        if (! waitForFrame (framesBefore))
+            return {};
+
+        Image thumbnail;
+
+        {
+            // RV32 is BGRA in memory, which is what juce::Image uses on little-endian machines
+            const ScopedLock sl (frameLock);
+            thumbnail = Image (Image::ARGB, frameWidth, frameHeight, false);
+            const Image::BitmapData bitmap (thumbnail, Image::BitmapData::writeOnly);
+
+            for (int y = 0; y < frameHeight; ++y)
+                memcpy (bitmap.getLinePointer (y), frame.get() + y * frameWidth * 4, static_cast<size_t>(frameWidth) * 4);
+        }
+
+        owner.cache.add (mediaId, getCacheTime (timeInSeconds), thumbnail);
+        return thumbnail;
+    }
+
+    bool waitForFrame (int64 framesBefore)
+    {
+        auto deadline = Time::getMillisecondCounter() + static_cast<uint32>(owner.options.frameTimeoutMs);
+
+        while (numFramesDisplayed.load() <= framesBefore)
+        {
+            auto now = Time::getMillisecondCounter();
+
+            if (shouldExit() || now >= deadline)
+                return false;
+
+            frameDisplayed.wait (static_cast<int>(jmin<uint32> (deadline - now, 50)));
+        }
+
+        return true;
+    }
+
+    void deliver (double timeInSeconds, const Image& thumbnail)
+    {
+        if (callback != nullptr)
+            callback (media, timeInSeconds, thumbnail);
+    }
+
+    //==============================================================================
+    static unsigned formatCallback (void** data, char* chroma, unsigned* width, unsigned* height,
+                                    unsigned* pitches, unsigned* lines)
+    {
+        auto* worker = static_cast<Worker*>(*data);
+        auto& options = worker->owner.options;
+
+        // Let libVLC scale to thumbnail size, keeping even dimensions for its converters
+        auto scale = jmin (1.0, options.maxWidth / static_cast<double>(jmax (1u, *width)),
+                                options.maxHeight / static_cast<double>(jmax (1u, *height)));
+        auto scaled = [scale] (unsigned size) { return jmax (2, roundToInt (size * scale) & ~1); };
+
+        const ScopedLock sl (worker->frameLock);
+
+        worker->frameWidth = scaled (*width);
+        worker->frameHeight = scaled (*height);
+        worker->frame.allocate (static_cast<size_t>(worker->frameWidth * worker->frameHeight * 4), true);
+        worker->decodeBuffer.allocate (static_cast<size_t>(worker->frameWidth * worker->frameHeight * 4), true);
+
+        memcpy (chroma, "RV32", 4);
+        *width = static_cast<unsigned>(worker->frameWidth);
+        *height = static_cast<unsigned>(worker->frameHeight);
+        pitches[0] = static_cast<unsigned>(worker->frameWidth * 4);
+        lines[0] = static_cast<unsigned>(worker->frameHeight);
+        return 1;
+    }
+
+    static void* lockCallback (void* data, void** planes)
+    {
+        // libVLC decodes into a buffer only it touches; the frame is published on display
+        planes[0] = static_cast<Worker*>(data)->decodeBuffer.get();
+        return nullptr;
+    }
+
+    static void unlockCallback (void*, void*, void* const*)
+    {
+    }
+
+    static void displayCallback (void* data, void*)
+    {
+        auto* worker = static_cast<Worker*>(data);
+
+        {
+            const ScopedLock sl (worker->frameLock);
+            memcpy (worker->frame.get(), worker->decodeBuffer.get(),
+                    static_cast<size_t>(worker->frameWidth * worker->frameHeight * 4));
+        }
+
+        ++worker->numFramesDisplayed;
+        worker->frameDisplayed.signal();
+    }
+
+    //==============================================================================
+    ThumbnailExtractor& owner;
+    File media;
+    std::vector<double> times;
+    Callback callback;
+    uint64 mediaId;
+
+    libvlc_media_player_t* player = nullptr;
+    HeapBlock<uint8> decodeBuffer;          // Written by libVLC between lock and unlock
+    HeapBlock<uint8> frame;                 // Guarded by frameLock
+    int frameWidth = 0, frameHeight = 0;    // Guarded by frameLock
+    CriticalSection frameLock;
+    std::atomic<int64> numFramesDisplayed { 0 };
+    WaitableEvent frameDisplayed;
+
+    JUCE_DECLARE_NON_COPYABLE (Worker)
+};
+
+//==============================================================================
+ThumbnailExtractor::ThumbnailExtractor()
+    : ThumbnailExtractor (Options())
+{
+}
+
+ThumbnailExtractor::ThumbnailExtractor (const Options& optionsToUse)
+    : options (optionsToUse),
+      numWorkers (chooseNumWorkers (optionsToUse.numWorkers)),
+      sharedInstance (VLCInstanceManager::getInstance (optionsToUse.vlcArguments)),
+      cache (optionsToUse.cacheBytes),
+      pool (numWorkers)
+{
+}
+
+ThumbnailExtractor::~ThumbnailExtractor()
+{
+    cancelAll();
+    VLCInstanceManager::releaseInstance (sharedInstance);
+}
+
+//==============================================================================
+bool ThumbnailExtractor::extract (const File& media, const Array<double>& timesInSeconds, Callback callback)
+{
+    if (! media.existsAsFile() || sharedInstance == nullptr)
+        return false;
+
+    auto mediaId = getMediaId (media);
+    std::vector<double> toDecode;
+
+    for (auto time : timesInSeconds)
+    {
+        auto cached = cache.get (mediaId, getCacheTime (time));
+
+        if (! cached.isValid())
+            toDecode.push_back (time);
+        else if (callback != nullptr)
+            callback (media, time, cached);
+    }
+
+    if (toDecode.empty())
+        return true;
+
+    std::sort (toDecode.begin(), toDecode.end());
+    toDecode.erase (std::unique (toDecode.begin(), toDecode.end()), toDecode.end());
+
+    // Reading the keyframe table can mean parsing the file, so it's done on the pool too
+    pool.addJob ([this, media, toDecode, callback]
+    {
+        auto* job = ThreadPoolJob::getCurrentThreadPoolJob();
+        auto shouldExit = [job] { return job != nullptr && job->shouldExit(); };
+
+        // The sidecar cache is opt-in, the same as the player's indexing
+       #if JUCE_LIBVLC_KEYFRAME_INDEX
+        auto index = KeyframeIndex::loadOrBuild (media, shouldExit);
+       #else
+        auto index = KeyframeIndex::build (media, shouldExit);
+       #endif
+
+        for (auto& run : splitIntoRuns (toDecode, index.get(), numWorkers))
+            if (! shouldExit())
+                pool.addJob (new Worker (*this, media, std::move (run), callback), true);
+    });
+
+    return true;
+}
+
+void ThumbnailExtractor::cancelAll()
+{
+    // Twice, in case a batch was still being split into workers the first time round
+    for (int i = 0; i < 2; ++i)
+        pool.removeAllJobs (true, 10000);
+}
+
+bool ThumbnailExtractor::isBusy() const
+{
+    return pool.getNumJobs() > 0;
+}
+
+Image ThumbnailExtractor::getCachedThumbnail (const File& media, double timeInSeconds) const
+{
+    return cache.get (getMediaId (media), getCacheTime (timeInSeconds));
+}
+
+//==============================================================================
+uint64 ThumbnailExtractor::getMediaId (const File& media)
+{
+    // A file that's rewritten in place gets new thumbnails
+    return static_cast<uint64>(media.getFullPathName().hashCode64())
+             ^ static_cast<uint64>(media.getLastModificationTime().toMilliseconds());
+}
+
+int64 ThumbnailExtractor::getCacheTime (double timeInSeconds) noexcept
+{
+    // Thumbnails are keyed to the millisecond, the precision libVLC seeks with
+    return static_cast<int64>(std::llround (timeInSeconds * 1000.0)) * 1000;
+}
+
+} // namespace juce
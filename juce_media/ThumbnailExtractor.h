@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FrameCache.h"
+#include "VLCInstanceManager.h"
+#include <juce_core/juce_core.h>
+#include <juce_graphics/juce_graphics.h>
+#include <functional>
+
+namespace juce
+{
+
+/**
+ * Grabs frames at a list of times from a media file, for filmstrips and
+ * thumbnail grids. Each batch is spread over several headless libVLC players
+ * that share one instance, each decoding a run of nearby times at a reduced
+ * size. Times are sorted and grouped by keyframe (using the file's KeyframeIndex
+ * when it has one), so each player only ever seeks forward and frames that
+ * share a GOP are decoded by the same player.
+ *
+ * Finished thumbnails go to the batch's callback and into an LRU cache, which
+ * later requests for the same times are answered from without decoding.
+ */
+class ThumbnailExtractor
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        /** Number of players decoding in parallel; 0 picks one per two CPU cores, up to 4. */
+        int numWorkers = 0;
+
+        /** Thumbnails are scaled down to fit this, keeping their aspect ratio. */
+        int maxWidth = 160;
+        int maxHeight = 90;
+
+        /** How long a worker waits for a frame before giving up on a time. */
+        int frameTimeoutMs = 3000;
+
+        /** Image memory the cache may hold. */
+        size_t cacheBytes = 64 * 1024 * 1024;
+
+        /** Arguments for the shared libVLC instance. */
+        StringArray vlcArguments = VLCInstanceManager::getDefaultArguments();
+    };
+
+    /**
+     * Receives one thumbnail. The image is invalid if no frame could be decoded
+     * for that time. Called on a worker thread, or on the caller's thread for
+     * thumbnails served from the cache.
+     */
+    using Callback = std::function<void (const File& media, double timeInSeconds, const Image& thumbnail)>;
+
+    ThumbnailExtractor();
+    explicit ThumbnailExtractor (const Options& options);
+    ~ThumbnailExtractor();
+
+    //==============================================================================
+    /**
+     * Queues thumbnails of a file at a list of times, in seconds. Cached ones are
+     * delivered before this returns; the rest are decoded in the background.
+     * @return false if the file doesn't exist or no libVLC instance is available
+     */
+    bool extract (const File& media, const Array<double>& timesInSeconds, Callback callback);
+
+    /** Abandons all queued and running work. Blocks until the workers have stopped. */
+    void cancelAll();
+
+    /** Returns true while any batch is still being decoded. */
+    bool isBusy() const;
+
+    /** Returns a cached thumbnail, or an invalid image. */
+    Image getCachedThumbnail (const File& media, double timeInSeconds) const;
+
+    /** Returns the cache thumbnails are kept in. */
+    FrameCache& getCache() noexcept                         { return cache; }
+
+    /** Returns the number of players decoding in parallel. */
+    int getNumWorkers() const noexcept                      { return numWorkers; }
+
+private:
+    //==============================================================================
+    class Worker;
+
+    static uint64 getMediaId (const File& media);
+    static int64 getCacheTime (double timeInSeconds) noexcept;
+
+    Options options;
+    int numWorkers = 1;
+    VLCInstanceManager::Instance::Ptr sharedInstance;
+    FrameCache cache;
+    ThreadPool pool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ThumbnailExtractor)
+};
+
+} // namespace juce
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#include "VLCAudioSource.h"
+#include "AudioDeinterleaver.h"
+
+namespace juce
+{
+
+//==============================================================================
+VLCAudioSource::VLCAudioSource (VLCMediaPlayer& playerToUse)
+    : player (playerToUse)
+{
+    player.setAudioDevice (nullptr);
+}
+
+VLCAudioSource::~VLCAudioSource()
+{
+    cancelPendingUpdate();
+}
+
+//==============================================================================
+void VLCAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    blockSize = samplesPerBlockExpected;
+    player.prepareAudioOutput (sampleRate, samplesPerBlockExpected, outputLatency);
+}
+
+void VLCAudioSource::releaseResources()
+{
+}
+
+void VLCAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
+{
+    auto& buffer = *bufferToFill.buffer;
+    auto numChannels = jmin (buffer.getNumChannels(), AudioDeinterleaver::maxChannels);
+    float* channels[AudioDeinterleaver::maxChannels] = {};
+
+    // The player writes into the graph's buffer directly, offset to the region asked for
+    for (int ch = 0; ch < numChannels; ++ch)
+        channels[ch] = buffer.getWritePointer (ch, bufferToFill.startSample);
+
+    for (int ch = numChannels; ch < buffer.getNumChannels(); ++ch)
+        buffer.clear (ch, bufferToFill.startSample, bufferToFill.numSamples);
+
+    // No host time here, so the player times the block from now plus the output latency
+    player.audioDeviceIOCallbackWithContext (nullptr, 0, channels, numChannels, bufferToFill.numSamples, {});
+}
+
+//==============================================================================
+void VLCAudioSource::setNextReadPosition (int64 newPosition)
+{
+    // Transports set the position they're already at when they start; that needn't seek
+    if (std::abs (newPosition - getNextReadPosition()) <= jmax (blockSize.load(), 256))
+        return;
+
+    // Seeking takes the player's locks and calls into libVLC, which the audio thread mustn't do
+    pendingPosition = jmax (static_cast<int64>(0), newPosition);
+    triggerAsyncUpdate();
+}
+
+int64 VLCAudioSource::getNextReadPosition() const
+{
+    // Until the seek has been handed over, the position is where it's going
+    auto pending = pendingPosition.load();
+    return pending >= 0 ? pending : player.getCurrentSample();
+}
+
+int64 VLCAudioSource::getTotalLength() const
+{
+    return player.getTotalSamples();
+}
+
+void VLCAudioSource::handleAsyncUpdate()
+{
+    auto position = pendingPosition.exchange (-1);
+
+    if (position >= 0)
+        player.seekToSample (position, ISeekableMedia::SeekMode::Precise);
+}
+
+} // namespace juce
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "VLCMediaPlayer.h"
+
+namespace juce
+{
+
+/**
+ * Plays a VLCMediaPlayer's audio through your own audio graph instead of
+ * an audio device, e.g. into a MixerAudioSource, an AudioTransportSource or an
+ * AudioSourcePlayer inside an AudioProcessor.
+ *
+ * getNextAudioBlock() pulls straight from the player's ring buffer into the
+ * destination, at whatever block size the graph runs at. It uses the same
+ * resampling and A/V drift correction as the device callback. Positions are
+ * samples at the rate given to prepareToPlay(), and setNextReadPosition()
+ * seeks the player precisely. It may be called on the audio thread: the target
+ * is stored, and the seek is issued from the message thread.
+ *
+ * While a source is attached, the player must not also be given an audio device:
+ * only one consumer may pull from its ring. The player must outlive the source.
+ *
+ * For faster-than-realtime reading of a file's audio, use
+ * VLCMediaReader::createAudioFormatReaderFor() instead.
+ */
+class VLCAudioSource : public PositionableAudioSource,
+                       private AsyncUpdater
+{
+public:
+    //==============================================================================
+    /** Takes the player's audio away from any device it was playing through. */
+    explicit VLCAudioSource (VLCMediaPlayer& player);
+    ~VLCAudioSource() override;
+
+    VLCMediaPlayer& getPlayer() const noexcept                  { return player; }
+
+    /**
+     * Sets how many samples after it's rendered a block reaches the speakers,
+     * so video stays in sync with what's heard. Set it before prepareToPlay().
+     */
+    void setOutputLatency (int latencyInSamples) noexcept       { outputLatency = latencyInSamples; }
+
+    //==============================================================================
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill) override;
+
+    void setNextReadPosition (int64 newPosition) override;
+    int64 getNextReadPosition() const override;
+    int64 getTotalLength() const override;
+    bool isLooping() const override                             { return false; }
+
+private:
+    //==============================================================================
+    void handleAsyncUpdate() override;
+
+    VLCMediaPlayer& player;
+    int outputLatency = 0;
+    std::atomic<int> blockSize { 0 };
+    std::atomic<int64> pendingPosition { -1 };  // A seek waiting for the message thread, or -1
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VLCAudioSource)
+};
+
+} // namespace juce
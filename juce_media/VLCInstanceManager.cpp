@@ -0,0 +1,376 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#include "VLCInstanceManager.h"
+
+// Include libVLC headers
+#include <vlc/vlc.h>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace juce
+{
+
+namespace
+{
+    CriticalSection& getInstanceLock()
+    {
+        static CriticalSection lock;
+        return lock;
+    }
+    
+    // Keyed by the joined argument list; the map holds one reference to each instance
+    std::map<String, VLCInstanceManager::Instance::Ptr>& getSharedInstances()
+    {
+        static std::map<String, VLCInstanceManager::Instance::Ptr> instances;
+        return instances;
+    }
+    
+    StringArray& getDefaultArgumentStorage()
+    {
+        // Note: Don't specify --vout explicitly - VLC automatically uses vmem when
+        // libvlc_video_set_callbacks() is called. Specifying it too early can cause issues.
+        // Audio stays enabled: decoded PCM is routed to JUCE through libvlc_audio_set_callbacks(),
+        // so VLC never opens an output device of its own.
+        static StringArray arguments {
+            "--intf=dummy",                 // Use dummy interface (no UI)
+            "--no-video-title-show",        // Disable video title overlay
+            "--verbose=2",                  // Enable verbose output for debugging
+            "--network-caching=1000",       // Network caching (ms)
+            "--file-caching=1000",          // File caching (ms)
+            "--live-caching=1000",          // Live stream caching (ms)
+           #if JUCE_MAC
+            "--no-xlib",                    // Disable X11 on macOS
+           #endif
+            "--no-drop-late-frames",        // Don't drop frames (for precise seeking); players override per media
+            "--no-skip-frames",             // Don't skip frames
+        };
+        
+        return arguments;
+    }
+    
+    // Decoder modules that don't go through avcodec and always decode in hardware
+    bool isHardwareDecoderModule (const char* module)
+    {
+        for (auto* name : { "videotoolbox", "nvdec", "mediacodec", "omxil", "mmal_codec" })
+            if (std::strcmp (module, name) == 0)
+                return true;
+        
+        return false;
+    }
+}
+
+//==============================================================================
+VLCInstanceManager::Instance::Instance (libvlc_instance_t* instanceToUse, const StringArray& argumentsUsed)
+    : instance (instanceToUse), arguments (argumentsUsed)
+{
+    // Taking over the log silences libVLC's own stderr output, so warnings are passed on to DBG
+    if (instance != nullptr)
+        libvlc_log_set (instance, logCallback, this);
+}
+
+VLCInstanceManager::Instance::~Instance()
+{
+    if (instance != nullptr)
+    {
+        DBG ("Releasing shared libVLC instance");
+        libvlc_log_unset (instance);
+        libvlc_release (instance);
+    }
+}
+
+void VLCInstanceManager::Instance::addDecoderListener (DecoderListener* listener)
+{
+    decoderListeners.add (listener);
+}
+
+void VLCInstanceManager::Instance::removeDecoderListener (DecoderListener* listener)
+{
+    decoderListeners.remove (listener);
+}
+
+void VLCInstanceManager::Instance::logCallback (void* data, int level, const vlc_log_t* context,
+                                                const char* format, va_list args)
+{
+    auto* owner = static_cast<Instance*>(data);
+    
+    const char* module = nullptr;
+    const char* file = nullptr;
+    unsigned line = 0;
+    libvlc_log_get_context (context, &module, &file, &line);
+    
+    const char* objectType = nullptr;
+    const char* header = nullptr;
+    uintptr_t objectId = 0;
+    libvlc_log_get_object (context, &objectType, &header, &objectId);
+    
+    bool isDecoder = objectType != nullptr && module != nullptr && std::strcmp (objectType, "decoder") == 0;
+    
+    // Everything else is formatted only if it's going to be shown
+    if (! isDecoder && (level < LIBVLC_WARNING || ! JUCE_LIBVLC_DEBUG_LOGGING))
+        return;
+    
+    char message[512];
+    std::vsnprintf (message, sizeof (message), format, args);
+    
+   #if JUCE_LIBVLC_DEBUG_LOGGING
+    if (level >= LIBVLC_WARNING)
+        DBG ("libVLC " + String (level >= LIBVLC_ERROR ? "error" : "warning") + " ("
+             + String (module != nullptr ? module : "core") + "): " + String (message));
+   #endif
+    
+    if (isDecoder)
+        owner->handleDecoderMessage (level, module, message);
+}
+
+void VLCInstanceManager::Instance::handleDecoderMessage (int level, const char* module, const char* message)
+{
+    // Failed probes log warnings and errors; only a decoder that's working says anything else
+    if (level >= LIBVLC_WARNING)
+        return;
+    
+    String text (message);
+    
+    // avcodec names its hardware back end once it has negotiated one with the GPU
+    if (text.startsWith ("Using ") && text.endsWith (" for hardware decoding"))
+    {
+        auto name = text.fromFirstOccurrenceOf ("Using ", false, false)
+                        .upToLastOccurrenceOf (" for hardware decoding", false, false);
+        decoderListeners.call ([&name] (DecoderListener& l) { l.videoDecoderOpened (name, true); });
+        return;
+    }
+    
+    if (isHardwareDecoderModule (module))
+    {
+        String name (module);
+        decoderListeners.call ([&name] (DecoderListener& l) { l.videoDecoderOpened (name, true); });
+    }
+}
+
+//==============================================================================
+VLCInstanceManager::Instance::Ptr VLCInstanceManager::getInstance (const StringArray& arguments)
+{
+    const ScopedLock sl (getInstanceLock());
+    
+    auto key = arguments.joinIntoString ("\n");
+    auto& instances = getSharedInstances();
+    
+    auto existing = instances.find (key);
+    if (existing != instances.end())
+        return existing->second;
+    
+    auto* vlcInstance = createInstance (arguments);
+    if (vlcInstance == nullptr)
+        return nullptr;
+    
+    Instance::Ptr instance (new Instance (vlcInstance, arguments));
+    instances[key] = instance;
+    return instance;
+}
+
+VLCInstanceManager::Instance::Ptr VLCInstanceManager::getDefaultInstance()
+{
+    return getInstance (getDefaultArguments());
+}
+
+void VLCInstanceManager::releaseInstance (Instance::Ptr& instance)
+{
+    if (instance == nullptr)
+        return;
+    
+    const ScopedLock sl (getInstanceLock());
+    
+    auto key = instance->getArguments().joinIntoString ("\n");
+    instance = nullptr;
+    
+    // Drop the pool's reference once it's the only one left
+    auto& instances = getSharedInstances();
+    auto existing = instances.find (key);
+    
+    if (existing != instances.end() && existing->second->getReferenceCount() == 1)
+        instances.erase (existing);
+}
+
+int VLCInstanceManager::getNumInstances()
+{
+    const ScopedLock sl (getInstanceLock());
+    return static_cast<int>(getSharedInstances().size());
+}
+
+//==============================================================================
+StringArray VLCInstanceManager::getDefaultArguments()
+{
+    const ScopedLock sl (getInstanceLock());
+    return getDefaultArgumentStorage();
+}
+
+void VLCInstanceManager::setDefaultArguments (const StringArray& newArguments)
+{
+    const ScopedLock sl (getInstanceLock());
+    getDefaultArgumentStorage() = newArguments;
+}
+
+//==============================================================================
+void VLCInstanceManager::configurePluginPaths()
+{
+    // The environment only needs setting up once per process
+    static bool configured = false;
+    
+    if (configured)
+        return;
+    
+    configured = true;
+    
+    // When using statically linked VLC, plugins are loaded from bundled location
+    // Try to find plugins relative to the application bundle
+    juce::File appBundle = juce::File::getSpecialLocation(juce::File::currentApplicationFile);
+    juce::File pluginsDir;
+    
+    DBG ("Application path: " + appBundle.getFullPathName());
+    
+    // First check if we're in an app bundle
+    if (appBundle.getFileExtension() == ".app")
+    {
+        // VLC plugins are stored in Resources (not PlugIns) to avoid codesign issues
+        // with the plugins.dat cache file which is a data file, not code
+        pluginsDir = appBundle.getChildFile("Contents/Resources/vlc/plugins");
+        DBG ("Checking for plugins at: " + pluginsDir.getFullPathName());
+        
+        if (!pluginsDir.exists())
+        {
+            // Try legacy PlugIns location for backwards compatibility
+            pluginsDir = appBundle.getChildFile("Contents/PlugIns/vlc/plugins");
+            DBG ("Checking legacy path: " + pluginsDir.getFullPathName());
+        }
+        
+        // Set library path for VLC plugin dependencies
+        // Our bundle_vlc_deps.sh script copies Homebrew dependencies to vlc/lib/
+        // and rewrites plugin paths to use @loader_path/../../lib/
+        // We need to ensure the dyld library path includes this location for any
+        // plugins that might have transitive dependencies
+        juce::File libsDir = appBundle.getChildFile("Contents/Resources/vlc/lib");
+        if (libsDir.exists())
+        {
+            DBG ("Found bundled VLC libraries at: " + libsDir.getFullPathName());
+            
+            // Get current DYLD_LIBRARY_PATH and prepend our libs dir
+            const char* currentPath = getenv("DYLD_LIBRARY_PATH");
+            juce::String newPath = libsDir.getFullPathName();
+            if (currentPath != nullptr && strlen(currentPath) > 0)
+            {
+                newPath += ":" + juce::String(currentPath);
+            }
+            setenv("DYLD_LIBRARY_PATH", newPath.toUTF8(), 1);
+            DBG ("Set DYLD_LIBRARY_PATH to include: " + libsDir.getFullPathName());
+        }
+    }
+    else
+    {
+        // Running from build directory or as standalone executable
+        // Try to find plugins relative to executable
+        juce::File executableDir = appBundle.getParentDirectory();
+        pluginsDir = executableDir.getChildFile("vlc-install/lib/vlc/plugins");
+        DBG ("Checking build directory path: " + pluginsDir.getFullPathName());
+    }
+    
+    // If plugins found, set the path for VLC
+    if (pluginsDir.exists())
+    {
+        // Verify plugins.dat exists
+        juce::File pluginsCache = pluginsDir.getChildFile("plugins.dat");
+        if (pluginsCache.exists())
+        {
+            DBG ("Found VLC plugins cache at: " + pluginsCache.getFullPathName());
+        }
+        else
+        {
+            DBG ("WARNING: plugins.dat not found - VLC may fail to load plugins!");
+            DBG ("Run 'vlc-cache-gen' on the plugins directory to generate this file.");
+        }
+        
+        DBG ("Setting VLC_PLUGIN_PATH to: " + pluginsDir.getFullPathName());
+        setenv("VLC_PLUGIN_PATH", pluginsDir.getFullPathName().toUTF8(), 1);
+    }
+    else
+    {
+        DBG ("VLC plugins not found in expected locations");
+        DBG ("VLC will attempt to use static plugins or system paths");
+    }
+}
+
+libvlc_instance_t* VLCInstanceManager::createInstance (const StringArray& arguments)
+{
+    DBG ("Attempting to initialize libVLC...");
+    
+    configurePluginPaths();
+    
+    std::vector<const char*> argv;
+    for (auto& argument : arguments)
+        argv.push_back (argument.toRawUTF8());
+    
+    int argc = static_cast<int>(argv.size());
+    DBG ("Trying libVLC initialization with " + juce::String(argc) + " arguments...");
+    libvlc_instance_t* vlcInstance = libvlc_new (argc, argv.data());
+    
+    if (vlcInstance == nullptr)
+    {
+        // Try with fewer arguments if first attempt fails
+        DBG ("First attempt failed, trying with minimal arguments...");
+        const char* const minimal_args[] = {
+            "--intf=dummy",
+            "--no-video-title-show",
+            "--verbose=2",
+        };
+        vlcInstance = libvlc_new (3, minimal_args);
+    }
+    
+    if (vlcInstance == nullptr)
+    {
+        DBG ("Minimal args failed, trying with no arguments...");
+        vlcInstance = libvlc_new (0, nullptr);
+    }
+    
+    if (vlcInstance == nullptr)
+    {
+        DBG ("Failed to initialize libVLC instance - all methods failed");
+        DBG ("Current working directory: " + juce::File::getCurrentWorkingDirectory().getFullPathName());
+        DBG ("VLC_PLUGIN_PATH env var: " + juce::String (getenv("VLC_PLUGIN_PATH") ? getenv("VLC_PLUGIN_PATH") : "not set"));
+        
+        // Try to get last libVLC error
+        const char* vlcError = libvlc_errmsg();
+        if (vlcError != nullptr)
+        {
+            DBG ("libVLC error: " + juce::String(vlcError));
+        }
+        
+        return nullptr;
+    }
+    
+    DBG ("libVLC instance created successfully!");
+    
+    // Get libVLC version info
+    const char* version = libvlc_get_version();
+    if (version != nullptr)
+    {
+        DBG ("libVLC version: " + juce::String (version));
+    }
+    
+    // Log available video filters
+    libvlc_module_description_t* vouts = libvlc_video_filter_list_get(vlcInstance);
+    if (vouts != nullptr)
+    {
+        DBG ("Available video filters detected");
+        libvlc_module_description_list_release(vouts);
+    }
+    
+    return vlcInstance;
+}
+
+} // namespace juce
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../juce_libvlc_config.h"
+#include <juce_core/juce_core.h>
+#include <cstdarg>
+
+// Forward declarations for libVLC types
+struct libvlc_instance_t;
+struct vlc_log_t;
+
+namespace juce
+{
+
+/**
+ * Process-wide pool of libVLC instances. Creating an instance probes plugin
+ * paths and loads every plugin's state, which takes hundreds of milliseconds,
+ * so players that use the same argument set share one reference-counted
+ * instance instead of each creating their own.
+ *
+ * All methods are thread safe.
+ */
+class VLCInstanceManager
+{
+public:
+    //==============================================================================
+    /** A shared libVLC instance, released once the last player using it lets go. */
+    class Instance : public ReferenceCountedObject
+    {
+    public:
+        using Ptr = ReferenceCountedObjectPtr<Instance>;
+        
+        ~Instance() override;
+        
+        /** Returns the underlying libVLC instance. */
+        libvlc_instance_t* get() const noexcept                 { return instance; }
+        
+        /** Returns the arguments the instance was created with. */
+        const StringArray& getArguments() const noexcept        { return arguments; }
+        
+        //==============================================================================
+        /**
+         * Hears which video decoders libVLC opens, as announced in its log. libVLC
+         * has no API for this, and the log doesn't say which player a decoder
+         * belongs to, so every listener on the instance hears every decoder.
+         * Called on libVLC's threads.
+         */
+        class DecoderListener
+        {
+        public:
+            virtual ~DecoderListener() = default;
+            
+            /** A decoder module announced itself; isHardware is true for GPU or fixed-function decoders. */
+            virtual void videoDecoderOpened (const String& name, bool isHardware) = 0;
+        };
+        
+        void addDecoderListener (DecoderListener* listener);
+        void removeDecoderListener (DecoderListener* listener);
+        
+    private:
+        friend class VLCInstanceManager;
+        Instance (libvlc_instance_t* instanceToUse, const StringArray& argumentsUsed);
+        
+        static void logCallback (void* data, int level, const vlc_log_t* context, const char* format, va_list args);
+        void handleDecoderMessage (int level, const char* module, const char* message);
+        
+        libvlc_instance_t* instance = nullptr;
+        StringArray arguments;
+        ListenerList<DecoderListener, Array<DecoderListener*, CriticalSection>> decoderListeners;
+        
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Instance)
+    };
+    
+    //==============================================================================
+    /**
+     * Returns the shared instance for an argument set, creating it on first use.
+     * @return the instance, or nullptr if libVLC could not be initialised
+     */
+    static Instance::Ptr getInstance (const StringArray& arguments);
+    
+    /** Returns the shared instance for the default argument set. */
+    static Instance::Ptr getDefaultInstance();
+    
+    /**
+     * Gives back an instance obtained from getInstance() and clears the pointer.
+     * The instance is destroyed once nothing else is using it.
+     */
+    static void releaseInstance (Instance::Ptr& instance);
+    
+    /** Returns the number of live shared instances (mostly useful for diagnostics). */
+    static int getNumInstances();
+    
+    //==============================================================================
+    /** Returns the arguments used by getDefaultInstance(). */
+    static StringArray getDefaultArguments();
+    
+    /**
+     * Replaces the arguments used by getDefaultInstance(). Instances that already
+     * exist keep their arguments; the new set applies to players created afterwards.
+     */
+    static void setDefaultArguments (const StringArray& newArguments);
+    
+private:
+    static void configurePluginPaths();
+    static libvlc_instance_t* createInstance (const StringArray& arguments);
+    
+    JUCE_DECLARE_NON_COPYABLE (VLCInstanceManager)
+};
+
+} // namespace juce
@@ -15,9 +15,53 @@
 namespace juce
 {
 
+namespace
+{
+    // The timebase AudioIODeviceCallbackContext::hostTimeNs is measured in
+    int64_t getHostTimeNs() noexcept
+    {
+        return static_cast<int64_t>(Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks()) * 1.0e9);
+    }
+    
+    // Adds a measurement to a running total and maximum, from any thread
+    void addStatsSample (std::atomic<int64>& total, std::atomic<int64>& maximum, int64 value) noexcept
+    {
+        total.fetch_add (value, std::memory_order_relaxed);
+        auto previous = maximum.load (std::memory_order_relaxed);
+        
+        while (value > previous && ! maximum.compare_exchange_weak (previous, value, std::memory_order_relaxed))
+        {
+        }
+    }
+    
+    // Times a callback into the stats counters, whichever way it returns
+    struct ScopedStatsTimer
+    {
+        ScopedStatsTimer (std::atomic<int64>& totalToUse, std::atomic<int64>& maximumToUse, std::atomic<int64>& countToUse) noexcept
+            : total (totalToUse), maximum (maximumToUse), count (countToUse)
+        {
+        }
+        
+        ~ScopedStatsTimer()
+        {
+            addStatsSample (total, maximum, Time::getHighResolutionTicks() - startTicks);
+            count.fetch_add (1, std::memory_order_relaxed);
+        }
+        
+        std::atomic<int64>& total;
+        std::atomic<int64>& maximum;
+        std::atomic<int64>& count;
+        const int64 startTicks = Time::getHighResolutionTicks();
+    };
+    
+    double ticksToMs (int64 ticks) noexcept
+    {
+        return Time::highResolutionTicksToSeconds (ticks) * 1000.0;
+    }
+}
+
 //==============================================================================
 VLCMediaPlayer::AudioBuffer::AudioBuffer (int channels, int samples)
-    : numChannels (channels), numSamples (samples)
 {
     resize (channels, samples);
 }
@@ -41,27 +85,32 @@ void VLCMediaPlayer::AudioBuffer::resize (int channels, int samples)
         delete[] data;
     }
     
+    // Round up so wrapping is a mask instead of a modulo
     numChannels = channels;
-    numSamples = samples;
+    numSamples = samples > 0 ? nextPowerOfTwo (samples) : 0;
+    mask = numSamples - 1;
     
-    if (channels > 0 && samples > 0)
+    if (channels > 0 && numSamples > 0)
     {
         data = new float*[channels];
         for (int i = 0; i < channels; ++i)
-            data[i] = new float[samples];
+            data[i] = new float[numSamples];
         clear();
     }
     else
     {
         data = nullptr;
+        mask = 0;
     }
 }
 
 void VLCMediaPlayer::AudioBuffer::clear()
 {
-    writePosition = 0;
-    readPosition = 0;
-    availableSamples = 0;
+    head = 0;
+    tail = 0;
+    flushPosition = 0;
+    flushGeneration = 0;
+    consumerGeneration = 0;
     
     if (data != nullptr)
     {
@@ -70,1013 +119,4075 @@ void VLCMediaPlayer::AudioBuffer::clear()
     }
 }
 
-//==============================================================================
-VLCMediaPlayer::VLCMediaPlayer()
+void VLCMediaPlayer::AudioBuffer::flush()
 {
-    initializeVLC();
+    // Mark everything written so far as stale; flushPosition only ever moves forward
+    auto position = head.load (std::memory_order_acquire);
+    auto previous = flushPosition.load (std::memory_order_relaxed);
     
-    // Create audio ring buffer (2 seconds at 48kHz stereo)
-    audioRingBuffer = std::make_unique<AudioBuffer> (2, 96000);
+    while (previous < position
+           && ! flushPosition.compare_exchange_weak (previous, position, std::memory_order_relaxed))
+    {
+    }
     
-    // Start timer for position updates (60 FPS)
-    startTimer (16);
+    flushGeneration.fetch_add (1, std::memory_order_release);
 }
 
-VLCMediaPlayer::~VLCMediaPlayer()
+int VLCMediaPlayer::AudioBuffer::getFreeSpace() const
 {
-    close();
-    shutdownVLC();
+    auto used = head.load (std::memory_order_relaxed) - tail.load (std::memory_order_acquire);
+    return numSamples - static_cast<int>(used);
 }
 
-//==============================================================================
-void VLCMediaPlayer::initializeVLC()
+void VLCMediaPlayer::AudioBuffer::prepareToWrite (int numWanted, int& start1, int& size1,
+                                                  int& start2, int& size2) const
 {
-    DBG ("Attempting to initialize libVLC...");
-    
-    // When using statically linked VLC, plugins are loaded from bundled location
-    // Try to find plugins relative to the application bundle
-    juce::File appBundle = juce::File::getSpecialLocation(juce::File::currentApplicationFile);
-    juce::File pluginsDir;
+    int numToWrite = jlimit (0, getFreeSpace(), numWanted);
     
-    DBG ("Application path: " + appBundle.getFullPathName());
+    start1 = static_cast<int>(head.load (std::memory_order_relaxed) & static_cast<uint64_t>(mask));
+    size1 = jmin (numToWrite, numSamples - start1);
+    start2 = 0;
+    size2 = numToWrite - size1;
+}
+
+void VLCMediaPlayer::AudioBuffer::finishedWrite (int numWritten)
+{
+    if (numWritten > 0)
+        head.store (head.load (std::memory_order_relaxed) + static_cast<uint64_t>(numWritten),
+                    std::memory_order_release);
+}
+
+int VLCMediaPlayer::AudioBuffer::write (const float* const* source, int numSourceChannels, int numToWrite)
+{
+    int start1, size1, start2, size2;
+    prepareToWrite (numToWrite, start1, size1, start2, size2);
     
-    // First check if we're in an app bundle
-    if (appBundle.getFileExtension() == ".app")
+    for (int channel = 0; channel < numChannels; ++channel)
     {
-        // VLC plugins are stored in Resources (not PlugIns) to avoid codesign issues
-        // with the plugins.dat cache file which is a data file, not code
-        pluginsDir = appBundle.getChildFile("Contents/Resources/vlc/plugins");
-        DBG ("Checking for plugins at: " + pluginsDir.getFullPathName());
-        
-        if (!pluginsDir.exists())
+        if (channel < numSourceChannels && source[channel] != nullptr)
         {
-            // Try legacy PlugIns location for backwards compatibility
-            pluginsDir = appBundle.getChildFile("Contents/PlugIns/vlc/plugins");
-            DBG ("Checking legacy path: " + pluginsDir.getFullPathName());
+            FloatVectorOperations::copy (data[channel] + start1, source[channel], size1);
+            if (size2 > 0)
+                FloatVectorOperations::copy (data[channel] + start2, source[channel] + size1, size2);
         }
-        
-        // Set library path for VLC plugin dependencies
-        // Our bundle_vlc_deps.sh script copies Homebrew dependencies to vlc/lib/
-        // and rewrites plugin paths to use @loader_path/../../lib/
-        // We need to ensure the dyld library path includes this location for any
-        // plugins that might have transitive dependencies
-        juce::File libsDir = appBundle.getChildFile("Contents/Resources/vlc/lib");
-        if (libsDir.exists())
+        else
         {
-            DBG ("Found bundled VLC libraries at: " + libsDir.getFullPathName());
-            
-            // Get current DYLD_LIBRARY_PATH and prepend our libs dir
-            const char* currentPath = getenv("DYLD_LIBRARY_PATH");
-            juce::String newPath = libsDir.getFullPathName();
-            if (currentPath != nullptr && strlen(currentPath) > 0)
-            {
-                newPath += ":" + juce::String(currentPath);
-            }
-            setenv("DYLD_LIBRARY_PATH", newPath.toUTF8(), 1);
-            DBG ("Set DYLD_LIBRARY_PATH to include: " + libsDir.getFullPathName());
+            FloatVectorOperations::clear (data[channel] + start1, size1);
+            if (size2 > 0)
+                FloatVectorOperations::clear (data[channel] + start2, size2);
         }
     }
-    else
+    
+    finishedWrite (size1 + size2);
+    return size1 + size2;
+}
+
+int VLCMediaPlayer::AudioBuffer::getNumReady() const
+{
+    auto used = head.load (std::memory_order_acquire) - tail.load (std::memory_order_relaxed);
+    return static_cast<int>(used);
+}
+
+int VLCMediaPlayer::AudioBuffer::read (float* const* dest, int numDestChannels, int numToRead)
+{
+    auto readIndex = tail.load (std::memory_order_relaxed);
+    
+    // Honour any flush requested since our last read by skipping past the stale data
+    auto generation = flushGeneration.load (std::memory_order_acquire);
+    if (generation != consumerGeneration)
     {
-        // Running from build directory or as standalone executable
-        // Try to find plugins relative to executable
-        juce::File executableDir = appBundle.getParentDirectory();
-        pluginsDir = executableDir.getChildFile("vlc-install/lib/vlc/plugins");
-        DBG ("Checking build directory path: " + pluginsDir.getFullPathName());
+        consumerGeneration = generation;
+        readIndex = jmax (readIndex, flushPosition.load (std::memory_order_relaxed));
+        tail.store (readIndex, std::memory_order_release);
     }
     
-    // If plugins found, set the path for VLC
-    if (pluginsDir.exists())
+    numToRead = peek (dest, numDestChannels, numToRead);
+    
+    if (numToRead > 0)
+        tail.store (readIndex + static_cast<uint64_t>(numToRead), std::memory_order_release);
+    
+    return numToRead;
+}
+
+int VLCMediaPlayer::AudioBuffer::peek (float* const* dest, int numDestChannels, int numToPeek) const
+{
+    // Consumer only; a pending flush isn't applied until the next read
+    auto readIndex = tail.load (std::memory_order_relaxed);
+    auto available = static_cast<int>(head.load (std::memory_order_acquire) - readIndex);
+    numToPeek = jlimit (0, available, numToPeek);
+    
+    if (numToPeek == 0)
+        return 0;
+    
+    int start1 = static_cast<int>(readIndex & static_cast<uint64_t>(mask));
+    int size1 = jmin (numToPeek, numSamples - start1);
+    int size2 = numToPeek - size1;
+    
+    for (int channel = 0; channel < jmin (numDestChannels, numChannels); ++channel)
     {
-        // Verify plugins.dat exists
-        juce::File pluginsCache = pluginsDir.getChildFile("plugins.dat");
-        if (pluginsCache.exists())
-        {
-            DBG ("Found VLC plugins cache at: " + pluginsCache.getFullPathName());
-        }
-        else
-        {
-            DBG ("WARNING: plugins.dat not found - VLC may fail to load plugins!");
-            DBG ("Run 'vlc-cache-gen' on the plugins directory to generate this file.");
-        }
+        if (dest[channel] == nullptr)
+            continue;
         
-        DBG ("Setting VLC_PLUGIN_PATH to: " + pluginsDir.getFullPathName());
-        setenv("VLC_PLUGIN_PATH", pluginsDir.getFullPathName().toUTF8(), 1);
+        FloatVectorOperations::copy (dest[channel], data[channel] + start1, size1);
+        if (size2 > 0)
+            FloatVectorOperations::copy (dest[channel] + size1, data[channel], size2);
     }
-    else
+    
+    return numToPeek;
+}
+
+//==============================================================================
+void VLCMediaPlayer::TimelinePoint::publish (const Values& values) noexcept
+{
+    // The sequence is odd while the fields are being written
+    auto current = sequence.load (std::memory_order_relaxed);
+    sequence.store (current + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+    
+    position.store (values.position, std::memory_order_relaxed);
+    sample.store (values.sample, std::memory_order_relaxed);
+    timeNs.store (values.timeNs, std::memory_order_relaxed);
+    span.store (values.span, std::memory_order_relaxed);
+    epoch.store (values.epoch, std::memory_order_relaxed);
+    
+    sequence.store (current + 2, std::memory_order_release);
+}
+
+bool VLCMediaPlayer::TimelinePoint::read (Values& values) const noexcept
+{
+    // Writers finish in well under a microsecond, so a few retries always get a clean copy
+    for (int attempt = 0; attempt < 16; ++attempt)
     {
-        DBG ("VLC plugins not found in expected locations");
-        DBG ("VLC will attempt to use static plugins or system paths");
-    }
-    
-    // Build VLC initialization arguments
-    // Note: Don't specify --vout explicitly - VLC automatically uses vmem when
-    // libvlc_video_set_callbacks() is called. Specifying it too early can cause issues.
-    // Audio is disabled since we handle audio through JUCE's audio system.
-    const char* const vlc_args[] = {
-        "--intf=dummy",                 // Use dummy interface (no UI)
-        "--no-video-title-show",        // Disable video title overlay
-        "--verbose=2",                  // Enable verbose output for debugging
-        "--no-audio",                   // Disable VLC audio output (JUCE handles audio)
-        "--network-caching=1000",       // Network caching (ms)
-        "--file-caching=1000",          // File caching (ms)
-        "--live-caching=1000",          // Live stream caching (ms)
-#if JUCE_MAC
-        "--no-xlib",                    // Disable X11 on macOS
-#endif
-        "--no-drop-late-frames",        // Don't drop frames (for precise seeking)
-        "--no-skip-frames",             // Don't skip frames
-    };
+        auto before = sequence.load (std::memory_order_acquire);
+        if ((before & 1) != 0)
+            continue;
+        
+        values.position = position.load (std::memory_order_relaxed);
+        values.sample = sample.load (std::memory_order_relaxed);
+        values.timeNs = timeNs.load (std::memory_order_relaxed);
+        values.span = span.load (std::memory_order_relaxed);
+        values.epoch = epoch.load (std::memory_order_relaxed);
+        
+        std::atomic_thread_fence (std::memory_order_acquire);
+        if (sequence.load (std::memory_order_relaxed) == before)
+            return values.position >= 0;
+    }
+    
+    return false;
+}
+
+void VLCMediaPlayer::TransportReport::publish (const Values& values) noexcept
+{
+    auto current = sequence.load (std::memory_order_relaxed);
+    sequence.store (current + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
     
-    int argc = sizeof(vlc_args) / sizeof(vlc_args[0]);
-    DBG ("Trying libVLC initialization with " + juce::String(argc) + " arguments...");
-    vlcInstance = libvlc_new (argc, vlc_args);
+    position.store (values.position, std::memory_order_relaxed);
+    rate.store (values.rate, std::memory_order_relaxed);
+    reportedAtNs.store (values.reportedAtNs, std::memory_order_relaxed);
+    isPlaying.store (values.isPlaying, std::memory_order_relaxed);
     
-    if (vlcInstance == nullptr)
+    sequence.store (current + 2, std::memory_order_release);
+}
+
+bool VLCMediaPlayer::TransportReport::read (Values& values) const noexcept
+{
+    for (int attempt = 0; attempt < 16; ++attempt)
     {
-        // Try with fewer arguments if first attempt fails
-        DBG ("First attempt failed, trying with minimal arguments...");
-        const char* const minimal_args[] = {
-            "--intf=dummy",
-            "--no-video-title-show",
-            "--verbose=2",
-        };
-        vlcInstance = libvlc_new (3, minimal_args);
+        auto before = sequence.load (std::memory_order_acquire);
+        if ((before & 1) != 0)
+            continue;
+        
+        values.position = position.load (std::memory_order_relaxed);
+        values.rate = rate.load (std::memory_order_relaxed);
+        values.reportedAtNs = reportedAtNs.load (std::memory_order_relaxed);
+        values.isPlaying = isPlaying.load (std::memory_order_relaxed);
+        
+        std::atomic_thread_fence (std::memory_order_acquire);
+        if (sequence.load (std::memory_order_relaxed) == before)
+            return true;
     }
     
-    if (vlcInstance == nullptr)
+    return false;
+}
+
+//==============================================================================
+/**
+ * A heavyweight child window that tracks the video component's bounds, giving
+ * libVLC a native handle of its own to render into in NativeWindow mode.
+ */
+class VLCMediaPlayer::NativeVideoSurface : public Component,
+                                           private ComponentMovementWatcher
+{
+public:
+    NativeVideoSurface (Component& target, std::function<void()> peerChangedCallback)
+        : ComponentMovementWatcher (&target),
+          targetComponent (target),
+          onPeerChanged (std::move (peerChangedCallback))
     {
-        DBG ("Minimal args failed, trying with no arguments...");
-        vlcInstance = libvlc_new (0, nullptr);
+        setOpaque (true);
+        setInterceptsMouseClicks (false, false);
+        attachToPeer();
     }
     
-    if (vlcInstance == nullptr)
+    ~NativeVideoSurface() override
+    {
+        removeFromDesktop();
+    }
+    
+    Component& getTarget() const noexcept   { return targetComponent; }
+    
+    void paint (Graphics& g) override
     {
-        DBG ("Failed to initialize libVLC instance - all methods failed");
-        DBG ("Current working directory: " + juce::File::getCurrentWorkingDirectory().getFullPathName());
-        DBG ("VLC_PLUGIN_PATH env var: " + juce::String (getenv("VLC_PLUGIN_PATH") ? getenv("VLC_PLUGIN_PATH") : "not set"));
+        g.fillAll (Colours::black);
+    }
+    
+private:
+    using ComponentMovementWatcher::componentMovedOrResized;
+    using ComponentMovementWatcher::componentVisibilityChanged;
+    
+    void attachToPeer()
+    {
+        if (isOnDesktop())
+            removeFromDesktop();
         
-        // Try to get last libVLC error
-        const char* vlcError = libvlc_errmsg();
-        if (vlcError != nullptr)
+        if (auto* peer = targetComponent.getPeer())
         {
-            DBG ("libVLC error: " + juce::String(vlcError));
+            // Attached windows are positioned relative to the parent's native window
+            addToDesktop (0, peer->getNativeHandle());
+            updatePosition();
+            setVisible (targetComponent.isShowing());
         }
-        
-        return;
     }
     
-    DBG ("libVLC instance created successfully!");
+    void updatePosition()
+    {
+        if (auto* topLevel = targetComponent.getTopLevelComponent())
+            setBounds (topLevel->getLocalArea (&targetComponent, targetComponent.getLocalBounds()));
+    }
     
-    // Get libVLC version info
-    const char* version = libvlc_get_version();
-    if (version != nullptr)
+    void componentMovedOrResized (bool, bool) override
     {
-        DBG ("libVLC version: " + juce::String (version));
+        updatePosition();
     }
     
-    // Log available video outputs
-    libvlc_module_description_t* vouts = libvlc_video_filter_list_get(vlcInstance);
-    if (vouts != nullptr)
+    void componentPeerChanged() override
     {
-        DBG ("Available video filters detected");
-        libvlc_module_description_list_release(vouts);
+        attachToPeer();
+        
+        if (onPeerChanged != nullptr)
+            onPeerChanged();
     }
     
-    mediaPlayer = libvlc_media_player_new (vlcInstance);
-    if (mediaPlayer == nullptr)
+    void componentVisibilityChanged() override
     {
-        DBG ("Failed to create libVLC media player");
-        const char* vlcError = libvlc_errmsg();
-        if (vlcError != nullptr)
-        {
-            DBG ("libVLC error: " + juce::String(vlcError));
-        }
-        return;
+        setVisible (targetComponent.isShowing());
     }
     
-    DBG ("libVLC media player created successfully!");
-    setupEventHandling();
-}
+    Component& targetComponent;
+    std::function<void()> onPeerChanged;
+    
+    JUCE_DECLARE_NON_COPYABLE (NativeVideoSurface)
+};
 
-void VLCMediaPlayer::shutdownVLC()
+//==============================================================================
+/** Reads or loads the keyframe index of the media being opened without holding up open(). */
+class VLCMediaPlayer::KeyframeIndexBuilder : private Thread
 {
-    // Stop playback first to prevent callbacks during destruction
-    if (mediaPlayer != nullptr)
+public:
+    KeyframeIndexBuilder (VLCMediaPlayer& ownerToUse, const File& mediaToIndex)
+        : Thread ("VLC keyframe index"), owner (ownerToUse), media (mediaToIndex)
     {
-        libvlc_media_player_stop (mediaPlayer);
-        
-        // Clear all callbacks before releasing to prevent memory corruption
-        libvlc_video_set_callbacks (mediaPlayer, nullptr, nullptr, nullptr, nullptr);
-        libvlc_video_set_format_callbacks (mediaPlayer, nullptr, nullptr);
-        
-        // Wait a bit for any running callbacks to finish
-        juce::Thread::sleep (50);
-        
-        libvlc_media_player_release (mediaPlayer);
-        mediaPlayer = nullptr;
+        startThread (Thread::Priority::low);
     }
     
-    if (currentMedia != nullptr)
+    ~KeyframeIndexBuilder() override
     {
-        libvlc_media_release (currentMedia);
-        currentMedia = nullptr;
+        stopThread (2000);
     }
     
-    if (vlcInstance != nullptr)
+private:
+    void run() override
     {
-        libvlc_release (vlcInstance);
-        vlcInstance = nullptr;
+        std::shared_ptr<const KeyframeIndex> index (KeyframeIndex::loadOrBuild (media, [this] { return threadShouldExit(); }));
+        
+        if (threadShouldExit())
+            return;
+        
+        DBG("VLCMediaPlayer::KeyframeIndexBuilder - " + (index != nullptr ? juce::String (index->getNumKeyframes()) + " keyframes indexed"
+                                                                          : juce::String ("no keyframe table")));
+        
+        const SpinLock::ScopedLockType lock (owner.keyframeIndexLock);
+        owner.keyframeIndex = std::move (index);
     }
-}
+    
+    VLCMediaPlayer& owner;
+    File media;
+    
+    JUCE_DECLARE_NON_COPYABLE (KeyframeIndexBuilder)
+};
 
 //==============================================================================
-bool VLCMediaPlayer::open (const File& media, String* error)
+/** Moves frames from the intake buffers into the frame cache, off libVLC's threads. */
+class VLCMediaPlayer::FrameCacheWriter : private Thread
 {
-    close();
+public:
+    explicit FrameCacheWriter (VLCMediaPlayer& ownerToUse)
+        : Thread ("VLC frame cache"), owner (ownerToUse)
+    {
+        startThread (Thread::Priority::low);
+    }
     
-    if (!media.exists())
+    ~FrameCacheWriter() override
     {
-        if (error != nullptr)
-            *error = "File does not exist: " + media.getFullPathName();
-        return false;
+        signalThreadShouldExit();
+        owner.frameIntake.frameOffered.signal();
+        stopThread (2000);
     }
     
-    if (vlcInstance == nullptr || mediaPlayer == nullptr)
+private:
+    void run() override
     {
-        if (error != nullptr)
-            *error = "libVLC not initialized";
-        return false;
+        auto& intake = owner.frameIntake;
+        
+        while (! threadShouldExit())
+        {
+            intake.frameOffered.wait (100);
+            
+            for (auto& buffer : intake.buffers)
+            {
+                int expected = FrameIntake::bufferFilled;
+                
+                if (buffer.state.compare_exchange_strong (expected, FrameIntake::bufferBusy))
+                {
+                    store (buffer);
+                    buffer.state = FrameIntake::bufferFree;
+                }
+            }
+            
+            growBuffers (intake);
+        }
     }
     
-    // Create media from file path
-    auto mediaPath = media.getFullPathName().toUTF8();
-    currentMedia = libvlc_media_new_path (vlcInstance, mediaPath.getAddress());
+    void store (const FrameIntake::Buffer& buffer)
+    {
+        // Frames of media that's since been closed are dropped
+        if (buffer.mediaId != owner.frameCacheMediaId.load() || owner.frameCache == nullptr)
+            return;
+        
+        Image frame (Image::ARGB, buffer.width, buffer.height, false);
+        
+        {
+            const Image::BitmapData bitmap (frame, Image::BitmapData::writeOnly);
+            
+            for (int y = 0; y < buffer.height; ++y)
+                memcpy (bitmap.getLinePointer (y), buffer.pixels + y * buffer.width * 4, static_cast<size_t>(buffer.width) * 4);
+        }
+        
+        auto downscale = owner.frameCacheDownscale.load();
+        
+        if (downscale > 1)
+            frame = frame.rescaled (jmax (1, buffer.width / downscale), jmax (1, buffer.height / downscale),
+                                    Graphics::mediumResamplingQuality);
+        
+        auto time = owner.getMediaTimeForPresentation (buffer.presentationPosition);
+        owner.frameCache->add (buffer.mediaId, owner.getFrameCacheTime (time), frame);
+    }
     
-    if (currentMedia == nullptr)
+    static void growBuffers (FrameIntake& intake)
     {
-        if (error != nullptr)
-            *error = "Failed to create libVLC media from file";
-        return false;
+        auto required = intake.requiredCapacity.load();
+        
+        for (auto& buffer : intake.buffers)
+        {
+            int expected = FrameIntake::bufferFree;
+            
+            if (buffer.capacity < required && buffer.state.compare_exchange_strong (expected, FrameIntake::bufferBusy))
+            {
+                buffer.pixels.allocate (required, false);
+                buffer.capacity = required;
+                buffer.state = FrameIntake::bufferFree;
+            }
+        }
     }
     
-    // Set media to player
-    libvlc_media_player_set_media (mediaPlayer, currentMedia);
+    VLCMediaPlayer& owner;
+    
+    JUCE_DECLARE_NON_COPYABLE (FrameCacheWriter)
+};
+
+//==============================================================================
+/**
+ * Bytes for libvlc_media_new_callbacks. libVLC opens a reader for each pass over
+ * the media, and parsing can overlap playback, so every reader keeps its own
+ * position and reads are positional. Deleted when libVLC frees the media.
+ */
+class VLCMediaPlayer::MediaSource
+{
+public:
+    virtual ~MediaSource() = default;
     
-    // Setup callbacks
-    setupAudioCallbacks();
-    setupVideoCallbacks();
+    /** Returns the total size in bytes, or UINT64_MAX if it isn't known. */
+    virtual uint64_t getSize() = 0;
     
-    // Parse media to get information (use simpler API for compatibility)
-    DBG("VLCMediaPlayer::open - Starting media parsing");
-    libvlc_media_parse (currentMedia);
+    /** Returns the number of bytes read, 0 at the end, or -1 on error. Called on libVLC's input threads. */
+    virtual int64_t read (uint64_t position, void* destination, size_t numBytes) = 0;
     
-    // Wait a bit for parsing to complete, then update media information
-    // Note: libvlc_media_parse is asynchronous, so we need to wait
-    juce::Thread::sleep(50);  // Give VLC some time to start parsing
+    static int openCallback (void* opaque, void** data, uint64_t* size)
+    {
+        auto* source = static_cast<MediaSource*>(opaque);
+        *data = new Reader { source, 0 };
+        *size = source->getSize();
+        return 0;
+    }
     
-    // Update media information
-    updateMediaInfo();
+    static ssize_t readCallback (void* data, unsigned char* buffer, size_t length)
+    {
+        auto* reader = static_cast<Reader*>(data);
+        auto numRead = reader->source->read (reader->position, buffer, length);
+        
+        if (numRead > 0)
+            reader->position += static_cast<uint64_t>(numRead);
+        
+        return static_cast<ssize_t>(numRead);
+    }
     
-    DBG("VLCMediaPlayer::open - Media parsing and info update completed");
+    static int seekCallback (void* data, uint64_t offset)
+    {
+        auto* reader = static_cast<Reader*>(data);
+        auto size = reader->source->getSize();
+        
+        if (size != std::numeric_limits<uint64_t>::max() && offset > size)
+            return -1;
+        
+        reader->position = offset;
+        return 0;
+    }
     
-    return true;
-}
+    static void closeCallback (void* data)
+    {
+        delete static_cast<Reader*>(data);
+    }
+    
+    static void mediaFreedCallback (const libvlc_event_t*, void* opaque)
+    {
+        delete static_cast<MediaSource*>(opaque);
+    }
+    
+private:
+    struct Reader
+    {
+        MediaSource* source;
+        uint64_t position;
+    };
+};
 
-void VLCMediaPlayer::close()
+/** Media that's already in memory: a MemoryBlock, a mapped file or a caller's buffer, read in place. */
+class VLCMediaPlayer::MemorySource : public MediaSource
 {
-    stop();
-    
-    if (mediaPlayer != nullptr)
+public:
+    MemorySource (const void* dataToRead, size_t numBytes, std::shared_ptr<void> ownerToKeepAlive)
+        : data (static_cast<const uint8_t*>(dataToRead)), size (numBytes), owner (std::move (ownerToKeepAlive))
     {
-        libvlc_media_player_set_media (mediaPlayer, nullptr);
     }
     
-    if (currentMedia != nullptr)
+    uint64_t getSize() override
     {
-        libvlc_media_release (currentMedia);
-        currentMedia = nullptr;
+        return static_cast<uint64_t>(size);
     }
     
-    // Reset state
-    hasVideoStream = false;
-    hasAudioStream = false;
-    mediaDuration = -1.0;
-    totalAudioSamples = -1;
-    currentAudioSample = 0;
-    videoWidth = 0;
-    videoHeight = 0;
+    int64_t read (uint64_t position, void* destination, size_t numBytes) override
+    {
+        if (position >= size)
+            return 0;
+        
+        auto numToRead = jmin (numBytes, size - static_cast<size_t>(position));
+        memcpy (destination, data + position, numToRead);
+        return static_cast<int64_t>(numToRead);
+    }
     
-    if (audioRingBuffer != nullptr)
-        audioRingBuffer->clear();
-}
+private:
+    const uint8_t* data;
+    size_t size;
+    std::shared_ptr<void> owner;
+};
 
-//==============================================================================
-void VLCMediaPlayer::play()
+/** Media read from a juce::InputStream, shared between libVLC's readers. */
+class VLCMediaPlayer::StreamSource : public MediaSource
 {
-    if (mediaPlayer != nullptr && currentMedia != nullptr)
+public:
+    explicit StreamSource (std::unique_ptr<InputStream> streamToRead)
+        : stream (std::move (streamToRead))
     {
-        DBG ("Starting playback...");
-        
-        // Make sure video output is set up before playing
-        setupVideoOutput();
+    }
+    
+    uint64_t getSize() override
+    {
+        const ScopedLock sl (lock);
+        auto length = stream->getTotalLength();
+        return length >= 0 ? static_cast<uint64_t>(length) : std::numeric_limits<uint64_t>::max();
+    }
+    
+    int64_t read (uint64_t position, void* destination, size_t numBytes) override
+    {
+        const ScopedLock sl (lock);
         
-        libvlc_media_player_play (mediaPlayer);
-        isCurrentlyPlaying = true;
+        // Readers take turns with the one stream, so each puts it back where it left off
+        if (static_cast<uint64_t>(stream->getPosition()) != position && ! stream->setPosition (static_cast<int64>(position)))
+            return -1;
         
-        DBG ("Playback started successfully");
+        auto numToRead = static_cast<int>(jmin (numBytes, static_cast<size_t>(std::numeric_limits<int>::max())));
+        return stream->read (destination, numToRead);
     }
-}
+    
+private:
+    std::unique_ptr<InputStream> stream;
+    CriticalSection lock;
+};
 
-void VLCMediaPlayer::pause()
+//==============================================================================
+int VLCMediaPlayer::VideoFramePool::getPlaneLayout (VideoPixelFormat format, int width, int height,
+                                                    int* pitches, int* lines)
 {
-    if (mediaPlayer != nullptr)
+    if (format == VideoPixelFormat::RGB32)
     {
-        libvlc_media_player_pause (mediaPlayer);
-        isCurrentlyPlaying = false;
+        pitches[0] = width * 4; // 4 bytes per pixel for RGBA
+        lines[0] = height;
+        return 1;
     }
-}
-
-void VLCMediaPlayer::stop()
-{
-    if (mediaPlayer != nullptr)
+    
+    // 4:2:0 chroma needs even luma dimensions; 32-byte rows keep SIMD and GPU uploads aligned
+    int lumaPitch = (width + 31) & ~31;
+    int lumaLines = (height + 1) & ~1;
+    
+    pitches[0] = lumaPitch;
+    lines[0] = lumaLines;
+    
+    if (format == VideoPixelFormat::NV12)
     {
-        libvlc_media_player_stop (mediaPlayer);
-        isCurrentlyPlaying = false;
-        currentAudioSample = 0;
-        
-        if (audioRingBuffer != nullptr)
-            audioRingBuffer->clear();
+        pitches[1] = lumaPitch;             // Interleaved U/V at half horizontal resolution
+        lines[1] = lumaLines / 2;
+        return 2;
     }
+    
+    pitches[1] = pitches[2] = lumaPitch / 2;
+    lines[1] = lines[2] = lumaLines / 2;
+    return 3;
 }
 
-bool VLCMediaPlayer::isPlaying() const
+void VLCMediaPlayer::VideoFramePool::setFormat (int width, int height, VideoPixelFormat format)
 {
-    return isCurrentlyPlaying.load();
+    // Slots are resized lazily by whoever owns them, so nothing is freed under a reader
+    formatWidth = width;
+    formatHeight = height;
+    formatPixelFormat = static_cast<int>(format);
 }
 
-//==============================================================================
-bool VLCMediaPlayer::seekToSample (int64_t sampleIndex, SeekMode mode)
+void VLCMediaPlayer::VideoFramePool::reset()
 {
-    if (mediaPlayer == nullptr || !hasAudioStream.load())
-        return false;
+    // Only safe once libVLC has stopped calling into the pool. The reader may still be
+    // on a slot, so that one is left to it; it lets go once it sees the reset.
+    latestSlot = -1;
     
-    double sampleRate = currentSampleRate.load();
-    if (sampleRate <= 0.0)
-        return false;
+    for (auto& slot : slots)
+    {
+        for (auto from : { slotReady, slotWriting })
+        {
+            int expected = from;
+            slot.state.compare_exchange_strong (expected, slotFree, std::memory_order_acq_rel);
+        }
+    }
     
-    double timeInSeconds = static_cast<double>(sampleIndex) / sampleRate;
-    return seekToTime (timeInSeconds, mode);
+    resetCount.fetch_add (1, std::memory_order_release);
 }
 
-bool VLCMediaPlayer::seekToTime (double timeInSeconds, SeekMode)
+void VLCMediaPlayer::VideoFramePool::releaseMemory()
 {
-    if (mediaPlayer == nullptr || currentMedia == nullptr)
-        return false;
-    
-    // Increment seek generation to cancel any in-flight seeks
-    ++seekGeneration;
-    
-    // Convert to milliseconds
-    int64_t timeInMs = static_cast<int64_t>(timeInSeconds * 1000.0);
+    reset();
     
-    // Use libVLC seeking (compatible with 3.x and 4.x)
-    libvlc_media_player_set_time (mediaPlayer, timeInMs);
-    int result = 0; // Assume success for now
+    auto release = [] (Slot& slot)
+    {
+        slot.image = {};
+        slot.planarData.free();
+        slot.numPlanes = 0;
+        std::fill (std::begin (slot.planes), std::end (slot.planes), nullptr);
+    };
     
-    if (result == 0)
+    for (auto& slot : slots)
     {
-        // Clear audio buffer on seek to prevent stale audio
-        if (audioRingBuffer != nullptr)
-            audioRingBuffer->clear();
+        // A held frame keeps its pixels until its last VideoFrame goes, and claiming the
+        // slot first keeps the reader from picking it up while it's freed
+        int expected = slotFree;
         
-        return true;
+        if (slot.numHolders.load (std::memory_order_acquire) == 0
+             && slot.state.compare_exchange_strong (expected, slotWriting, std::memory_order_acquire))
+        {
+            release (slot);
+            slot.state.store (slotFree, std::memory_order_release);
+        }
     }
     
-    return false;
+    // Only ever written to, never read
+    release (overflowSlot);
 }
 
-//==============================================================================
-void VLCMediaPlayer::setVideoComponent (Component* component)
+bool VLCMediaPlayer::VideoFramePool::isAnyFrameHeld() const
 {
-    videoComponent = component;
-    setupVideoOutput();
+    return std::any_of (std::begin (slots), std::end (slots),
+                        [] (const Slot& slot) { return slot.numHolders.load (std::memory_order_acquire) > 0; });
 }
 
-void VLCMediaPlayer::setAudioDevice (AudioDeviceManager* deviceManager)
+void VLCMediaPlayer::VideoFramePool::preallocate()
 {
-    audioDeviceManager = deviceManager;
-    
-    if (deviceManager != nullptr)
+    // Called at format negotiation, so the lock callback normally finds its slot already sized.
+    // Slots the reader is holding are left alone and sized when they're next written.
+    for (int i = 0; i < numCoreSlots; ++i)
     {
-        // Add this as an audio callback
-        deviceManager->addAudioCallback (this);
+        auto& slot = slots[i];
+        int expected = slotFree;
+        
+        if (slot.numHolders.load (std::memory_order_acquire) == 0
+             && slot.state.compare_exchange_strong (expected, slotWriting, std::memory_order_acquire))
+        {
+            prepareForWriting (slot);
+            slot.state.store (slotFree, std::memory_order_release);
+        }
     }
+    
+    prepareForWriting (overflowSlot);
 }
 
-//==============================================================================
-int VLCMediaPlayer::getSampleRate() const
-{
-    return static_cast<int>(currentSampleRate.load());
-}
-
-int64_t VLCMediaPlayer::getTotalSamples() const
-{
-    return totalAudioSamples.load();
-}
-
-int64_t VLCMediaPlayer::getCurrentSample() const
-{
-    return currentAudioSample.load();
-}
-
-double VLCMediaPlayer::getTotalDuration() const
-{
-    return mediaDuration.load();
-}
-
-double VLCMediaPlayer::getCurrentTime() const
-{
-    double sampleRate = currentSampleRate.load();
-    if (sampleRate > 0.0)
-        return static_cast<double>(getCurrentSample()) / sampleRate;
-    return 0.0;
-}
-
-bool VLCMediaPlayer::hasVideo() const
-{
-    return hasVideoStream.load();
-}
-
-bool VLCMediaPlayer::hasAudio() const
-{
-    return hasAudioStream.load();
-}
-
-Rectangle<int> VLCMediaPlayer::getVideoSize() const
+VLCMediaPlayer::VideoFramePool::Slot* VLCMediaPlayer::VideoFramePool::acquireForWriting()
 {
-    return Rectangle<int> (0, 0, videoWidth.load(), videoHeight.load());
+    // A slot with no holders can only gain one while it's being written, so checking
+    // before claiming it is enough. Spare slots are only used while frames are held.
+    int numUsable = isAnyFrameHeld() ? numSlots : numCoreSlots;
+    
+    for (int i = 0; i < numUsable; ++i)
+    {
+        auto& slot = slots[i];
+        int expected = slotFree;
+        
+        if (slot.numHolders.load (std::memory_order_acquire) == 0
+             && slot.state.compare_exchange_strong (expected, slotWriting, std::memory_order_acquire))
+            return prepareForWriting (slot);
+    }
+    
+    // Every slot is busy: reclaim the published frame the reader hasn't picked up yet
+    int latest = latestSlot.load (std::memory_order_acquire);
+    if (latest >= 0 && slots[latest].numHolders.load (std::memory_order_acquire) == 0)
+    {
+        int expected = slotReady;
+        if (slots[latest].state.compare_exchange_strong (expected, slotWriting, std::memory_order_acquire))
+        {
+            latestSlot.compare_exchange_strong (latest, -1, std::memory_order_acq_rel);
+            return prepareForWriting (slots[latest]);
+        }
+    }
+    
+    // libVLC always needs somewhere to decode into; this frame will be dropped
+    return prepareForWriting (overflowSlot);
 }
 
-//==============================================================================
-void VLCMediaPlayer::addListener (Listener* listener)
+void VLCMediaPlayer::VideoFramePool::publish (Slot* slot)
 {
-    listeners.add (listener);
+    if (slot == nullptr || slot == &overflowSlot)
+        return;
+    
+    int index = static_cast<int> (slot - slots);
+    slot->sequenceNumber = ++publishedFrames;
+    slot->state.store (slotReady, std::memory_order_release);
+    
+    int previous = latestSlot.exchange (index, std::memory_order_acq_rel);
+    if (previous >= 0 && previous != index)
+    {
+        // Give the superseded frame back unless the reader has already claimed it
+        int expected = slotReady;
+        slots[previous].state.compare_exchange_strong (expected, slotFree, std::memory_order_release);
+    }
 }
 
-void VLCMediaPlayer::removeListener (Listener* listener)
+VLCMediaPlayer::VideoFramePool::Slot* VLCMediaPlayer::VideoFramePool::acquireForReading (int64_t showUpTo, int64_t holdUpTo)
 {
-    listeners.remove (listener);
+    // The pool was reset since the last read, so the frame being shown belongs to old media
+    auto resets = resetCount.load (std::memory_order_acquire);
+    
+    if (resets != readerResetCount)
+    {
+        readerResetCount = resets;
+        
+        if (readingSlot >= 0)
+            slots[readingSlot].state.store (slotFree, std::memory_order_release);
+        
+        readingSlot = -1;
+    }
+    
+    int latest = latestSlot.load (std::memory_order_acquire);
+    
+    if (latest >= 0 && latest != readingSlot)
+    {
+        // A frame ahead of the audio waits on screen behind the current one. Far ahead means
+        // it was timed against a schedule that no longer applies, so it's shown anyway.
+        auto presentation = slots[latest].presentationPosition.load (std::memory_order_relaxed);
+        bool isEarly = readingSlot >= 0 && presentation > showUpTo && presentation <= holdUpTo;
+        
+        int expected = slotReady;
+        if (! isEarly && slots[latest].state.compare_exchange_strong (expected, slotReading, std::memory_order_acquire))
+        {
+            if (readingSlot >= 0)
+                slots[readingSlot].state.store (slotFree, std::memory_order_release);
+            
+            readingSlot = latest;
+        }
+    }
+    
+    return readingSlot >= 0 ? &slots[readingSlot] : nullptr;
 }
 
-//==============================================================================
-// AudioIODeviceCallback implementation
-void VLCMediaPlayer::audioDeviceIOCallback (const float** inputChannelData,
-                                           int numInputChannels,
-                                           float** outputChannelData,
-                                           int numOutputChannels,
-                                           int numSamples)
+VLCMediaPlayer::VideoFramePool::Slot* VLCMediaPlayer::VideoFramePool::prepareForWriting (Slot& slot)
 {
-    ignoreUnused (inputChannelData, numInputChannels);
+    int width = jmax (1, formatWidth.load());
+    int height = jmax (1, formatHeight.load());
+    auto format = static_cast<VideoPixelFormat>(formatPixelFormat.load());
     
-    // Clear output buffers first
-    for (int channel = 0; channel < numOutputChannels; ++channel)
+    // Only reallocates after a format change; the slot is exclusively ours here
+    if (slot.numPlanes > 0 && slot.format == format && slot.width == width && slot.height == height)
+        return &slot;
+    
+    slot.format = format;
+    slot.width = width;
+    slot.height = height;
+    slot.numPlanes = getPlaneLayout (format, width, height, slot.pitches, slot.lines);
+    
+    if (format == VideoPixelFormat::RGB32)
     {
-        if (outputChannelData[channel] != nullptr)
-            FloatVectorOperations::clear (outputChannelData[channel], numSamples);
+        // Software images keep a stable pixel pointer with a pitch of width * 4,
+        // which is what videoFormatCallback promises libVLC
+        slot.image = juce::Image (juce::Image::ARGB, width, height, true, SoftwareImageType());
+        juce::Image::BitmapData bitmapData (slot.image, juce::Image::BitmapData::readWrite);
+        slot.planes[0] = bitmapData.data;
+        slot.planarData.free();
+    }
+    else
+    {
+        size_t totalSize = 0;
+        for (int plane = 0; plane < slot.numPlanes; ++plane)
+            totalSize += static_cast<size_t>(slot.pitches[plane]) * static_cast<size_t>(slot.lines[plane]);
+        
+        slot.image = {};
+        slot.planarData.allocate (totalSize, false);
+        
+        // All planes live in one block, back to back
+        uint8_t* plane = slot.planarData.get();
+        for (int i = 0; i < slot.numPlanes; ++i)
+        {
+            slot.planes[i] = plane;
+            plane += static_cast<size_t>(slot.pitches[i]) * static_cast<size_t>(slot.lines[i]);
+        }
     }
     
-    if (audioRingBuffer == nullptr || !hasAudioStream.load() || !isPlaying())
-        return;
+    DBG("VLCMediaPlayer::VideoFramePool - Allocated frame slot: " + 
+        juce::String(width) + "x" + juce::String(height) + ", " + juce::String(slot.numPlanes) + " plane(s)");
     
-    int numChannels = jmin (numOutputChannels, audioRingBuffer->numChannels);
-    int availableSamples = audioRingBuffer->availableSamples.load();
-    int samplesToRead = jmin (numSamples, availableSamples);
+    return &slot;
+}
+
+//==============================================================================
+bool VLCMediaPlayer::FrameIntake::offer (const VideoFramePool::Slot& slot, uint64 mediaId)
+{
+    auto rowBytes = static_cast<size_t>(slot.width) * 4;
+    auto bytes = rowBytes * static_cast<size_t>(slot.height);
     
-    if (samplesToRead > 0)
+    for (auto& buffer : buffers)
     {
-        int readPos = audioRingBuffer->readPosition.load();
+        int expected = bufferFree;
         
-        for (int channel = 0; channel < numChannels; ++channel)
+        // Claimed before its capacity is read, since FrameCacheWriter grows buffers it has claimed
+        if (! buffer.state.compare_exchange_strong (expected, bufferBusy, std::memory_order_acquire))
+            continue;
+        
+        if (buffer.capacity < bytes)
         {
-            float* dest = outputChannelData[channel];
-            float* src = audioRingBuffer->data[channel];
-            
-            for (int i = 0; i < samplesToRead; ++i)
-            {
-                dest[i] = src[(readPos + i) % audioRingBuffer->numSamples];
-            }
+            buffer.state.store (bufferFree, std::memory_order_release);
+            continue;
         }
         
-        // Update read position
-        int newReadPos = (readPos + samplesToRead) % audioRingBuffer->numSamples;
-        audioRingBuffer->readPosition = newReadPos;
-        audioRingBuffer->availableSamples = availableSamples - samplesToRead;
+        for (int y = 0; y < slot.height; ++y)
+            memcpy (buffer.pixels + static_cast<size_t>(y) * rowBytes, slot.planes[0] + y * slot.pitches[0], rowBytes);
         
-        // Update current sample position
-        currentAudioSample += samplesToRead;
+        buffer.width = slot.width;
+        buffer.height = slot.height;
+        buffer.presentationPosition = slot.presentationPosition.load (std::memory_order_relaxed);
+        buffer.mediaId = mediaId;
+        buffer.state.store (bufferFilled, std::memory_order_release);
+        frameOffered.signal();
+        return true;
     }
+    
+    // Nothing free that's big enough: the writer grows the buffers, and this frame is missed
+    if (requiredCapacity.load() < bytes)
+    {
+        requiredCapacity = bytes;
+        frameOffered.signal();
+    }
+    
+    return false;
 }
 
-void VLCMediaPlayer::audioDeviceIOCallbackWithContext (const float* const* inputChannelData,
-                                                      int numInputChannels,
-                                                      float* const* outputChannelData,
-                                                      int numOutputChannels,
-                                                      int numSamples,
-                                                      const AudioIODeviceCallbackContext& context)
+//==============================================================================
+VLCMediaPlayer::VLCMediaPlayer()
+    : VLCMediaPlayer (VLCInstanceManager::getDefaultArguments())
 {
-    ignoreUnused (context);
-    // Delegate to the main callback
-    audioDeviceIOCallback (const_cast<const float**>(inputChannelData), numInputChannels, 
-                          const_cast<float**>(outputChannelData), numOutputChannels, numSamples);
 }
 
-void VLCMediaPlayer::audioDeviceAboutToStart (AudioIODevice* device)
+VLCMediaPlayer::VLCMediaPlayer (const StringArray& vlcArguments)
 {
-    ignoreUnused (device);
-    // Audio preparation is handled by libVLC callbacks
+    initializeVLC (vlcArguments);
+    
+    // Stereo until libVLC says otherwise; audioSetupCallback resizes it for each media
+    audioRingBuffer = std::make_unique<AudioBuffer> (2, getRingCapacity());
+    
+    // Position updates are driven by libVLC events; the timer only runs while playing
 }
 
-void VLCMediaPlayer::audioDeviceStopped()
+VLCMediaPlayer::~VLCMediaPlayer()
 {
-    // Resources are managed by libVLC
+    if (RealtimeChecks::isEnabled())
+        DBG ("VLCMediaPlayer - Realtime callback checks:" + String (newLine) + RealtimeChecks::getSummary());
+    
+    if (videoComponent != nullptr)
+        videoComponent->removeComponentListener (this);
+    
+    setAudioDevice (nullptr);
+    frameCacheWriter = nullptr;
+    close();
+    shutdownVLC();
 }
 
-void VLCMediaPlayer::audioDeviceError (const String& errorMessage)
+//==============================================================================
+void VLCMediaPlayer::initializeVLC (const StringArray& vlcArguments)
 {
-    DBG ("Audio device error: " + errorMessage);
-    // Handle audio device errors if needed
+    // Instances are shared between players created with the same arguments,
+    // so only the first player pays for plugin loading
+    sharedInstance = VLCInstanceManager::getInstance (vlcArguments);
+    
+    if (sharedInstance == nullptr)
+    {
+        DBG ("VLCMediaPlayer::initializeVLC - No libVLC instance available");
+        return;
+    }
+    
+    vlcInstance = sharedInstance->get();
+    
+    liveDeck = createDeck();
+    if (liveDeck == nullptr)
+        return;
+    
+    liveDeck->isLive = true;
+    mediaPlayer = liveDeck->player;
+    videoFramePool = &liveDeck->framePool;
+    
+    setupEventHandling();
 }
 
-//==============================================================================
-// Timer callback for position updates
-void VLCMediaPlayer::timerCallback()
+void VLCMediaPlayer::shutdownVLC()
 {
-    updateAudioPosition();
+    cancelPreload();
+    
+    // Stop playback first to prevent callbacks during destruction
+    if (mediaPlayer != nullptr)
+        removeEventHandling();
+    
+    if (standbyDeck != nullptr)
+        releaseDeck (*standbyDeck);
+    
+    if (liveDeck != nullptr)
+        releaseDeck (*liveDeck);
+    
+    // Outstanding VideoFrames point into the decks' pools, so those are only freed once they're released
+    for (auto* deck : { &standbyDeck, &liveDeck })
+    {
+        if (*deck != nullptr && ! waitForFrameHandles (**deck, 2000))
+        {
+            DBG ("VLCMediaPlayer::shutdownVLC - A VideoFrame outlived its player; leaking its frame pool");
+            jassertfalse;
+            ignoreUnused (deck->release());
+        }
+    }
+    
+    mediaPlayer = nullptr;
+    videoFramePool = nullptr;
+    standbyDeck = nullptr;
+    liveDeck = nullptr;
+    
+    if (currentMedia != nullptr)
+    {
+        libvlc_media_release (currentMedia);
+        currentMedia = nullptr;
+    }
+    
+    // The instance itself is only released once no other player uses it
+    vlcInstance = nullptr;
+    VLCInstanceManager::releaseInstance (sharedInstance);
 }
 
-//==============================================================================
-// libVLC Audio Callbacks
-void* VLCMediaPlayer::audioLockCallback (void* data, void** pcm_buffer, size_t size)
+std::unique_ptr<VLCMediaPlayer::Deck> VLCMediaPlayer::createDeck()
 {
-    // Safety check to prevent accessing freed memory
-    if (data == nullptr || pcm_buffer == nullptr)
+    if (vlcInstance == nullptr)
         return nullptr;
-        
-    auto* player = static_cast<VLCMediaPlayer*>(data);
     
-    // Additional safety check
-    if (player == nullptr)
+    auto deck = std::make_unique<Deck> (*this);
+    deck->player = libvlc_media_player_new (vlcInstance);
+    
+    if (deck->player == nullptr)
+    {
+        DBG ("Failed to create libVLC media player");
+        const char* vlcError = libvlc_errmsg();
+        if (vlcError != nullptr)
+        {
+            DBG ("libVLC error: " + juce::String(vlcError));
+        }
         return nullptr;
+    }
     
-    // Allocate temporary buffer for this audio block
-    static thread_local std::vector<uint8_t> tempBuffer;
-    tempBuffer.resize (size);
-    *pcm_buffer = tempBuffer.data();
+    // Every deck on the instance hears every decoder; each only listens while its media is starting
+    sharedInstance->addDecoderListener (deck.get());
     
-    return tempBuffer.data();
+    DBG ("libVLC media player created successfully!");
+    return deck;
 }
 
-void VLCMediaPlayer::audioUnlockCallback (void* data, void* pcm_buffer, size_t size)
+void VLCMediaPlayer::releaseDeck (Deck& deck)
 {
-    // Safety check to prevent accessing freed memory
-    if (data == nullptr)
+    if (deck.player == nullptr)
         return;
-        
-    auto* player = static_cast<VLCMediaPlayer*>(data);
     
-    // Additional safety check
-    if (player == nullptr)
-        return;
-        
-    player->processAudioData (pcm_buffer, size);
+    deck.isLive = false;
+    sharedInstance->removeDecoderListener (&deck);
+    libvlc_media_player_stop (deck.player);
+    
+    // Clear all callbacks before releasing to prevent memory corruption
+    libvlc_video_set_callbacks (deck.player, nullptr, nullptr, nullptr, nullptr);
+    libvlc_video_set_format_callbacks (deck.player, nullptr, nullptr);
+    libvlc_audio_set_callbacks (deck.player, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+    
+    // Wait a bit for any running callbacks to finish
+    juce::Thread::sleep (50);
+    
+    libvlc_media_player_release (deck.player);
+    deck.player = nullptr;
 }
 
-void VLCMediaPlayer::audioPlayCallback (void* data, void* pcm_buffer, size_t size)
+bool VLCMediaPlayer::waitForFrameHandles (Deck& deck, int timeoutMs)
 {
-    // Audio is handled through JUCE's audio system, not directly played here
-    ignoreUnused (data, pcm_buffer, size);
+    // libVLC has stopped, so no new handles can appear; the holders just have to finish
+    auto deadline = Time::getMillisecondCounter() + static_cast<uint32>(timeoutMs);
+    
+    while (deck.framePool.isAnyFrameHeld())
+    {
+        if (Time::getMillisecondCounter() >= deadline)
+            return false;
+        
+        Thread::sleep (1);
+    }
+    
+    return true;
 }
 
-void VLCMediaPlayer::audioPauseCallback (void* data, int64_t pts)
+//==============================================================================
+bool VLCMediaPlayer::open (const File& media, String* error)
 {
-    ignoreUnused (data, pts);
-}
+    close();
+    
+    // A prerolled file only needs its deck swapping in
+    if (standbyMedia != nullptr && media == preloadedFile)
+    {
+        DBG("VLCMediaPlayer::open - Switching to preloaded media");
+        promoteStandbyDeck (false);
+        startKeyframeIndexing (media);
+        currentFile = media;
+        updateTimerState();
+        return true;
+    }
+    
+    if (!media.exists())
+    {
+        if (error != nullptr)
+            *error = "File does not exist: " + media.getFullPathName();
+        return false;
+    }
+    
+    if (vlcInstance == nullptr || mediaPlayer == nullptr)
+    {
+        if (error != nullptr)
+            *error = "libVLC not initialized";
+        return false;
+    }
+    
+    // Create media from file path
+    auto mediaPath = media.getFullPathName().toUTF8();
+    
+    if (! startMedia (libvlc_media_new_path (vlcInstance, mediaPath.getAddress()), libvlc_media_parse_local, error))
+        return false;
+    
+    startKeyframeIndexing (media);
+    currentFile = media;
+    updateTimerState();
+    return true;
+}
+
+bool VLCMediaPlayer::open (std::unique_ptr<InputStream> stream, String* error)
+{
+    if (stream == nullptr)
+    {
+        if (error != nullptr)
+            *error = "No stream to open";
+        return false;
+    }
+    
+    // Memory streams can be read in place, like any other block of memory
+    if (auto* memoryStream = dynamic_cast<MemoryInputStream*> (stream.get()))
+        return openSource (std::make_unique<MemorySource> (memoryStream->getData(), memoryStream->getDataSize(),
+                                                           std::move (stream)), error);
+    
+    return openSource (std::make_unique<StreamSource> (std::move (stream)), error);
+}
+
+bool VLCMediaPlayer::open (MemoryBlock data, String* error)
+{
+    auto block = std::make_shared<MemoryBlock> (std::move (data));
+    return openSource (std::make_unique<MemorySource> (block->getData(), block->getSize(), block), error);
+}
+
+bool VLCMediaPlayer::open (const void* data, size_t numBytes, String* error)
+{
+    return openSource (std::make_unique<MemorySource> (data, numBytes, nullptr), error);
+}
+
+bool VLCMediaPlayer::open (std::unique_ptr<MemoryMappedFile> mappedFile, String* error)
+{
+    if (mappedFile == nullptr || mappedFile->getData() == nullptr)
+    {
+        if (error != nullptr)
+            *error = "File could not be mapped";
+        return false;
+    }
+    
+    auto* data = mappedFile->getData();
+    auto size = mappedFile->getSize();
+    return openSource (std::make_unique<MemorySource> (data, size, std::move (mappedFile)), error);
+}
+
+bool VLCMediaPlayer::open (const URL& url, String* error)
+{
+    if (url.isLocalFile())
+        return open (url.getLocalFile(), error);
+    
+    close();
+    
+    if (vlcInstance == nullptr || mediaPlayer == nullptr)
+    {
+        if (error != nullptr)
+            *error = "libVLC not initialized";
+        return false;
+    }
+    
+    // libVLC fetches the location itself, with its own access modules (http, rtsp, smb, ...)
+    if (! startMedia (libvlc_media_new_location (vlcInstance, url.toString (true).toRawUTF8()),
+                      libvlc_media_parse_network, error))
+        return false;
+    
+    updateTimerState();
+    return true;
+}
+
+bool VLCMediaPlayer::openSource (std::unique_ptr<MediaSource> source, String* error)
+{
+    close();
+    
+    if (vlcInstance == nullptr || mediaPlayer == nullptr)
+    {
+        if (error != nullptr)
+            *error = "libVLC not initialized";
+        return false;
+    }
+    
+    // libVLC may open the source more than once (to parse and to play), and its parser can
+    // outlive our reference to the media, so the source is deleted when the media itself is
+    auto* media = libvlc_media_new_callbacks (vlcInstance, MediaSource::openCallback, MediaSource::readCallback,
+                                              MediaSource::seekCallback, MediaSource::closeCallback, source.get());
+    
+    if (media != nullptr)
+        libvlc_event_attach (libvlc_media_event_manager (media), libvlc_MediaFreed,
+                             MediaSource::mediaFreedCallback, source.release());
+    
+    if (! startMedia (media, libvlc_media_parse_local, error))
+        return false;
+    
+    updateTimerState();
+    return true;
+}
+
+bool VLCMediaPlayer::startMedia (libvlc_media_t* media, int parseFlags, String* error)
+{
+    currentMedia = media;
+    
+    if (currentMedia == nullptr)
+    {
+        if (error != nullptr)
+            *error = "Failed to create libVLC media";
+        return false;
+    }
+    
+    applyLatencyProfile (currentMedia);
+    applyDecoderSettings (currentMedia);
+    applyOpenOptions (currentMedia);
+    liveDeck->openOptions = openOptions;
+    liveDeck->resetDecoderInfo (true);
+    
+    // Frames from earlier media would otherwise stay allocated for as long as the player lives
+    if (! openOptions.decodeVideo)
+        liveDeck->framePool.releaseMemory();
+    
+    // Set media to player
+    libvlc_media_player_set_media (mediaPlayer, currentMedia);
+    
+    // Setup callbacks and video output (memory callbacks or a native window)
+    setupAudioCallbacks (*liveDeck);
+    setupVideoOutput();
+    
+    // Parse in the background; vlcEventCallback hears when libVLC is done or gives up
+    libvlc_event_attach (libvlc_media_event_manager (currentMedia),
+                         libvlc_MediaParsedChanged, vlcEventCallback, this);
+    
+    DBG("VLCMediaPlayer::open - Starting asynchronous media parsing");
+    
+    if (libvlc_media_parse_with_options (currentMedia, static_cast<libvlc_media_parse_flag_t>(parseFlags),
+                                         parseTimeoutMs.load()) != 0)
+    {
+        // Playback still works; metadata will just stay unknown
+        DBG("VLCMediaPlayer::open - Could not start media parsing");
+        notifyListeners ([this](Listener* l) { l->mediaError (this, "Failed to start reading media information"); });
+    }
+    
+    return true;
+}
+
+void VLCMediaPlayer::close()
+{
+    removeAudioStems();
+    applyPlaybackRate (1.0);
+    stop();
+    releaseCurrentMedia();
+    stopKeyframeIndexing();
+    
+    audioTracks.clear();
+    selectedAudioTrack = -1;
+    currentFile = File();
+    
+    switchAtEnd = false;
+    resumeAfterPreroll = false;
+    outputRenegotiationPending = false;
+    requestedSeekTime = -1.0;
+    parkedTransportPosition = -1.0;
+    wasTransportPlaying = false;
+    numAudioUnderruns = 0;
+    stats.reset();
+    pendingParseStatus = 0;
+    
+    if (liveDeck != nullptr)
+        liveDeck->resetDecoderInfo (false);
+    
+    pendingEvents = 0;
+    seekInProgress = false;
+    
+    {
+        std::lock_guard<std::mutex> lock (stateMutex);
+        hasPendingSeek = false;
+        isSeekInFlight = false;
+        inFlightSeekIsPreview = false;
+    }
+    
+    cancelPendingUpdate();
+    stopTimer();
+    
+    // Reset state
+    hasVideoStream = false;
+    hasAudioStream = false;
+    mediaDuration = -1.0;
+    totalAudioSamples = -1;
+    videoWidth = 0;
+    videoHeight = 0;
+    videoFrameRate = 0.0;
+    resetFrameCache();
+    
+    setClockAnchor (0, true);
+    
+    if (auto* pool = videoFramePool.load())
+        pool->reset();
+}
+
+void VLCMediaPlayer::releaseCurrentMedia()
+{
+    if (mediaPlayer != nullptr)
+    {
+        libvlc_media_player_set_media (mediaPlayer, nullptr);
+    }
+    
+    if (currentMedia != nullptr)
+    {
+        // After detaching, no parse notification for this media can arrive
+        libvlc_media_parse_stop (currentMedia);
+        libvlc_event_detach (libvlc_media_event_manager (currentMedia),
+                             libvlc_MediaParsedChanged, vlcEventCallback, this);
+        
+        libvlc_media_release (currentMedia);
+        currentMedia = nullptr;
+    }
+}
+
+//==============================================================================
+void VLCMediaPlayer::play()
+{
+    if (mediaPlayer != nullptr && currentMedia != nullptr)
+    {
+        DBG ("Starting playback...");
+        
+        // Make sure video output is set up before playing
+        setupVideoOutput();
+        
+        libvlc_media_player_play (mediaPlayer);
+        isCurrentlyPlaying = true;
+        updateAudioStems();
+        
+        DBG ("Playback started successfully");
+    }
+}
+
+void VLCMediaPlayer::pause()
+{
+    if (mediaPlayer != nullptr)
+    {
+        libvlc_media_player_pause (mediaPlayer);
+        isCurrentlyPlaying = false;
+        updateAudioStems();
+    }
+}
+
+void VLCMediaPlayer::stop()
+{
+    if (mediaPlayer != nullptr)
+    {
+        libvlc_media_player_stop (mediaPlayer);
+        isCurrentlyPlaying = false;
+        setClockAnchor (0, true);
+        updateAudioStems();
+    }
+}
+
+bool VLCMediaPlayer::isPlaying() const
+{
+    return isCurrentlyPlaying.load();
+}
+
+//==============================================================================
+bool VLCMediaPlayer::seekToSample (int64_t sampleIndex, SeekMode mode)
+{
+    if (mediaPlayer == nullptr || !hasAudioStream.load())
+        return false;
+    
+    double sampleRate = currentSampleRate.load();
+    if (sampleRate <= 0.0)
+        return false;
+    
+    double timeInSeconds = static_cast<double>(sampleIndex) / sampleRate;
+    return seekToTime (timeInSeconds, mode);
+}
+
+bool VLCMediaPlayer::seekToTime (double timeInSeconds, SeekMode mode)
+{
+    if (mediaPlayer == nullptr || currentMedia == nullptr || ! libvlc_media_player_is_seekable (mediaPlayer))
+        return false;
+    
+    {
+        std::lock_guard<std::mutex> lock (stateMutex);
+        
+        // Each request supersedes the previous one; its generation marks older results as stale
+        pendingSeek = { timeInSeconds, mode, ++seekGeneration };
+        requestedSeekTime = timeInSeconds;
+        hasPendingSeek = true;
+        
+        // A burst of requests is timed from its first one
+        int64 notTiming = 0;
+        stats.seekRequestedAt.compare_exchange_strong (notTiming, Time::getHighResolutionTicks());
+        stats.isAwaitingSeekFrame = false;
+        
+        // While a seek is still landing, this request just waits in its place
+        if (! isSeekInFlight)
+            issuePendingSeek (false);
+    }
+    
+    // The timer times out seeks libVLC never reports, so it has to be running even when
+    // the request came from another thread
+    if (MessageManager::getInstanceWithoutCreating() != nullptr
+         && MessageManager::getInstanceWithoutCreating()->isThisTheMessageThread())
+    {
+        updateTimerState();
+        updateAudioStems();
+    }
+    else
+    {
+        postEvent (pendingSeekScheduled);
+    }
+    
+    return true;
+}
+
+void VLCMediaPlayer::issuePendingSeek (bool isCoalesced)
+{
+    // Called with stateMutex held
+    auto request = pendingSeek;
+    hasPendingSeek = false;
+    
+    auto target = request.time;
+    auto modeToUse = request.mode;
+    inFlightSeekIsPreview = false;
+    
+    if (auto index = getKeyframeIndex())
+    {
+        if (request.mode == SeekMode::Fast)
+        {
+            // Fast seeks land on a keyframe, so the decoder has nothing to preroll
+            target = index->getNearestKeyframe (target);
+        }
+        else if (isCoalesced && scrubPreviewEnabled.load())
+        {
+            // Mid-burst: show the nearest keyframe now and come back for the exact frame
+            target = index->getNearestKeyframe (target);
+            modeToUse = SeekMode::Fast;
+            inFlightSeekIsPreview = target != request.time;
+        }
+    }
+    
+    inFlightSeek = request;
+    isSeekInFlight = true;
+    seekIssuedAt = Time::getMillisecondCounter();
+    issuedSeekGeneration = request.generation;
+    
+    // Convert to milliseconds
+    int64_t timeInMs = static_cast<int64_t>(target * 1000.0);
+    issuedSeekTargetMs = timeInMs;
+    
+    // The first TimeChanged event after libVLC flushes for the seek reports where it landed
+    seekHasFlushed = false;
+    seekInProgress = true;
+    
+   #if LIBVLC_VERSION_INT >= LIBVLC_VERSION (4, 0, 0, 0)
+    // libVLC 4 can skip the preroll itself; Precise decodes forward to the exact frame
+    libvlc_media_player_set_time (mediaPlayer, timeInMs, modeToUse == SeekMode::Fast);
+   #else
+    // libVLC 3 always seeks precisely (unless input-fast-seek is set)
+    ignoreUnused (modeToUse);
+    libvlc_media_player_set_time (mediaPlayer, timeInMs);
+   #endif
+    
+    // Clear audio buffer on seek to prevent stale audio; what arrives next starts at the target
+    setClockAnchor (static_cast<int64_t>(target * currentSampleRate.load()), true);
+}
+
+void VLCMediaPlayer::handleSeekLanded()
+{
+    bool isFinalTarget = false;
+    
+    {
+        std::lock_guard<std::mutex> lock (stateMutex);
+        
+        if (! isSeekInFlight)
+            return;
+        
+        isSeekInFlight = false;
+        
+        // A newer request arrived while this one was landing, so its result is stale
+        bool isStale = landedSeekGeneration.load() != seekGeneration.load();
+        
+        if (isStale && hasPendingSeek)
+        {
+            issuePendingSeek (true);
+        }
+        else if (inFlightSeekIsPreview)
+        {
+            // The burst has settled on a keyframe preview; now go to the exact frame
+            pendingSeek = inFlightSeek;
+            issuePendingSeek (false);
+        }
+        else
+        {
+            isFinalTarget = true;
+        }
+        
+        // How long seeks take to land tells a following transport how far ahead to aim
+        auto tookSeconds = (Time::getMillisecondCounter() - seekIssuedAt) / 1000.0;
+        if (tookSeconds < 1.0)
+            transportSeekLatency = transportSeekLatency * 0.7 + tookSeconds * 0.3;
+    }
+    
+    if (isFinalTarget)
+    {
+        // The next frame presented is the first one from the new position
+        if (stats.seekRequestedAt.load() != 0)
+            stats.isAwaitingSeekFrame = true;
+        
+        auto landedSample = lastSeekLandedSample.load();
+        notifyListeners ([this, landedSample](Listener* l) { l->seekCompleted (this, landedSample); });
+    }
+    
+    updateTimerState();
+}
+
+void VLCMediaPlayer::checkSeekTimeout()
+{
+    bool hasFailed = false;
+    double failedTarget = 0.0;
+    
+    {
+        std::lock_guard<std::mutex> lock (stateMutex);
+        
+        // Slow media can take seconds to land, so the limit grows with how long seeks have been taking
+        auto timeoutMs = static_cast<uint32>(jmax (3000, roundToInt (transportSeekLatency * 8000.0)));
+        
+        if (! isSeekInFlight || Time::getMillisecondCounter() - seekIssuedAt < timeoutMs)
+            return;
+        
+        if (seekHasFlushed.load() && seekInProgress.exchange (false))
+        {
+            // libVLC carried the seek out and only the time report is missing, so it's at the target
+            lastSeekLandedSample = static_cast<int64_t>(static_cast<double>(issuedSeekTargetMs.load())
+                                                          * currentSampleRate.load() / 1000.0);
+            landedSeekGeneration = issuedSeekGeneration.load();
+        }
+        else
+        {
+            // Nothing says where it went (libVLC doesn't report seeks that go nowhere, e.g. to
+            // the current position), so it's given up on rather than reported as landed
+            hasFailed = true;
+            failedTarget = inFlightSeek.time;
+            seekInProgress = false;
+            isSeekInFlight = false;
+            inFlightSeekIsPreview = false;
+            
+            if (hasPendingSeek)
+                issuePendingSeek (false);
+            else
+                stats.seekRequestedAt = 0;
+        }
+    }
+    
+    if (! hasFailed)
+    {
+        handleSeekLanded();
+        return;
+    }
+    
+    auto message = "Seek to " + String (failedTarget, 3) + "s timed out";
+    DBG("VLCMediaPlayer::checkSeekTimeout - " << message);
+    notifyListeners ([this, message](Listener* l) { l->mediaError (this, message); });
+    updateTimerState();
+}
+
+void VLCMediaPlayer::updateTimerState()
+{
+    bool seeking;
+    
+    {
+        std::lock_guard<std::mutex> lock (stateMutex);
+        seeking = isSeekInFlight || hasPendingSeek;
+    }
+    
+    // Poll for smooth position updates (and seek timeouts) while something is happening,
+    // and slowly while media is open, to notice a transport reported from the audio thread
+    int interval = 0;
+    
+    if (isCurrentlyPlaying.load() || seeking || followingTransport.load())
+        interval = 16;
+    else if (currentMedia != nullptr)
+        interval = 100;
+    
+    if (interval == 0)
+        stopTimer();
+    else if (getTimerInterval() != interval)
+        startTimer (interval);
+}
+
+void VLCMediaPlayer::setScrubPreviewEnabled (bool shouldPreview)
+{
+    scrubPreviewEnabled = shouldPreview;
+}
+
+bool VLCMediaPlayer::isScrubPreviewEnabled() const
+{
+    return scrubPreviewEnabled.load();
+}
+
+bool VLCMediaPlayer::isSeeking() const
+{
+    std::lock_guard<std::mutex> lock (stateMutex);
+    return isSeekInFlight || hasPendingSeek;
+}
+
+//==============================================================================
+void VLCMediaPlayer::followTransport (double positionInSeconds, bool isPlaying, double rate)
+{
+    TransportReport::Values report;
+    report.position = positionInSeconds;
+    report.rate = rate;
+    report.reportedAtNs = getHostTimeNs();
+    report.isPlaying = isPlaying;
+    transportReport.publish (report);
+    
+    // The message thread's timer picks this up; waking it here wouldn't be realtime safe
+    followingTransport.store (true, std::memory_order_release);
+}
+
+void VLCMediaPlayer::stopFollowingTransport()
+{
+    followingTransport = false;
+    parkedTransportPosition = -1.0;
+    wasTransportPlaying = false;
+    
+    applyPlaybackRate (1.0);
+    updateTimerState();
+}
+
+bool VLCMediaPlayer::isFollowingTransport() const
+{
+    return followingTransport.load();
+}
+
+void VLCMediaPlayer::setTransportSeekThreshold (double seconds)
+{
+    transportSeekThreshold = jmax (0.0, seconds);
+}
+
+double VLCMediaPlayer::getTransportSeekThreshold() const
+{
+    return transportSeekThreshold.load();
+}
+
+void VLCMediaPlayer::updateTransportFollower()
+{
+    if (! followingTransport.load() || mediaPlayer == nullptr || currentMedia == nullptr)
+        return;
+    
+    TransportReport::Values report;
+    if (! transportReport.read (report))
+        return;     // Mid-publish on every attempt; the next tick gets it
+    
+    auto hostRate = report.rate;
+    auto hostPosition = report.position;
+    bool hostIsPlaying = report.isPlaying && hostRate > 0.0;
+    
+    if (! hostIsPlaying)
+    {
+        wasTransportPlaying = false;
+        
+        if (isPlaying())
+            pause();
+        
+        // Park on the locate point, so the decoder has its frame ready when the host starts.
+        // Repeated locates while one is landing coalesce in the seek scheduler.
+        if (hostPosition != parkedTransportPosition)
+        {
+            parkedTransportPosition = hostPosition;
+            seekToTime (jmax (0.0, hostPosition), SeekMode::Precise);
+        }
+        
+        return;
+    }
+    
+    // Hosts report once per block, so carry the position on to now
+    hostPosition += static_cast<double>(getHostTimeNs() - report.reportedAtNs) / 1.0e9 * hostRate;
+    
+    if (! wasTransportPlaying)
+    {
+        // Already parked at the host's position, so starting is all that's left
+        wasTransportPlaying = true;
+        parkedTransportPosition = -1.0;
+        applyPlaybackRate (hostRate);
+        play();
+        return;
+    }
+    
+    // Drift is meaningless until a seek has landed
+    if (isSeeking())
+        return;
+    
+    auto drift = hostPosition - getCurrentTime();   // Positive when the player is behind
+    
+    if (std::abs (drift) > transportSeekThreshold.load())
+    {
+        // Aim for where the host will be by the time the seek lands
+        applyPlaybackRate (hostRate);
+        seekToTime (jmax (0.0, hostPosition + transportSeekLatency * hostRate), SeekMode::Precise);
+        return;
+    }
+    
+    // Within the threshold, speed up or slow down by up to 5% to close the gap over about a second
+    auto correction = std::abs (drift) <= syncToleranceSeconds.load() ? 0.0 : jlimit (-0.05, 0.05, drift);
+    applyPlaybackRate (hostRate * (1.0 + correction));
+}
+
+void VLCMediaPlayer::applyPlaybackRate (double rate)
+{
+    // Every change makes libVLC's time-stretcher settle again, so tiny ones aren't worth it
+    if (mediaPlayer == nullptr || std::abs (rate - playbackRate.load()) < 0.002)
+        return;
+    
+    if (libvlc_media_player_set_rate (mediaPlayer, static_cast<float>(rate)) == 0)
+        playbackRate = rate;
+}
+
+//==============================================================================
+void VLCMediaPlayer::setVideoComponent (Component* component)
+{
+    if (videoComponent != nullptr)
+        videoComponent->removeComponentListener (this);
+    
+    videoComponent = component;
+    
+    if (component != nullptr)
+        component->addComponentListener (this);
+    
+    updateComponentOutputSize();
+    setupVideoOutput();
+}
+
+void VLCMediaPlayer::setVideoOutputMode (VideoOutputMode mode)
+{
+    videoOutputMode = mode;
+    setupVideoOutput();
+}
+
+VLCMediaPlayer::VideoOutputMode VLCMediaPlayer::getVideoOutputMode() const
+{
+    return videoOutputMode;
+}
+
+void VLCMediaPlayer::setParseTimeout (int timeoutMilliseconds)
+{
+    parseTimeoutMs = jmax (0, timeoutMilliseconds);
+}
+
+int VLCMediaPlayer::getParseTimeout() const
+{
+    return parseTimeoutMs.load();
+}
+
+void VLCMediaPlayer::setOpenOptions (const OpenOptions& options)
+{
+    openOptions = options;
+}
+
+VLCMediaPlayer::OpenOptions VLCMediaPlayer::getOpenOptions() const
+{
+    return openOptions;
+}
+
+//==============================================================================
+bool VLCMediaPlayer::preload (const File& media, String* error)
+{
+    cancelPreload();
+    
+    if (!media.exists())
+    {
+        if (error != nullptr)
+            *error = "File does not exist: " + media.getFullPathName();
+        return false;
+    }
+    
+    if (vlcInstance == nullptr || mediaPlayer == nullptr)
+    {
+        if (error != nullptr)
+            *error = "libVLC not initialized";
+        return false;
+    }
+    
+    preloadedFile = media;
+    
+    // The standby player would need a window of its own to draw its first frame into
+    if (videoOutputMode == VideoOutputMode::NativeWindow)
+        return true;
+    
+    // The standby deck is kept between preloads, so only the first one creates a player
+    if (standbyDeck == nullptr)
+        standbyDeck = createDeck();
+    
+    auto mediaPath = media.getFullPathName().toUTF8();
+    
+    if (standbyDeck != nullptr)
+        standbyMedia = libvlc_media_new_path (vlcInstance, mediaPath.getAddress());
+    
+    if (standbyMedia == nullptr)
+    {
+        if (error != nullptr)
+            *error = "Failed to create libVLC media for preloading";
+        preloadedFile = File();
+        return false;
+    }
+    
+    DBG("VLCMediaPlayer::preload - Prerolling " + media.getFileName());
+    
+    // Decode up to the first frame and hold there until the deck goes live
+    libvlc_media_add_option (standbyMedia, ":start-paused");
+    applyLatencyProfile (standbyMedia);
+    applyDecoderSettings (standbyMedia);
+    applyOpenOptions (standbyMedia);
+    libvlc_media_parse_with_options (standbyMedia, libvlc_media_parse_local, parseTimeoutMs.load());
+    
+    // Without video there's no first frame to wait for; start-paused holds the deck all the same
+    standbyDeck->hasPrerolled = ! openOptions.decodeVideo;
+    standbyDeck->hasAudioOutput = false;
+    standbyDeck->openOptions = openOptions;
+    standbyDeck->resetDecoderInfo (true);
+    
+    if (openOptions.decodeVideo)
+        standbyDeck->framePool.reset();
+    else
+        standbyDeck->framePool.releaseMemory();
+    
+    libvlc_media_player_set_media (standbyDeck->player, standbyMedia);
+    setupAudioCallbacks (*standbyDeck);
+    
+    if (openOptions.decodeVideo)
+        setupVideoCallbacks (*standbyDeck);
+    
+    libvlc_media_player_play (standbyDeck->player);
+    
+    return true;
+}
+
+bool VLCMediaPlayer::queueNext (const File& media, String* error)
+{
+    if (! preload (media, error))
+        return false;
+    
+    switchAtEnd = true;
+    return true;
+}
+
+void VLCMediaPlayer::cancelPreload()
+{
+    switchAtEnd = false;
+    preloadedFile = File();
+    
+    if (standbyDeck != nullptr && standbyDeck->player != nullptr)
+    {
+        // The player itself stays around for the next preload
+        libvlc_media_player_stop (standbyDeck->player);
+        libvlc_media_player_set_media (standbyDeck->player, nullptr);
+    }
+    
+    if (standbyMedia != nullptr)
+    {
+        libvlc_media_parse_stop (standbyMedia);
+        libvlc_media_release (standbyMedia);
+        standbyMedia = nullptr;
+    }
+}
+
+File VLCMediaPlayer::getPreloadedFile() const
+{
+    return preloadedFile;
+}
+
+//==============================================================================
+void VLCMediaPlayer::setKeyframeIndexingEnabled (bool shouldBuildIndex)
+{
+    keyframeIndexingEnabled = shouldBuildIndex;
+}
+
+bool VLCMediaPlayer::isKeyframeIndexingEnabled() const
+{
+    return keyframeIndexingEnabled.load();
+}
+
+std::shared_ptr<const KeyframeIndex> VLCMediaPlayer::getKeyframeIndex() const
+{
+    const SpinLock::ScopedLockType lock (keyframeIndexLock);
+    return keyframeIndex;
+}
+
+double VLCMediaPlayer::getSeekDecodeDistance (double timeInSeconds) const
+{
+    if (auto index = getKeyframeIndex())
+        return index->getDecodeDistance (timeInSeconds);
+    
+    return -1.0;
+}
+
+void VLCMediaPlayer::startKeyframeIndexing (const File& media)
+{
+    stopKeyframeIndexing();
+    
+    if (keyframeIndexingEnabled.load())
+        keyframeIndexBuilder = std::make_unique<KeyframeIndexBuilder> (*this, media);
+}
+
+void VLCMediaPlayer::stopKeyframeIndexing()
+{
+    // Joins the builder, so it can't publish an index for the previous media
+    keyframeIndexBuilder = nullptr;
+    
+    std::shared_ptr<const KeyframeIndex> oldIndex;
+    
+    {
+        const SpinLock::ScopedLockType lock (keyframeIndexLock);
+        std::swap (oldIndex, keyframeIndex);
+    }
+}
+
+void VLCMediaPlayer::switchToQueuedMedia()
+{
+    // Nothing was prerolled in NativeWindow mode, so this is an ordinary open
+    if (standbyMedia == nullptr)
+    {
+        auto next = preloadedFile;
+        cancelPreload();
+        
+        if (open (next))
+            play();
+        
+        return;
+    }
+    
+    DBG("VLCMediaPlayer::switchToQueuedMedia - Switching to " + preloadedFile.getFileName());
+    
+    // Stopping joins the old media's decoder threads. Nothing more reaches the ring,
+    // but what's already in it keeps playing and covers the switch.
+    auto next = preloadedFile;
+    
+    liveDeck->isLive = false;
+    libvlc_media_player_stop (mediaPlayer);
+    releaseCurrentMedia();
+    stopKeyframeIndexing();
+    
+    // The stems and track choice belonged to the old file
+    removeAudioStems();
+    audioTracks.clear();
+    selectedAudioTrack = -1;
+    
+    promoteStandbyDeck (true);
+    startKeyframeIndexing (next);
+    currentFile = next;
+}
+
+void VLCMediaPlayer::promoteStandbyDeck (bool startPlaying)
+{
+    jassert (standbyDeck != nullptr && standbyMedia != nullptr);
+    
+    removeEventHandling();
+    liveDeck->isLive = false;
+    std::swap (liveDeck, standbyDeck);
+    
+    mediaPlayer = liveDeck->player;
+    currentMedia = standbyMedia;
+    standbyMedia = nullptr;
+    preloadedFile = File();
+    switchAtEnd = false;
+    
+    // Options are read when an input starts, so this leaves the prerolled input alone. Later
+    // inputs from this media, after a stop() or at the end, start playing instead of holding
+    // on their first frame. libVLC applies media options in order, so the last one wins.
+    libvlc_media_add_option (currentMedia, ":no-start-paused");
+    
+    hasVideoStream = false;
+    hasAudioStream = liveDeck->hasAudioOutput.load();
+    videoFrameRate = 0.0;
+    resetFrameCache();
+    mediaDuration = -1.0;
+    totalAudioSamples = -1;
+    playbackRate = 1.0;    // The new deck's player starts at normal speed
+    
+    if (liveDeck->audioSampleRate.load() > 0.0)
+        sourceSampleRate = liveDeck->audioSampleRate.load();
+    
+    // The new deck negotiated its channel count on standby; match the ring before it goes live.
+    // Neither deck is writing to the ring at this point.
+    int numChannels = liveDeck->audioChannels.load();
+    
+    // A ring that's merely bigger than needed is kept, so the old media's tail still plays out
+    int capacity = getRingCapacity();
+    
+    if (audioRingBuffer == nullptr || audioRingBuffer->numChannels != numChannels || audioRingBuffer->numSamples < capacity)
+    {
+        auto newBuffer = std::make_unique<AudioBuffer> (numChannels, capacity);
+        
+        const SpinLock::ScopedLockType lock (audioRingBufferLock);
+        std::swap (audioRingBuffer, newBuffer);
+    }
+    
+    numRingChannels = numChannels;
+    
+    // The old media's tail is still playing out of the ring; the new media starts behind it
+    setClockAnchor (0, false);
+    
+    // Readers move over to frames that are already decoded, so there's no black gap
+    videoFramePool = &liveDeck->framePool;
+    
+    int width = liveDeck->framePool.formatWidth.load();
+    int height = liveDeck->framePool.formatHeight.load();
+    
+    if (width > 0 && height > 0)
+        updateVideoSize (width, height);
+    
+    // The standby deck may have settled on its decoder while prerolling
+    if (getDecoderInfo().isKnown)
+        postEvent (pendingDecoderChosen);
+    
+    liveDeck->isLive = true;
+    setupEventHandling();
+    
+    // The standby media may have finished parsing already, in which case no event is coming
+    libvlc_event_attach (libvlc_media_event_manager (currentMedia),
+                         libvlc_MediaParsedChanged, vlcEventCallback, this);
+    
+    auto parsedStatus = libvlc_media_get_parsed_status (currentMedia);
+    if (parsedStatus != 0)
+    {
+        pendingParseStatus = static_cast<int>(parsedStatus);
+        postEvent (pendingMediaParsed);
+    }
+    
+    if (startPlaying)
+    {
+        // If it hasn't reached its first frame yet, start-paused will still hold it there
+        resumeAfterPreroll = ! liveDeck->hasPrerolled.load();
+        
+        libvlc_media_player_set_pause (mediaPlayer, 0);
+        isCurrentlyPlaying = true;
+        startTimer (16);
+    }
+}
+
+void VLCMediaPlayer::setAudioDevice (AudioDeviceManager* deviceManager)
+{
+    // Only one device pulls from the ring at a time
+    if (audioDeviceManager != nullptr)
+        audioDeviceManager->removeAudioCallback (this);
+    
+    audioDeviceManager = deviceManager;
+    
+    if (deviceManager != nullptr)
+    {
+        // Add this as an audio callback
+        deviceManager->addAudioCallback (this);
+    }
+}
+
+//==============================================================================
+int VLCMediaPlayer::getSampleRate() const
+{
+    return static_cast<int>(currentSampleRate.load());
+}
+
+int64_t VLCMediaPlayer::getTotalSamples() const
+{
+    return totalAudioSamples.load();
+}
+
+int64_t VLCMediaPlayer::getCurrentSample() const
+{
+    TimelinePoint::Values delivered;
+    
+    if (hasAudioStream.load() && deliveredClock.read (delivered))
+    {
+        auto sinceBlockNs = getHostTimeNs() - delivered.timeNs;
+        
+        // A clock that's gone quiet means the device isn't pulling audio, so use libVLC's instead
+        if (sinceBlockNs < 500000000)
+        {
+            auto ringRate = jmax (1.0, sourceSampleRate.load());
+            auto elapsed = jmin (static_cast<double>(sinceBlockNs) * ringRate / 1.0e9, static_cast<double>(delivered.span));
+            auto mediaSamplesPerRingSample = currentSampleRate.load() / ringRate * playbackRate.load();
+            return jmax (static_cast<int64_t>(0), delivered.sample + static_cast<int64_t>(elapsed * mediaSamplesPerRingSample));
+        }
+    }
+    
+    return currentAudioSample.load();
+}
+
+double VLCMediaPlayer::getTotalDuration() const
+{
+    return mediaDuration.load();
+}
+
+double VLCMediaPlayer::getCurrentTime() const
+{
+    double sampleRate = currentSampleRate.load();
+    if (sampleRate > 0.0)
+        return static_cast<double>(getCurrentSample()) / sampleRate;
+    return 0.0;
+}
+
+bool VLCMediaPlayer::hasVideo() const
+{
+    return hasVideoStream.load();
+}
+
+bool VLCMediaPlayer::hasAudio() const
+{
+    return hasAudioStream.load();
+}
+
+Rectangle<int> VLCMediaPlayer::getVideoSize() const
+{
+    return Rectangle<int> (0, 0, videoWidth.load(), videoHeight.load());
+}
+
+//==============================================================================
+void VLCMediaPlayer::setSyncTolerance (double seconds)
+{
+    syncToleranceSeconds = jmax (0.0, seconds);
+}
+
+double VLCMediaPlayer::getSyncTolerance() const
+{
+    return syncToleranceSeconds.load();
+}
+
+void VLCMediaPlayer::setClockAnchor (int64_t sample, bool flushRing)
+{
+    // Until the audio thread reaches the anchor this is also what getCurrentSample() reports
+    currentAudioSample = sample;
+    
+    const SpinLock::ScopedLockType lock (audioRingBufferLock);
+    if (audioRingBuffer == nullptr)
+        return;
+    
+    if (flushRing)
+        audioRingBuffer->flush();
+    
+    // The next sample written to the ring is the anchor sample
+    anchorPosition = flushRing ? audioRingBuffer->flushPosition.load (std::memory_order_relaxed)
+                               : audioRingBuffer->head.load (std::memory_order_acquire);
+    anchorSample = sample;
+    ++anchorEpoch;
+}
+
+int64_t VLCMediaPlayer::getPresentationLimit (int64_t& holdUpTo) const
+{
+    holdUpTo = std::numeric_limits<int64_t>::max();
+    
+    // Frames are only held back against a running audio clock
+    TimelinePoint::Values delivered;
+    if (! isPlaying() || ! hasAudioStream.load() || ! deliveredClock.read (delivered))
+        return std::numeric_limits<int64_t>::max();
+    
+    auto sinceBlockNs = getHostTimeNs() - delivered.timeNs;
+    if (sinceBlockNs >= 500000000)
+        return std::numeric_limits<int64_t>::max();
+    
+    // The ring position being heard right now
+    auto sampleRate = sourceSampleRate.load();
+    auto elapsed = static_cast<int64_t>(static_cast<double>(sinceBlockNs) * sampleRate / 1.0e9);
+    auto audible = delivered.position + jmin (elapsed, delivered.span);
+    
+    holdUpTo = audible + static_cast<int64_t>(sampleRate);
+    return audible + static_cast<int64_t>(syncToleranceSeconds.load() * sampleRate);
+}
+
+//==============================================================================
+void VLCMediaPlayer::addListener (Listener* listener)
+{
+    listeners.add (listener);
+}
+
+void VLCMediaPlayer::removeListener (Listener* listener)
+{
+    listeners.remove (listener);
+}
+
+void VLCMediaPlayer::addFrameListener (FrameListener* listener)
+{
+    frameListeners.add (listener);
+}
+
+void VLCMediaPlayer::removeFrameListener (FrameListener* listener)
+{
+    frameListeners.remove (listener);
+}
+
+//==============================================================================
+// AudioIODeviceCallback implementation
+void VLCMediaPlayer::audioDeviceIOCallback (const float** inputChannelData,
+                                           int numInputChannels,
+                                           float** outputChannelData,
+                                           int numOutputChannels,
+                                           int numSamples)
+{
+    ignoreUnused (inputChannelData, numInputChannels);
+    
+    // Without a device timestamp, the block starts being heard once the output latency has passed
+    auto latencyNs = static_cast<int64_t>(outputLatencySamples.load() * 1.0e9 / jmax (1.0, currentSampleRate.load()));
+    renderAudio (outputChannelData, numOutputChannels, numSamples, getHostTimeNs() + latencyNs);
+}
+
+void VLCMediaPlayer::audioDeviceIOCallbackWithContext (const float* const* inputChannelData,
+                                                      int numInputChannels,
+                                                      float* const* outputChannelData,
+                                                      int numOutputChannels,
+                                                      int numSamples,
+                                                      const AudioIODeviceCallbackContext& context)
+{
+    ignoreUnused (inputChannelData, numInputChannels);
+    
+    if (context.hostTimeNs == nullptr)
+    {
+        audioDeviceIOCallback (const_cast<const float**>(inputChannelData), numInputChannels, 
+                              const_cast<float**>(outputChannelData), numOutputChannels, numSamples);
+        return;
+    }
+    
+    renderAudio (outputChannelData, numOutputChannels, numSamples, static_cast<int64_t>(*context.hostTimeNs));
+}
+
+void VLCMediaPlayer::renderAudio (float* const* outputChannelData, int numOutputChannels,
+                                  int numSamples, int64_t presentationTimeNs)
+{
+    const RealtimeChecks::ScopedCallback scope (RealtimeChecks::audioDevice);
+    const ScopedStatsTimer timer (stats.audioCallbackTicks, stats.maxAudioCallbackTicks, stats.numAudioCallbacks);
+    
+    // Clear output buffers first
+    for (int channel = 0; channel < numOutputChannels; ++channel)
+    {
+        if (outputChannelData[channel] != nullptr)
+            FloatVectorOperations::clear (outputChannelData[channel], numSamples);
+    }
+    
+    renderAudioStems (outputChannelData, numOutputChannels, numSamples, presentationTimeNs);
+    
+    // Never wait on the audio thread: if the ring is being swapped, output silence
+    const SpinLock::ScopedTryLockType lock (audioRingBufferLock);
+    if (! lock.isLocked() || audioRingBuffer == nullptr)
+        return;
+    
+    auto* ring = audioRingBuffer.get();
+    auto deviceRate = jmax (1.0, currentSampleRate.load());
+    auto ringRate = jmax (1.0, sourceSampleRate.load());
+    
+    // Away from normal speed, libVLC stretches the media to fit more or fewer samples
+    auto mediaSamplesPerRingSample = deviceRate / ringRate * playbackRate.load();
+    
+    if (resamplingQuality.load() != activeResamplingQuality)
+        resetResamplers();
+    
+    // Honour a pending flush first so the read position is current
+    ring->read (nullptr, 0, 0);
+    auto position = ring->tail.load (std::memory_order_relaxed);
+    
+    // Once playback reaches the latest anchor, the media timeline restarts from it
+    if (anchorEpoch != deliveredAnchorEpoch && position >= anchorPosition)
+    {
+        deliveredAnchorEpoch = anchorEpoch;
+        deliveredSample = static_cast<double>(anchorSample) + static_cast<double>(position - anchorPosition) * mediaSamplesPerRingSample;
+        
+        // The interpolators' history belongs to the audio before the jump
+        resetResamplers();
+    }
+    
+    int silenceBefore = 0;
+    int ringSamplesUsed = 0;
+    auto speedRatio = ringRate / deviceRate;
+    
+    if (hasAudioStream.load() && isPlaying())
+    {
+        // Compare when this block is really heard with when libVLC meant it to be.
+        // libVLC's timestamps and libvlc_clock() are in microseconds.
+        TimelinePoint::Values scheduled;
+        
+        if (scheduledClock.read (scheduled)
+             && scheduled.epoch == ring->flushGeneration.load (std::memory_order_relaxed))
+        {
+            auto presentationVlcNs = libvlc_clock() * 1000 + (presentationTimeNs - getHostTimeNs());
+            auto sinceScheduled = static_cast<int64_t>(position) - scheduled.position;
+            auto intendedNs = scheduled.timeNs + static_cast<int64_t>(static_cast<double>(sinceScheduled) * 1.0e9 / ringRate);
+            auto lateNs = presentationVlcNs - intendedNs;
+            auto toleranceNs = static_cast<int64_t>(syncToleranceSeconds.load() * 1.0e9);
+            
+            // Seconds out means the schedule belongs to the media before a switch
+            if (std::abs (lateNs) < 5000000000LL)
+            {
+                if (lateNs > toleranceNs)
+                {
+                    // Late: drop what should already have been heard (a read without destinations discards)
+                    auto numToSkip = static_cast<int>(static_cast<double>(lateNs) * ringRate / 1.0e9);
+                    deliveredSample += ring->read (nullptr, 0, numToSkip) * mediaSamplesPerRingSample;
+                }
+                else if (lateNs < -toleranceNs)
+                {
+                    // Early: hold this block back behind some silence
+                    silenceBefore = jmin (numSamples, static_cast<int>(static_cast<double>(-lateNs) * deviceRate / 1.0e9));
+                }
+                else
+                {
+                    // Within the tolerance, read up to 0.2% faster or slower to trim the drift out inaudibly
+                    speedRatio *= 1.0 + jlimit (-0.002, 0.002, static_cast<double>(lateNs) / 1.0e10);
+                }
+            }
+        }
+        
+        ringSamplesUsed = resampleFromRing (*ring, outputChannelData, numOutputChannels,
+                                            silenceBefore, numSamples - silenceBefore, speedRatio);
+    }
+    
+    // Where this block sits in the ring and on the media timeline, and when it starts to be heard
+    TimelinePoint::Values delivered;
+    delivered.position = static_cast<int64_t>(ring->tail.load (std::memory_order_relaxed)) - ringSamplesUsed;
+    delivered.sample = static_cast<int64_t>(deliveredSample);
+    delivered.timeNs = presentationTimeNs + static_cast<int64_t>(silenceBefore * 1.0e9 / deviceRate);
+    delivered.span = ringSamplesUsed;
+    delivered.epoch = ring->flushGeneration.load (std::memory_order_relaxed);
+    deliveredClock.publish (delivered);
+    
+    deliveredSample += ringSamplesUsed * mediaSamplesPerRingSample;
+}
+
+int VLCMediaPlayer::resampleFromRing (AudioBuffer& ring, float* const* outputChannelData, int numOutputChannels,
+                                      int startSample, int numSamples, double speedRatio)
+{
+    int numChannels = jmin (ring.numChannels, resampleInput.getNumChannels() - 1);
+    int capacity = resampleInput.getNumSamples();
+    int totalUsed = 0;
+    
+    // Not prepared by audioDeviceAboutToStart yet
+    if (numChannels <= 0 || capacity < 4)
+        return 0;
+    
+    auto* spare = resampleInput.getWritePointer (resampleInput.getNumChannels() - 1);
+    
+    while (numSamples > 0)
+    {
+        // The interpolator may consume one more input than the ratio suggests, depending on its phase
+        int chunk = jmin (numSamples, static_cast<int>((capacity - 2) / speedRatio));
+        int available = ring.getNumReady();
+        
+        if (static_cast<int>(std::ceil (chunk * speedRatio)) + 2 > available)
+            chunk = static_cast<int>((available - 2) / speedRatio);
+        
+        // Ran dry: the rest of the block stays silent
+        if (chunk <= 0)
+        {
+            numAudioUnderruns.fetch_add (1, std::memory_order_relaxed);
+            break;
+        }
+        
+        ring.peek (resampleInput.getArrayOfWritePointers(), numChannels,
+                   static_cast<int>(std::ceil (chunk * speedRatio)) + 2);
+        int used = 0;
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            // Channels the device doesn't have are still run, so every interpolator stays in step
+            float* output = channel < numOutputChannels && outputChannelData[channel] != nullptr
+                              ? outputChannelData[channel] + startSample
+                              : spare;
+            
+            const float* input = resampleInput.getReadPointer (channel);
+            
+            switch (static_cast<ResamplingQuality>(activeResamplingQuality))
+            {
+                case ResamplingQuality::Linear:         used = linearResamplers[channel].process (speedRatio, input, output, chunk); break;
+                case ResamplingQuality::WindowedSinc:   used = sincResamplers[channel].process (speedRatio, input, output, chunk); break;
+                case ResamplingQuality::Lagrange:
+                default:                                used = lagrangeResamplers[channel].process (speedRatio, input, output, chunk); break;
+            }
+        }
+        
+        ring.read (nullptr, 0, used);
+        totalUsed += used;
+        startSample += chunk;
+        numSamples -= chunk;
+    }
+    
+    return totalUsed;
+}
+
+void VLCMediaPlayer::resetResamplers()
+{
+    activeResamplingQuality = resamplingQuality.load();
+    
+    for (int channel = 0; channel < AudioDeinterleaver::maxChannels; ++channel)
+    {
+        linearResamplers[channel].reset();
+        lagrangeResamplers[channel].reset();
+        sincResamplers[channel].reset();
+    }
+}
+
+void VLCMediaPlayer::setResamplingQuality (ResamplingQuality quality)
+{
+    resamplingQuality = static_cast<int>(quality);
+}
+
+VLCMediaPlayer::ResamplingQuality VLCMediaPlayer::getResamplingQuality() const
+{
+    return static_cast<ResamplingQuality>(resamplingQuality.load());
+}
+
+void VLCMediaPlayer::audioDeviceAboutToStart (AudioIODevice* device)
+{
+    if (device == nullptr)
+        return;
+    
+    DBG ("Audio device starting at " + juce::String (device->getCurrentSampleRate()) + " Hz");
+    
+    prepareAudioOutput (device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples(),
+                        device->getOutputLatencyInSamples());
+}
+
+void VLCMediaPlayer::prepareAudioOutput (double sampleRate, int maximumBlockSize, int latencyInSamples)
+{
+    outputLatencySamples = latencyInSamples;
+    
+    if (sampleRate > 0.0)
+    {
+        currentSampleRate = sampleRate;
+        
+        if (mediaDuration.load() > 0.0)
+            totalAudioSamples = static_cast<int64_t>(mediaDuration.load() * sampleRate);
+    }
+    
+    // No callbacks run until this returns, so the resampler's input can be sized here.
+    // Larger blocks, or media at many times the device rate, are converted in chunks.
+    int blockSize = jmax (256, maximumBlockSize);
+    deviceBlockSize = blockSize;
+    resampleInput.setSize (AudioDeinterleaver::maxChannels + 1, blockSize * 4 + 8);
+    resetResamplers();
+    
+    const SpinLock::ScopedLockType lock (audioStemsLock);
+    
+    for (auto* stem : audioStems)
+        stem->prepareAudioOutput (sampleRate, maximumBlockSize, latencyInSamples);
+}
+
+void VLCMediaPlayer::audioDeviceStopped()
+{
+    // Resources are managed by libVLC
+}
+
+void VLCMediaPlayer::audioDeviceError (const String& errorMessage)
+{
+    DBG ("Audio device error: " + errorMessage);
+    // Handle audio device errors if needed
+}
+
+//==============================================================================
+// Timer callback for position updates
+void VLCMediaPlayer::timerCallback()
+{
+    updateAudioPosition();
+    checkSeekTimeout();
+    updateTransportFollower();
+    updateAudioStems();
+    
+    // Following may have started from the audio thread since the last tick
+    if (followingTransport.load() && getTimerInterval() != 16)
+        updateTimerState();
+    
+    if (outputRenegotiationPending && isCurrentlyPlaying.load()
+         && Time::getMillisecondCounter() >= renegotiateOutputAt)
+        renegotiateVideoOutput();
+}
+
+//==============================================================================
+// libVLC Audio Callbacks
+void VLCMediaPlayer::audioPlayCallback (void* data, const void* samples, unsigned count, int64_t pts)
+{
+    // Safety check to prevent accessing freed memory
+    if (data == nullptr || samples == nullptr)
+        return;
+    
+    const RealtimeChecks::ScopedCallback scope (RealtimeChecks::audioPlay);
+    
+    auto* deck = static_cast<Deck*>(data);
+    
+    // A deck on standby is only prerolling, so its audio is dropped
+    if (! deck->isLive.load())
+        return;
+    
+    auto& player = deck->owner;
+    int numChannels = deck->audioChannels.load();
+    
+    if (player.audioRingBuffer == nullptr || player.audioRingBuffer->numChannels != numChannels)
+        return;
+    
+    // Remember when libVLC wants this block heard; the audio thread and the video
+    // reader both measure themselves against it
+    auto* ring = player.audioRingBuffer.get();
+    TimelinePoint::Values scheduled;
+    scheduled.position = static_cast<int64_t>(ring->head.load (std::memory_order_relaxed));
+    scheduled.timeNs = pts * 1000;
+    scheduled.span = static_cast<int64_t>(count);
+    scheduled.epoch = ring->flushGeneration.load (std::memory_order_acquire);
+    player.scheduledClock.publish (scheduled);
+    
+    // count is in frames; the buffer is interleaved FL32 as requested in setupAudioCallbacks()
+    size_t size = static_cast<size_t>(count) * sizeof(float) * static_cast<size_t>(numChannels);
+    player.processAudioData (samples, size);
+}
+
+void VLCMediaPlayer::audioPauseCallback (void* data, int64_t pts)
+{
+    ignoreUnused (data, pts);
+}
+
+void VLCMediaPlayer::audioResumeCallback (void* data, int64_t pts)
+{
+    ignoreUnused (data, pts);
+}
+
+void VLCMediaPlayer::audioFlushCallback (void* data, int64_t)
+{
+    const RealtimeChecks::ScopedCallback scope (RealtimeChecks::audioFlush);
+    
+    auto* deck = static_cast<Deck*>(data);
+    
+    // Leaves what's buffered alone when a deck is stopped after being switched out
+    if (! deck->isLive.load())
+        return;
+    
+    auto& player = deck->owner;
+    
+    // Only ever contended by a seek or a ring swap on another thread, for a few instructions
+    JUCE_LIBVLC_NOTE_LOCK();
+    const SpinLock::ScopedLockType lock (player.audioRingBufferLock);
+    if (player.audioRingBuffer != nullptr)
+    {
+        // libVLC flushes after the seek we asked for, so the anchor moves past the flush too
+        player.audioRingBuffer->flush();
+        player.anchorPosition = player.audioRingBuffer->flushPosition.load (std::memory_order_relaxed);
+        ++player.anchorEpoch;
+    }
+    
+    // Time updates from here on come from the seek's new position
+    if (player.seekInProgress.load())
+        player.seekHasFlushed = true;
+}
+
+void VLCMediaPlayer::audioDrainCallback (void* data)
+{
+    ignoreUnused (data);
+}
+
+int VLCMediaPlayer::audioSetupCallback (void** data, char* format, unsigned* rate, unsigned* channels)
+{
+    // Safety check to prevent accessing freed memory
+    if (data == nullptr || *data == nullptr)
+        return -1;
+    
+    auto* deck = static_cast<Deck*>(*data);
+    auto* player = &deck->owner;
+    
+    // Keep the source channel layout (up to the deinterleaver's limit) and sample rate;
+    // renderAudio converts to the device rate as it pulls from the ring
+    int numChannels = jlimit (1, AudioDeinterleaver::maxChannels, static_cast<int>(*channels));
+    
+    DBG("VLCMediaPlayer::audioSetupCallback - Source: " + juce::String(*channels) + " channels at " + 
+        juce::String(*rate) + " Hz, negotiated " + juce::String(numChannels) + " channels");
+    
+    memcpy (format, "FL32", 4);
+    *rate = jlimit (8000u, 384000u, *rate);
+    *channels = static_cast<unsigned>(numChannels);
+    
+    deck->audioChannels = numChannels;
+    deck->audioSampleRate = static_cast<double>(*rate);
+    deck->hasAudioOutput = true;
+    
+    // A standby deck's channel count is matched when it's switched in (see promoteStandbyDeck)
+    if (! deck->isLive.load())
+        return 0;
+    
+    player->sourceSampleRate = static_cast<double>(*rate);
+    
+    // The ring is changed here, on libVLC's decoder thread, before any play callback for this format
+    int capacity = player->getRingCapacity();
+    
+    if (player->audioRingBuffer == nullptr || player->audioRingBuffer->numChannels != numChannels
+         || player->audioRingBuffer->numSamples != capacity)
+    {
+        auto newBuffer = std::make_unique<AudioBuffer> (numChannels, capacity);
+        
+        {
+            const SpinLock::ScopedLockType lock (player->audioRingBufferLock);
+            std::swap (player->audioRingBuffer, newBuffer);
+        }
+        
+        // The old ring is freed here, outside the lock
+    }
+    
+    // Stems are output after this many channels
+    player->numRingChannels = numChannels;
+    
+    // Audio is flowing, even if parsing hasn't reported the track yet
+    player->hasAudioStream = true;
+    return 0;
+}
+
+void VLCMediaPlayer::audioCleanupCallback (void* data)
+{
+    ignoreUnused (data);
+}
+
+//==============================================================================
+// libVLC Video Callbacks
+void* VLCMediaPlayer::videoLockCallback (void* data, void** planes)
+{
+    if (data == nullptr || planes == nullptr)
+        return nullptr;
+        
+    const RealtimeChecks::ScopedCallback scope (RealtimeChecks::videoLock);
+    
+    auto* deck = static_cast<Deck*>(data);
+    
+    // Hand libVLC a free slot so it decodes straight into the frame we'll display
+    auto* slot = deck->framePool.acquireForWriting();
+    
+    if (deck->isLive.load())
+        deck->owner.stats.framesDecoded.fetch_add (1, std::memory_order_relaxed);
+    
+    for (int plane = 0; plane < slot->numPlanes; ++plane)
+        planes[plane] = slot->planes[plane];
+    
+    // The slot doubles as libVLC's picture handle, passed back to the display callback
+    return slot;
+}
+
+void VLCMediaPlayer::videoUnlockCallback (void* data, void* picture, void* const* planes)
+{
+    if (data == nullptr || picture == nullptr || planes == nullptr)
+        return;
+    
+    // Video frame data is now available in the buffer
+    // We'll process it in the display callback
+}
+
+void VLCMediaPlayer::videoDisplayCallback (void* data, void* picture)
+{
+    if (data == nullptr || picture == nullptr)
+        return;
+        
+    const RealtimeChecks::ScopedCallback scope (RealtimeChecks::videoDisplay);
+    
+    auto* deck = static_cast<Deck*>(data);
+    auto* player = &deck->owner;
+    
+    auto* slot = static_cast<VideoFramePool::Slot*>(picture);
+    int64_t presentation = -1;
+    TimelinePoint::Values scheduled;
+    
+    // libVLC shows each frame when it plans to, so it belongs with the audio planned for now
+    if (deck->isLive.load() && player->scheduledClock.read (scheduled))
+    {
+        auto sinceScheduledNs = libvlc_clock() * 1000 - scheduled.timeNs;
+        presentation = scheduled.position
+                        + static_cast<int64_t>(static_cast<double>(sinceScheduledNs) * player->sourceSampleRate.load() / 1.0e9);
+    }
+    
+    slot->presentationPosition.store (presentation, std::memory_order_relaxed);
+    
+    if (deck->isLive.load())
+        player->updateFrameStats (presentation);
+    
+    // Copied before it's published, while nothing else can be reading or recycling the slot
+    if (deck->isLive.load() && player->frameCacheEnabled.load() && slot->format == VideoPixelFormat::RGB32)
+    {
+        auto& counters = player->stats;
+        const ScopedStatsTimer timer (counters.frameCopyTicks, counters.maxFrameCopyTicks, counters.numFrameCopies);
+        player->frameIntake.offer (*slot, player->frameCacheMediaId.load());
+    }
+    
+    // Frame listeners' handle is taken while this thread still owns the slot, so it can't be recycled
+    VideoFrame frame;
+    
+    if (deck->isLive.load() && slot != &deck->framePool.overflowSlot && ! player->frameListeners.isEmpty())
+    {
+        slot->timeInSeconds = player->getMediaTimeForPresentation (presentation);
+        frame = VideoFrame (*slot);
+    }
+    
+    // Make the decoded slot the latest frame for readers
+    deck->framePool.publish (slot);
+    
+    if (frame.isValid())
+    {
+        JUCE_LIBVLC_NOTE_LOCK();
+        player->frameListeners.call ([player, &frame] (FrameListener& l) { l.videoFrameReady (player, frame); });
+    }
+    
+    // The first frame of a preload: the deck can now be held at it
+    if (! deck->hasPrerolled.exchange (true))
+        player->postEvent (pendingStandbyPrerolled);
+}
+
+unsigned VLCMediaPlayer::videoFormatCallback (void** data, char* chroma, unsigned* width, 
+                                            unsigned* height, unsigned* pitches, unsigned* lines)
+{
+    // Safety check to prevent accessing freed memory
+    if (data == nullptr || *data == nullptr)
+        return 0;
+        
+    auto* deck = static_cast<Deck*>(*data);
+    auto* player = &deck->owner;
+    
+    DBG("VLCMediaPlayer::videoFormatCallback - Setting up video format: " + 
+        juce::String(*width) + "x" + juce::String(*height));
+    
+    // Ask for whichever layout our consumers want: RGBA for juce::Image, YUV for GPU renderers
+    auto format = player->getVideoPixelFormat();
+    
+    switch (format)
+    {
+        case VideoPixelFormat::I420:    memcpy (chroma, "I420", 4); break;
+        case VideoPixelFormat::NV12:    memcpy (chroma, "NV12", 4); break;
+        case VideoPixelFormat::RGB32:
+        default:                        memcpy (chroma, "RV32", 4); break;
+    }
+    
+    // A standby deck's size is picked up when it's switched in
+    if (deck->isLive.load())
+        player->updateVideoSize (*width, *height);
+    
+    // Asking for a smaller picture makes libVLC scale it before it reaches us
+    auto outputSize = player->getOutputSizeFor (static_cast<int>(*width), static_cast<int>(*height));
+    *width = static_cast<unsigned>(outputSize.getWidth());
+    *height = static_cast<unsigned>(outputSize.getHeight());
+    
+    int planePitches[VideoFramePool::maxPlanes] {};
+    int planeLines[VideoFramePool::maxPlanes] {};
+    int numPlanes = VideoFramePool::getPlaneLayout (format, static_cast<int>(*width), static_cast<int>(*height),
+                                                    planePitches, planeLines);
+    
+    for (int plane = 0; plane < numPlanes; ++plane)
+    {
+        pitches[plane] = static_cast<unsigned>(planePitches[plane]);
+        lines[plane] = static_cast<unsigned>(planeLines[plane]);
+    }
+    
+    // Size the frame slots now rather than in the lock callback
+    deck->framePool.setFormat (static_cast<int>(*width), static_cast<int>(*height), format);
+    deck->framePool.preallocate();
+    
+    // The decoder has produced its first picture, so it's the one that stays
+    if (deck->finishDecoderDetection() && deck->isLive.load())
+        player->postEvent (pendingDecoderChosen);
+    
+    return 1; // Success
+}
+
+void VLCMediaPlayer::videoCleanupCallback (void* data)
+{
+    ignoreUnused (data);
+}
+
+//==============================================================================
+// libVLC Event Callbacks
+void VLCMediaPlayer::vlcEventCallback (const libvlc_event_t* event, void* data)
+{
+    if (event == nullptr || data == nullptr)
+        return;
+    
+    auto* player = static_cast<VLCMediaPlayer*>(data);
+    
+    // Called on libVLC's threads. Plain state goes straight into atomics;
+    // anything listeners need to hear about is posted to the message thread.
+    switch (event->type)
+    {
+        case libvlc_MediaParsedChanged:
+            player->pendingParseStatus = static_cast<int>(event->u.media_parsed_changed.new_status);
+            player->postEvent (pendingMediaParsed);
+            break;
+        
+        case libvlc_MediaPlayerPlaying:
+            player->isCurrentlyPlaying = true;
+            player->postEvent (pendingPlaybackStarted);
+            break;
+        
+        case libvlc_MediaPlayerPaused:
+        case libvlc_MediaPlayerStopped:
+            player->isCurrentlyPlaying = false;
+            player->postEvent (pendingPlaybackStopped);
+            break;
+        
+        case libvlc_MediaPlayerEndReached:
+            player->isCurrentlyPlaying = false;
+            player->postEvent (pendingEndReached);
+            break;
+        
+        case libvlc_MediaPlayerEncounteredError:
+            player->isCurrentlyPlaying = false;
+            player->postEvent (pendingPlaybackError);
+            break;
+        
+        case libvlc_MediaPlayerLengthChanged:
+        {
+            auto lengthMs = event->u.media_player_length_changed.new_length;
+            
+            if (lengthMs > 0)
+            {
+                player->mediaDuration = static_cast<double>(lengthMs) / 1000.0;
+                player->totalAudioSamples = static_cast<int64_t>(player->mediaDuration.load()
+                                                                 * player->currentSampleRate.load());
+            }
+            break;
+        }
+        
+        case libvlc_MediaPlayerVout:
+        {
+            // Also covers NativeWindow output, where no format callback is made
+            auto* deck = player->liveDeck.get();
+            
+            if (event->u.media_player_vout.new_count > 0 && deck != nullptr && deck->finishDecoderDetection())
+                player->postEvent (pendingDecoderChosen);
+            break;
+        }
+        
+        case libvlc_MediaPlayerTimeChanged:
+        {
+            auto timeMs = static_cast<int64_t>(event->u.media_player_time_changed.new_time);
+            auto sampleRate = player->currentSampleRate.load();
+            auto sample = static_cast<int64_t>(static_cast<double>(timeMs) * sampleRate / 1000.0);
+            player->currentAudioSample = sample;
+            
+            // Updates from before the seek can still arrive after it's issued, and a short seek
+            // lands close to where playback was, so only the flush libVLC makes once it has
+            // carried the seek out marks the change. Without audio output there's nothing to
+            // flush; the time must then be near the target, and checkSeekTimeout() backs it up.
+            auto* deck = player->liveDeck.get();
+            bool flushesAudio = deck != nullptr && deck->hasAudioOutput.load();
+            bool hasLanded = flushesAudio ? player->seekHasFlushed.load()
+                                          : std::abs (timeMs - player->issuedSeekTargetMs.load()) < 1000;
+            
+            if (hasLanded && player->seekInProgress.exchange (false))
+            {
+                player->lastSeekLandedSample = sample;
+                player->landedSeekGeneration = player->issuedSeekGeneration.load();
+                player->postEvent (pendingSeekCompleted);
+            }
+            break;
+        }
+        
+        default:
+            break;
+    }
+}
+
+void VLCMediaPlayer::postEvent (PendingEvent event)
+{
+    pendingEvents.fetch_or (static_cast<uint32_t>(event));
+    triggerAsyncUpdate();
+}
+
+//==============================================================================
+// Internal methods
+void VLCMediaPlayer::setupAudioCallbacks (Deck& deck)
+{
+    if (deck.player == nullptr)
+        return;
+    
+    DBG("VLCMediaPlayer::setupAudioCallbacks - Routing decoded audio to the JUCE ring buffer");
+    
+    // Decoded PCM is handed to us instead of VLC opening its own output device
+    libvlc_audio_set_callbacks (deck.player,
+                               audioPlayCallback,
+                               audioPauseCallback,
+                               audioResumeCallback,
+                               audioFlushCallback,
+                               audioDrainCallback,
+                               &deck);
+    
+    // Interleaved 32-bit float at the device rate, keeping the source's channel count.
+    // The format is negotiated in audioSetupCallback each time libVLC starts its output.
+    libvlc_audio_set_format_callbacks (deck.player, audioSetupCallback, audioCleanupCallback);
+}
+
+void VLCMediaPlayer::setupVideoCallbacks (Deck& deck)
+{
+    if (deck.player == nullptr)
+        return;
+    
+    DBG("VLCMediaPlayer::setupVideoCallbacks - Setting up video callbacks for frame capture");
+    
+    // Enable video callbacks for frame capture
+    libvlc_video_set_callbacks (deck.player,
+                               videoLockCallback,
+                               videoUnlockCallback,
+                               videoDisplayCallback,
+                               &deck);
+    
+    libvlc_video_set_format_callbacks (deck.player,
+                                      videoFormatCallback,
+                                      videoCleanupCallback);
+}
+
+void VLCMediaPlayer::setupVideoOutput()
+{
+    if (mediaPlayer == nullptr)
+        return;
+    
+    // Media opened without video never starts an output, so it needs neither callbacks nor a window
+    if (! liveDeck->openOptions.decodeVideo)
+    {
+        nativeVideoSurface = nullptr;
+        return;
+    }
+    
+    if (videoOutputMode == VideoOutputMode::NativeWindow && videoComponent != nullptr)
+    {
+        // Give libVLC a child window of its own covering the video component
+        if (nativeVideoSurface == nullptr || &nativeVideoSurface->getTarget() != videoComponent.getComponent())
+            nativeVideoSurface = std::make_unique<NativeVideoSurface> (*videoComponent, [this] { setupVideoOutput(); });
+        
+        if (auto* handle = nativeVideoSurface->getWindowHandle())
+        {
+            // Setting a drawable also resets libVLC's "vout" away from vmem
+            attachNativeWindow (handle);
+            
+            DBG ("Video output configured for native window rendering");
+            DBG ("  Native handle: " + juce::String::toHexString ((juce::pointer_sized_int) handle));
+            return;
+        }
+        
+        DBG ("Video component has no native peer yet - using memory callbacks until it does");
+    }
+    else
+    {
+        nativeVideoSurface = nullptr;
+    }
+    
+    // We use video memory callbacks (vmem) to capture frames into our frame pool.
+    // libvlc_video_set_callbacks() switches libVLC's vout back to vmem, so the two modes
+    // are mutually exclusive and the most recent call wins.
+    setupVideoCallbacks (*liveDeck);
+    
+    DBG ("Video output configured for memory callbacks (vmem)");
+    DBG ("  Video component: " + (videoComponent != nullptr ? 
+        juce::String::toHexString ((juce::pointer_sized_int)videoComponent.getComponent()) : "none"));
+}
+
+void VLCMediaPlayer::attachNativeWindow (void* nativeHandle)
+{
+   #if JUCE_WINDOWS
+    libvlc_media_player_set_hwnd (mediaPlayer, nativeHandle);
+   #elif JUCE_MAC
+    libvlc_media_player_set_nsobject (mediaPlayer, nativeHandle);
+   #elif JUCE_LINUX || JUCE_BSD
+    libvlc_media_player_set_xwindow (mediaPlayer, (uint32_t) (juce::pointer_sized_int) nativeHandle);
+   #else
+    ignoreUnused (nativeHandle);
+    setupVideoCallbacks (*liveDeck);
+   #endif
+}
+
+void VLCMediaPlayer::setupEventHandling()
+{
+    if (mediaPlayer == nullptr)
+        return;
+    
+    auto* eventManager = libvlc_media_player_event_manager (mediaPlayer);
+    
+    for (auto eventType : { libvlc_MediaPlayerPlaying,
+                            libvlc_MediaPlayerPaused,
+                            libvlc_MediaPlayerStopped,
+                            libvlc_MediaPlayerEndReached,
+                            libvlc_MediaPlayerEncounteredError,
+                            libvlc_MediaPlayerLengthChanged,
+                            libvlc_MediaPlayerTimeChanged,
+                            libvlc_MediaPlayerVout })
+    {
+        libvlc_event_attach (eventManager, eventType, vlcEventCallback, this);
+    }
+}
+
+void VLCMediaPlayer::removeEventHandling()
+{
+    if (mediaPlayer == nullptr)
+        return;
+    
+    auto* eventManager = libvlc_media_player_event_manager (mediaPlayer);
+    
+    for (auto eventType : { libvlc_MediaPlayerPlaying,
+                            libvlc_MediaPlayerPaused,
+                            libvlc_MediaPlayerStopped,
+                            libvlc_MediaPlayerEndReached,
+                            libvlc_MediaPlayerEncounteredError,
+                            libvlc_MediaPlayerLengthChanged,
+                            libvlc_MediaPlayerTimeChanged,
+                            libvlc_MediaPlayerVout })
+    {
+        libvlc_event_detach (eventManager, eventType, vlcEventCallback, this);
+    }
+}
+
+void VLCMediaPlayer::updateMediaInfo()
+{
+    if (currentMedia == nullptr)
+    {
+        DBG("VLCMediaPlayer::updateMediaInfo - No current media");
+        return;
+    }
+    
+    DBG("VLCMediaPlayer::updateMediaInfo - Updating media information");
+    
+    // Get duration
+    int64_t durationMs = libvlc_media_get_duration (currentMedia);
+    DBG("VLCMediaPlayer::updateMediaInfo - Duration from libVLC: " + juce::String(durationMs) + " ms");
+    
+    if (durationMs > 0)
+    {
+        mediaDuration = static_cast<double>(durationMs) / 1000.0;
+        DBG("VLCMediaPlayer::updateMediaInfo - Set mediaDuration to: " + juce::String(mediaDuration.load()) + " seconds");
+        
+        double sampleRate = currentSampleRate.load();
+        if (sampleRate > 0.0)
+        {
+            totalAudioSamples = static_cast<int64_t>(mediaDuration.load() * sampleRate);
+            DBG("VLCMediaPlayer::updateMediaInfo - Calculated totalAudioSamples: " + juce::String(totalAudioSamples.load()));
+        }
+    }
+    else if (durationMs == 0)
+    {
+        DBG("VLCMediaPlayer::updateMediaInfo - Duration is 0, might be a live stream or unknown duration");
+        mediaDuration = -1.0;  // Keep as unknown
+    }
+    else
+    {
+        DBG("VLCMediaPlayer::updateMediaInfo - Duration is negative (" + juce::String(durationMs) + "), media not yet parsed");
+        mediaDuration = -1.0;  // Keep as unknown until parsing completes
+    }
+    
+    // Check for audio/video tracks using media tracks (not player tracks)
+    // Note: libvlc_audio_get_track_count and libvlc_video_get_track_count only work after playback starts
+    // We need to use libvlc_media_tracks_get to get track info from parsed media
+    if (currentMedia != nullptr)
+    {
+        libvlc_media_track_t** tracks = nullptr;
+        unsigned int trackCount = libvlc_media_tracks_get(currentMedia, &tracks);
+        
+        DBG("VLCMediaPlayer::updateMediaInfo - Total track count from media: " + juce::String(trackCount));
+        
+        int audioTrackCount = 0;
+        int videoTrackCount = 0;
+        audioTracks.clear();
+        
+        for (unsigned int i = 0; i < trackCount; ++i)
+        {
+            if (tracks[i] != nullptr)
+            {
+                switch (tracks[i]->i_type)
+                {
+                    case libvlc_track_audio:
+                    {
+                        audioTrackCount++;
+                        DBG("VLCMediaPlayer::updateMediaInfo - Found audio track " + juce::String(i));
+                        
+                        AudioTrackInfo info;
+                        info.id = tracks[i]->i_id;
+                        info.name = String::fromUTF8 (tracks[i]->psz_description);
+                        info.language = String::fromUTF8 (tracks[i]->psz_language);
+                        info.codec = String::fromUTF8 (libvlc_media_get_codec_description (libvlc_track_audio, tracks[i]->i_codec));
+                        
+                        if (tracks[i]->audio != nullptr)
+                        {
+                            info.numChannels = static_cast<int>(tracks[i]->audio->i_channels);
+                            info.sampleRate = static_cast<double>(tracks[i]->audio->i_rate);
+                        }
+                        
+                        audioTracks.add (info);
+                        break;
+                    }
+                    case libvlc_track_video:
+                        videoTrackCount++;
+                        DBG("VLCMediaPlayer::updateMediaInfo - Found video track " + juce::String(i) + 
+                            " - " + juce::String(tracks[i]->video->i_width) + "x" + juce::String(tracks[i]->video->i_height));
+                        
+                        // Store video dimensions
+                        if (tracks[i]->video != nullptr)
+                        {
+                            videoWidth = tracks[i]->video->i_width;
+                            videoHeight = tracks[i]->video->i_height;
+                            
+                            if (tracks[i]->video->i_frame_rate_den > 0)
+                                videoFrameRate = tracks[i]->video->i_frame_rate_num
+                                                   / static_cast<double>(tracks[i]->video->i_frame_rate_den);
+                        }
+                        break;
+                    case libvlc_track_text:
+                        DBG("VLCMediaPlayer::updateMediaInfo - Found subtitle track " + juce::String(i));
+                        break;
+                    default:
+                        DBG("VLCMediaPlayer::updateMediaInfo - Found unknown track type " + juce::String(tracks[i]->i_type));
+                        break;
+                }
+            }
+        }
+        
+        // Release track info
+        if (tracks != nullptr)
+        {
+            libvlc_media_tracks_release(tracks, trackCount);
+        }
+        
+        DBG("VLCMediaPlayer::updateMediaInfo - Audio track count: " + juce::String(audioTrackCount));
+        DBG("VLCMediaPlayer::updateMediaInfo - Video track count: " + juce::String(videoTrackCount));
+        
+        // Streams that aren't being decoded don't count
+        hasAudioStream = (audioTrackCount > 0 && liveDeck->openOptions.decodeAudio);
+        hasVideoStream = (videoTrackCount > 0 && liveDeck->openOptions.decodeVideo);
+        
+        DBG("VLCMediaPlayer::updateMediaInfo - hasAudioStream: " + juce::String(hasAudioStream.load() ? "true" : "false"));
+        DBG("VLCMediaPlayer::updateMediaInfo - hasVideoStream: " + juce::String(hasVideoStream.load() ? "true" : "false"));
+    }
+    else
+    {
+        DBG("VLCMediaPlayer::updateMediaInfo - No current media available");
+    }
+    
+    // Notify listeners that media is ready
+    notifyListeners ([this](Listener* l) { l->mediaReady (this); });
+}
+
+void VLCMediaPlayer::handleMediaParsed (int parsedStatus)
+{
+    if (currentMedia == nullptr)
+        return;
+    
+    switch (parsedStatus)
+    {
+        case libvlc_media_parsed_status_done:
+            DBG("VLCMediaPlayer::handleMediaParsed - Metadata available");
+            updateMediaInfo();
+            break;
+        
+        case libvlc_media_parsed_status_timeout:
+            notifyListeners ([this](Listener* l) { l->mediaError (this, "Timed out reading media information"); });
+            break;
+        
+        case libvlc_media_parsed_status_skipped:
+        case libvlc_media_parsed_status_failed:
+        default:
+            notifyListeners ([this](Listener* l) { l->mediaError (this, "Failed to read media information"); });
+            break;
+    }
+}
+
+void VLCMediaPlayer::handleAsyncUpdate()
+{
+    // Runs on the message thread, so listeners never hear from libVLC's threads directly
+    auto events = pendingEvents.exchange (0);
+    
+    if ((events & pendingMediaParsed) != 0)
+    {
+        int parsedStatus = pendingParseStatus.exchange (0);
+        
+        if (parsedStatus != 0)
+            handleMediaParsed (parsedStatus);
+    }
+    
+    if ((events & (pendingPlaybackStarted | pendingPlaybackStopped | pendingEndReached | pendingPlaybackError)) != 0)
+        updateTimerState();
+    
+    // Audio ESes only exist once playback has started, so a chosen track is applied then
+    if ((events & pendingPlaybackStarted) != 0 && selectedAudioTrack >= 0 && mediaPlayer != nullptr
+         && libvlc_audio_get_track (mediaPlayer) != selectedAudioTrack)
+        libvlc_audio_set_track (mediaPlayer, selectedAudioTrack);
+    
+    if ((events & pendingSeekCompleted) != 0)
+        handleSeekLanded();
+    
+    // A seek requested off the message thread needs the timer to watch it land
+    if ((events & pendingSeekScheduled) != 0)
+    {
+        updateTimerState();
+        updateAudioStems();
+    }
+    
+    // A component that sets the output size isn't resized to the video in turn
+    if ((events & pendingVideoSizeChanged) != 0 && videoComponent != nullptr && ! outputFollowsComponent.load()
+         && videoWidth.load() > 0 && videoHeight.load() > 0)
+        videoComponent->setSize (videoWidth.load(), videoHeight.load());
+    
+    if ((events & pendingDecoderChosen) != 0)
+        handleDecoderChosen();
+    
+    if ((events & pendingPlaybackError) != 0)
+        notifyListeners ([this](Listener* l) { l->mediaError (this, "libVLC encountered a playback error"); });
+    
+    if ((events & pendingStandbyPrerolled) != 0)
+    {
+        // Hold the standby at its first frame (start-paused has normally done so already)
+        if (standbyMedia != nullptr && standbyDeck != nullptr && standbyDeck->hasPrerolled.load())
+            libvlc_media_player_set_pause (standbyDeck->player, 1);
+        
+        // A deck switched in before it had prerolled may have paused itself since
+        if (resumeAfterPreroll && liveDeck != nullptr && liveDeck->hasPrerolled.load())
+        {
+            resumeAfterPreroll = false;
+            libvlc_media_player_set_pause (mediaPlayer, 0);
+        }
+    }
+    
+    if ((events & pendingEndReached) != 0)
+    {
+        if (switchAtEnd)
+            switchToQueuedMedia();
+        else
+            notifyListeners ([this](Listener* l) { l->mediaFinished (this); });
+    }
+}
+
+void VLCMediaPlayer::processAudioData (const void* buffer, size_t size)
+{
+    if (audioRingBuffer == nullptr || buffer == nullptr || size == 0)
+        return;
+    
+    // Interleaved 32-bit float with the channel count negotiated in audioSetupCallback
+    int numChannels = audioRingBuffer->numChannels;
+    int numSamples = static_cast<int>(size / (sizeof(float) * static_cast<size_t>(numChannels)));
+    const float* audioData = static_cast<const float*>(buffer);
+    
+    int start1, size1, start2, size2;
+    audioRingBuffer->prepareToWrite (numSamples, start1, size1, start2, size2);
+    
+    // Deinterleave straight into the ring, one contiguous segment at a time
+    float* dest[AudioDeinterleaver::maxChannels];
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+        dest[channel] = audioRingBuffer->data[channel] + start1;
+    
+    AudioDeinterleaver::deinterleave (audioData, dest, numChannels, size1);
+    
+    if (size2 > 0)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            dest[channel] = audioRingBuffer->data[channel] + start2;
+        
+        AudioDeinterleaver::deinterleave (audioData + size1 * numChannels, dest, numChannels, size2);
+    }
+    
+    audioRingBuffer->finishedWrite (size1 + size2);
+}
 
-void VLCMediaPlayer::audioResumeCallback (void* data, int64_t pts)
+int VLCMediaPlayer::getAvailableAudioSamples() const
 {
-    ignoreUnused (data, pts);
+    const SpinLock::ScopedLockType lock (audioRingBufferLock);
+    return audioRingBuffer != nullptr ? audioRingBuffer->getNumReady() : 0;
 }
 
-void VLCMediaPlayer::audioFlushCallback (void* data, int64_t)
+int VLCMediaPlayer::getRingCapacity() const
 {
-    auto* player = static_cast<VLCMediaPlayer*>(data);
-    if (player->audioRingBuffer != nullptr)
-        player->audioRingBuffer->clear();
+    // libVLC hands audio over about one caching period before it's due, and renderAudio
+    // holds it until then, so the ring has to cover that lead plus a few device blocks of margin
+    auto ringRate = jmax (8000.0, sourceSampleRate.load());
+    auto blocks = static_cast<double>(deviceBlockSize.load()) / jmax (1.0, currentSampleRate.load());
+    int samples = 0;
+    
+    switch (static_cast<LatencyProfile>(latencyProfile.load()))
+    {
+        case LatencyProfile::Live:      samples = static_cast<int>(ringRate * (0.15 + blocks * 4.0)); break;
+        case LatencyProfile::Balanced:  samples = static_cast<int>(ringRate * jmax (0.5, 0.45 + blocks * 4.0)); break;
+        case LatencyProfile::Robust:
+        default:                        samples = jmax (JUCE_LIBVLC_AUDIO_BUFFER_SIZE, static_cast<int>(ringRate * (1.5 + blocks * 4.0))); break;
+    }
+    
+    // The ring rounds up too, so this can be compared with its size
+    return nextPowerOfTwo (samples);
 }
 
-void VLCMediaPlayer::audioDrainCallback (void* data)
+void VLCMediaPlayer::applyLatencyProfile (libvlc_media_t* media) const
 {
-    ignoreUnused (data);
+    int cachingMs = 1000;
+    
+    switch (static_cast<LatencyProfile>(latencyProfile.load()))
+    {
+        case LatencyProfile::Live:      cachingMs = 100; break;
+        case LatencyProfile::Balanced:  cachingMs = 300; break;
+        case LatencyProfile::Robust:
+        default:                        break;
+    }
+    
+    // Per-media options override the instance's, so players sharing an instance can differ
+    for (auto* option : { ":file-caching=", ":network-caching=", ":live-caching=" })
+        libvlc_media_add_option (media, (String (option) + String (cachingMs)).toRawUTF8());
+}
+
+void VLCMediaPlayer::applyDecoderSettings (libvlc_media_t* media) const
+{
+    StringArray options;
+    
+    switch (decoderSettings.hardware)
+    {
+        case HardwareDecoding::Disabled:        options.add (":avcodec-hw=none"); options.add (":codec=avcodec,any"); break;
+        case HardwareDecoding::VideoToolbox:    options.add (":codec=videotoolbox,any"); break;
+        case HardwareDecoding::NVDEC:           options.add (":codec=nvdec,any"); break;
+        case HardwareDecoding::D3D11VA:         options.add (":avcodec-hw=d3d11va"); break;
+        case HardwareDecoding::DXVA2:           options.add (":avcodec-hw=dxva2"); break;
+        case HardwareDecoding::VAAPI:           options.add (":avcodec-hw=vaapi"); break;
+        case HardwareDecoding::VDPAU:           options.add (":avcodec-hw=vdpau_avcodec"); break;
+        case HardwareDecoding::Automatic:
+        default:                                options.add (":avcodec-hw=any"); break;
+    }
+    
+    if (decoderSettings.numThreads > 0)
+        options.add (":avcodec-threads=" + String (decoderSettings.numThreads));
+    
+    if (decoderSettings.skipNonReferenceFrames)
+        options.add (":avcodec-skip-frame=1");
+    
+    if (decoderSettings.lowResolution > 0)
+        options.add (":avcodec-lowres=" + String (jlimit (1, 3, decoderSettings.lowResolution)));
+    
+    options.add (decoderSettings.dropLateFrames ? ":drop-late-frames" : ":no-drop-late-frames");
+    options.add (decoderSettings.skipFrames ? ":skip-frames" : ":no-skip-frames");
+    
+    // Back ends that can't open make libVLC fall back to the next decoder, ending in software;
+    // handleDecoderChosen() enforces allowSoftwareFallback afterwards
+    for (auto& option : options)
+        libvlc_media_add_option (media, option.toRawUTF8());
+}
+
+void VLCMediaPlayer::applyOpenOptions (libvlc_media_t* media) const
+{
+    if (! openOptions.decodeVideo)
+    {
+        libvlc_media_add_option (media, ":no-video");
+        libvlc_media_add_option (media, ":no-spu");
+    }
+    
+    if (! openOptions.decodeAudio)
+        libvlc_media_add_option (media, ":no-audio");
+    
+    // A stem decodes just its own track
+    if (stemTrackId >= 0)
+        libvlc_media_add_option (media, (":audio-track-id=" + String (stemTrackId)).toRawUTF8());
+}
+
+void VLCMediaPlayer::handleDecoderChosen()
+{
+    auto info = getDecoderInfo();
+    
+    if (! info.isKnown)
+        return;
+    
+    DBG ("VLCMediaPlayer::handleDecoderChosen - Decoding video with " + info.name
+         + (info.isHardware ? " (hardware)" : " (software)"));
+    
+    bool wantedHardware = decoderSettings.hardware != HardwareDecoding::Disabled;
+    
+    if (wantedHardware && ! info.isHardware && ! decoderSettings.allowSoftwareFallback)
+    {
+        stop();
+        notifyListeners ([this](Listener* l) { l->mediaError (this, "Hardware decoding unavailable for this media"); });
+    }
 }
 
 //==============================================================================
-// libVLC Video Callbacks
-void* VLCMediaPlayer::videoLockCallback (void* data, void** planes)
+void VLCMediaPlayer::setDecoderSettings (const DecoderSettings& settings)
 {
-    if (data == nullptr || planes == nullptr)
-        return nullptr;
+    decoderSettings = settings;
+}
+
+VLCMediaPlayer::DecoderSettings VLCMediaPlayer::getDecoderSettings() const
+{
+    return decoderSettings;
+}
+
+VLCMediaPlayer::DecoderInfo VLCMediaPlayer::getDecoderInfo() const
+{
+    if (liveDeck == nullptr)
+        return {};
+    
+    const SpinLock::ScopedLockType lock (liveDeck->decoderInfoLock);
+    return liveDeck->decoderInfo;
+}
+
+//==============================================================================
+void VLCMediaPlayer::Deck::videoDecoderOpened (const String& name, bool isHardware)
+{
+    if (! isAwaitingDecoder.load())
+        return;
+    
+    const SpinLock::ScopedLockType lock (decoderInfoLock);
+    decoderInfo.name = name;
+    decoderInfo.isHardware = isHardware;
+}
+
+void VLCMediaPlayer::Deck::resetDecoderInfo (bool detectNextDecoder)
+{
+    {
+        const SpinLock::ScopedLockType lock (decoderInfoLock);
+        decoderInfo = {};
+    }
+    
+    isAwaitingDecoder = detectNextDecoder;
+}
+
+bool VLCMediaPlayer::Deck::finishDecoderDetection()
+{
+    if (! isAwaitingDecoder.exchange (false))
+        return false;
+    
+    // Software decoders don't announce themselves, so silence means software
+    const SpinLock::ScopedLockType lock (decoderInfoLock);
+    
+    if (! decoderInfo.isHardware)
+        decoderInfo.name = "software";
+    
+    decoderInfo.isKnown = true;
+    return true;
+}
+
+//==============================================================================
+void VLCMediaPlayer::setLatencyProfile (LatencyProfile profile)
+{
+    latencyProfile = static_cast<int>(profile);
+}
+
+VLCMediaPlayer::LatencyProfile VLCMediaPlayer::getLatencyProfile() const
+{
+    return static_cast<LatencyProfile>(latencyProfile.load());
+}
+
+double VLCMediaPlayer::getAudioBufferLevel() const
+{
+    return getAvailableAudioSamples() / jmax (1.0, sourceSampleRate.load());
+}
+
+double VLCMediaPlayer::getAudioBufferCapacity() const
+{
+    const SpinLock::ScopedLockType lock (audioRingBufferLock);
+    return audioRingBuffer != nullptr ? audioRingBuffer->numSamples / jmax (1.0, sourceSampleRate.load()) : 0.0;
+}
+
+int VLCMediaPlayer::getNumAudioUnderruns() const
+{
+    return numAudioUnderruns.load();
+}
+
+//==============================================================================
+VLCMediaPlayer::Stats VLCMediaPlayer::getStats() const
+{
+    Stats result;
+    
+    auto average = [] (const std::atomic<int64>& total, const std::atomic<int64>& count)
+    {
+        auto n = count.load();
+        return n > 0 ? ticksToMs (total.load()) / static_cast<double>(n) : 0.0;
+    };
+    
+    result.framesDecoded = stats.framesDecoded.load();
+    result.framesDisplayed = stats.framesDisplayed.load();
+    result.framesLate = stats.framesLate.load();
+    result.averageFrameCopyMs = average (stats.frameCopyTicks, stats.numFrameCopies);
+    result.maxFrameCopyMs = ticksToMs (stats.maxFrameCopyTicks.load());
+    
+    result.audioBufferLevel = getAudioBufferLevel();
+    result.audioBufferCapacity = getAudioBufferCapacity();
+    result.audioUnderruns = numAudioUnderruns.load();
+    result.averageAudioCallbackMs = average (stats.audioCallbackTicks, stats.numAudioCallbacks);
+    result.maxAudioCallbackMs = ticksToMs (stats.maxAudioCallbackTicks.load());
+    
+    result.numSeeks = stats.numSeeks.load();
+    result.lastSeekLatencyMs = ticksToMs (stats.lastSeekLatencyTicks.load());
+    result.averageSeekLatencyMs = result.numSeeks > 0 ? ticksToMs (stats.seekLatencyTicks.load()) / result.numSeeks : 0.0;
+    result.maxSeekLatencyMs = ticksToMs (stats.maxSeekLatencyTicks.load());
+    
+    result.avOffsetMs = stats.avOffsetSeconds.load() * 1000.0;
+    
+    libvlc_media_stats_t vlcStats {};
+    
+    if (currentMedia != nullptr && libvlc_media_get_stats (currentMedia, &vlcStats))
+    {
+        // libVLC measures bitrates in bytes per microsecond
+        result.inputBytesRead = vlcStats.i_read_bytes;
+        result.demuxBytesRead = vlcStats.i_demux_read_bytes;
+        result.inputBitrate = vlcStats.f_input_bitrate * 8.0e6;
+        result.demuxBitrate = vlcStats.f_demux_bitrate * 8.0e6;
+        result.demuxCorrupted = vlcStats.i_demux_corrupted;
+        result.demuxDiscontinuities = vlcStats.i_demux_discontinuity;
+        result.videoBlocksDecoded = vlcStats.i_decoded_video;
+        result.audioBlocksDecoded = vlcStats.i_decoded_audio;
+        result.framesDropped = vlcStats.i_lost_pictures;
+        result.audioBuffersLost = vlcStats.i_lost_abuffers;
+    }
+    
+    return result;
+}
+
+void VLCMediaPlayer::resetStats()
+{
+    stats.reset();
+    numAudioUnderruns = 0;
+}
+
+void VLCMediaPlayer::StatsCounters::reset() noexcept
+{
+    for (auto* counter : { &framesDecoded, &framesDisplayed, &framesLate,
+                           &frameCopyTicks, &maxFrameCopyTicks, &numFrameCopies,
+                           &audioCallbackTicks, &maxAudioCallbackTicks, &numAudioCallbacks,
+                           &seekLatencyTicks, &maxSeekLatencyTicks, &lastSeekLatencyTicks,
+                           &seekRequestedAt })
+        counter->store (0, std::memory_order_relaxed);
+    
+    numSeeks = 0;
+    isAwaitingSeekFrame = false;
+    avOffsetSeconds = 0.0;
+}
+
+void VLCMediaPlayer::updateFrameStats (int64_t presentationPosition)
+{
+    stats.framesDisplayed.fetch_add (1, std::memory_order_relaxed);
+    
+    // A frame whose audio has already gone to the device by more than a frame's length is late
+    TimelinePoint::Values delivered;
+    
+    if (presentationPosition >= 0 && deliveredClock.read (delivered))
+    {
+        auto frameRate = videoFrameRate.load();
+        auto frameSamples = static_cast<int64_t>(sourceSampleRate.load() / (frameRate > 0.0 ? frameRate : 30.0));
         
-    auto* player = static_cast<VLCMediaPlayer*>(data);
-    if (player == nullptr)
-        return nullptr;
+        if (presentationPosition + frameSamples < delivered.position)
+            stats.framesLate.fetch_add (1, std::memory_order_relaxed);
+    }
     
-    // Return pointer to our video frame buffer
-    if (player->videoFrameBuffer != nullptr)
+    if (stats.isAwaitingSeekFrame.exchange (false))
     {
-        *planes = player->videoFrameBuffer.get();
-        return player->videoFrameBuffer.get();
+        auto requestedAt = stats.seekRequestedAt.exchange (0);
+        
+        if (requestedAt != 0)
+        {
+            auto latency = Time::getHighResolutionTicks() - requestedAt;
+            addStatsSample (stats.seekLatencyTicks, stats.maxSeekLatencyTicks, latency);
+            stats.lastSeekLatencyTicks = latency;
+            ++stats.numSeeks;
+        }
     }
+}
+
+//==============================================================================
+Array<VLCMediaPlayer::AudioTrackInfo> VLCMediaPlayer::getAudioTracks() const
+{
+    return audioTracks;
+}
+
+bool VLCMediaPlayer::setAudioTrack (int trackId)
+{
+    auto isTrack = [trackId] (const AudioTrackInfo& info) { return info.id == trackId; };
+    
+    if (std::none_of (audioTracks.begin(), audioTracks.end(), isTrack))
+        return false;
+    
+    selectedAudioTrack = trackId;
+    
+    // Before playback there are no ESes to switch; handleAsyncUpdate applies it once there are
+    if (mediaPlayer != nullptr && isPlaying())
+        libvlc_audio_set_track (mediaPlayer, trackId);
     
-    return nullptr;
+    return true;
 }
 
-void VLCMediaPlayer::videoUnlockCallback (void* data, void* picture, void* const* planes)
+int VLCMediaPlayer::getAudioTrack() const
 {
-    if (data == nullptr || picture == nullptr || planes == nullptr)
-        return;
+    if (selectedAudioTrack >= 0 || mediaPlayer == nullptr)
+        return selectedAudioTrack;
+    
+    return jmax (-1, libvlc_audio_get_track (mediaPlayer));
+}
+
+bool VLCMediaPlayer::setAudioStems (const Array<int>& trackIds)
+{
+    for (auto trackId : trackIds)
+    {
+        auto isTrack = [trackId] (const AudioTrackInfo& info) { return info.id == trackId; };
         
-    auto* player = static_cast<VLCMediaPlayer*>(data);
-    if (player == nullptr)
+        if (std::none_of (audioTracks.begin(), audioTracks.end(), isTrack))
+            return false;
+    }
+    
+    if (trackIds.isEmpty())
+    {
+        removeAudioStems();
+        return true;
+    }
+    
+    if (currentFile == File() || sharedInstance == nullptr)
+        return false;
+    
+    OwnedArray<VLCMediaPlayer> newStems;
+    
+    {
+        // Stems that are kept carry on decoding; the rest are destroyed outside the lock
+        const SpinLock::ScopedLockType lock (audioStemsLock);
+        
+        for (auto trackId : trackIds)
+        {
+            VLCMediaPlayer* existing = nullptr;
+            
+            for (int i = 0; i < audioStems.size() && existing == nullptr; ++i)
+                if (audioStems.getUnchecked (i)->stemTrackId == trackId)
+                    existing = audioStems.removeAndReturn (i);
+            
+            newStems.add (existing);
+        }
+    }
+    
+    for (int i = 0; i < trackIds.size(); ++i)
+    {
+        if (newStems.getUnchecked (i) != nullptr)
+            continue;
+        
+        // Opened on the same libVLC instance, so no plugins are loaded again
+        auto stem = std::make_unique<VLCMediaPlayer> (sharedInstance->getArguments());
+        stem->stemTrackId = trackIds.getUnchecked (i);
+        stem->setLatencyProfile (getLatencyProfile());
+        stem->setSyncTolerance (getSyncTolerance());
+        stem->setKeyframeIndexingEnabled (false);
+        stem->setOpenOptions ({ false, true });
+        stem->prepareAudioOutput (currentSampleRate.load(), deviceBlockSize.load(), outputLatencySamples.load());
+        
+        String error;
+        
+        if (! stem->open (currentFile, &error))
+        {
+            DBG ("VLCMediaPlayer::setAudioStems - Couldn't open stem " + String (trackIds.getUnchecked (i)) + ": " + error);
+            removeAudioStems();
+            return false;
+        }
+        
+        newStems.set (i, stem.release());
+    }
+    
+    {
+        const SpinLock::ScopedLockType lock (audioStemsLock);
+        audioStems.swapWith (newStems);
+    }
+    
+    updateAudioStems();
+    return true;
+}
+
+Array<int> VLCMediaPlayer::getAudioStems() const
+{
+    Array<int> trackIds;
+    
+    for (auto* stem : audioStems)
+        trackIds.add (stem->stemTrackId);
+    
+    return trackIds;
+}
+
+Range<int> VLCMediaPlayer::getAudioStemChannels (int stemIndex) const
+{
+    if (! isPositiveAndBelow (stemIndex, audioStems.size()))
+        return {};
+    
+    // Laid out the same way as renderAudioStems()
+    int firstChannel = numRingChannels.load();
+    
+    for (int i = 0; i < stemIndex; ++i)
+        firstChannel += audioStems.getUnchecked (i)->numRingChannels.load();
+    
+    return Range<int>::withStartAndLength (firstChannel, audioStems.getUnchecked (stemIndex)->numRingChannels.load());
+}
+
+void VLCMediaPlayer::updateAudioStems()
+{
+    if (audioStems.isEmpty())
         return;
     
-    // Video frame data is now available in the buffer
-    // We'll process it in the display callback
+    // While a seek is landing the clock still reads the old position, so stems head for the target
+    auto position = isSeeking() ? requestedSeekTime.load() : getCurrentTime();
+    
+    // Each stem corrects its own drift from this, like a player following a host
+    for (auto* stem : audioStems)
+        stem->followTransport (jmax (0.0, position), isPlaying(), playbackRate.load());
 }
 
-void VLCMediaPlayer::videoDisplayCallback (void* data, void* picture)
+void VLCMediaPlayer::renderAudioStems (float* const* outputChannelData, int numOutputChannels,
+                                       int numSamples, int64_t presentationTimeNs)
 {
-    if (data == nullptr || picture == nullptr)
+    // Stems are only swapped on the message thread; if one is happening, they sit this block out
+    const SpinLock::ScopedTryLockType lock (audioStemsLock);
+    if (! lock.isLocked())
         return;
+    
+    int firstChannel = numRingChannels.load();
+    
+    for (auto* stem : audioStems)
+    {
+        auto numChannels = stem->numRingChannels.load();
         
-    auto* player = static_cast<VLCMediaPlayer*>(data);
-    if (player == nullptr)
+        if (numChannels <= 0)
+            continue;
+        
+        if (firstChannel >= numOutputChannels)
+            break;
+        
+        stem->renderAudio (outputChannelData + firstChannel, jmin (numChannels, numOutputChannels - firstChannel),
+                           numSamples, presentationTimeNs);
+        firstChannel += numChannels;
+    }
+}
+
+void VLCMediaPlayer::removeAudioStems()
+{
+    OwnedArray<VLCMediaPlayer> oldStems;
+    
+    {
+        const SpinLock::ScopedLockType lock (audioStemsLock);
+        audioStems.swapWith (oldStems);
+    }
+    
+    // Each stem's player is stopped and released here, outside the lock
+}
+
+void VLCMediaPlayer::updateAudioPosition()
+{
+    if (mediaPlayer == nullptr || !isPlaying())
         return;
     
-    // Track frame count for debugging (only log occasionally)
-    static int frameCount = 0;
-    frameCount++;
-    if (frameCount == 1 || frameCount % 100 == 0)
+    // Get current time from libVLC
+    int64_t currentTimeMs = libvlc_media_player_get_time (mediaPlayer);
+    if (currentTimeMs >= 0)
     {
-        DBG("VLCMediaPlayer::videoDisplayCallback - Frame " + juce::String(frameCount) + 
-            " received, size: " + juce::String(player->videoWidth.load()) + "x" + 
-            juce::String(player->videoHeight.load()));
+        double currentTimeSeconds = static_cast<double>(currentTimeMs) / 1000.0;
+        double sampleRate = currentSampleRate.load();
+        if (sampleRate > 0.0)
+        {
+            int64_t newSamplePosition = static_cast<int64_t>(currentTimeSeconds * sampleRate);
+            currentAudioSample = newSamplePosition;
+        }
     }
+}
+
+void VLCMediaPlayer::updateVideoSize (int width, int height)
+{
+    videoWidth = width;
+    videoHeight = height;
     
-    // Convert the video frame buffer to JUCE Image
-    player->updateVideoFrameFromBuffer();
+    // May be on libVLC's decoder thread, so the component is resized from handleAsyncUpdate
+    postEvent (pendingVideoSizeChanged);
 }
 
-unsigned VLCMediaPlayer::videoFormatCallback (void** data, char* chroma, unsigned* width, 
-                                            unsigned* height, unsigned* pitches, unsigned* lines)
+Rectangle<int> VLCMediaPlayer::getOutputSizeFor (int sourceWidth, int sourceHeight) const
 {
-    // Safety check to prevent accessing freed memory
-    if (data == nullptr || *data == nullptr)
-        return 0;
+    double scale = 1.0;
+    
+    auto limitTo = [&] (int maxWidth, int maxHeight)
+    {
+        if (maxWidth > 0)
+            scale = jmin (scale, maxWidth / static_cast<double>(sourceWidth));
         
-    auto* player = static_cast<VLCMediaPlayer*>(*data);
+        if (maxHeight > 0)
+            scale = jmin (scale, maxHeight / static_cast<double>(sourceHeight));
+    };
+    
+    if (sourceWidth <= 0 || sourceHeight <= 0)
+        return { 0, 0, sourceWidth, sourceHeight };
+    
+    limitTo (maxOutputWidth.load(), maxOutputHeight.load());
+    
+    if (outputFollowsComponent.load())
+        limitTo (componentOutputWidth.load(), componentOutputHeight.load());
+    
+    if (scale >= 1.0)
+        return { 0, 0, sourceWidth, sourceHeight };
+    
+    // Even sizes, so 4:2:0 chroma planes stay whole
+    auto scaled = [scale] (int size) { return jmax (2, roundToInt (size * scale) & ~1); };
+    return { 0, 0, scaled (sourceWidth), scaled (sourceHeight) };
+}
+
+void VLCMediaPlayer::updateComponentOutputSize()
+{
+    int width = 0, height = 0;
+    
+    if (videoComponent != nullptr)
+    {
+        auto scale = Component::getApproximateScaleFactorForComponent (videoComponent.getComponent());
+        width = roundToInt (videoComponent->getWidth() * scale);
+        height = roundToInt (videoComponent->getHeight() * scale);
+    }
+    
+    componentOutputWidth = width;
+    componentOutputHeight = height;
+}
+
+void VLCMediaPlayer::requestOutputRenegotiation()
+{
+    auto* pool = videoFramePool.load();
+    
+    if (currentMedia == nullptr || pool == nullptr || videoOutputMode == VideoOutputMode::NativeWindow)
+        return;
     
-    // Additional safety check
-    if (player == nullptr)
-        return 0;
+    auto current = Rectangle<int> (0, 0, pool->formatWidth.load(), pool->formatHeight.load());
+    auto wanted = getOutputSizeFor (videoWidth.load(), videoHeight.load());
     
-    DBG("VLCMediaPlayer::videoFormatCallback - Setting up video format: " + 
-        juce::String(*width) + "x" + juce::String(*height));
+    if (current.isEmpty() || wanted.isEmpty())
+        return;
     
-    // Set format to RGBA
-    memcpy (chroma, "RV32", 4);
+    // Small changes aren't worth restarting the decoder for: only grow, or shrink by a quarter or more
+    bool needsLarger = wanted.getWidth() > current.getWidth() || wanted.getHeight() > current.getHeight();
+    bool canBeSmaller = wanted.getWidth() * 4 <= current.getWidth() * 3;
     
-    player->updateVideoSize (*width, *height);
+    if (! needsLarger && ! canBeSmaller)
+        return;
+    
+    // Wait for a resize drag to settle first
+    outputRenegotiationPending = true;
+    renegotiateOutputAt = Time::getMillisecondCounter() + 250;
+}
+
+void VLCMediaPlayer::renegotiateVideoOutput()
+{
+    outputRenegotiationPending = false;
     
-    *pitches = *width * 4; // 4 bytes per pixel for RGBA
-    *lines = *height;
+    int track = libvlc_video_get_track (mediaPlayer);
     
-    // Allocate video frame buffer
-    size_t bufferSize = (*width) * (*height) * 4; // RGBA = 4 bytes per pixel
-    player->videoFrameBufferSize = bufferSize;
-    player->videoFrameBuffer = std::make_unique<uint8_t[]>(bufferSize);
+    if (track < 0)
+        return;
     
-    DBG("VLCMediaPlayer::videoFormatCallback - Allocated video buffer: " + juce::String(bufferSize) + " bytes");
+    DBG ("VLCMediaPlayer::renegotiateVideoOutput - Restarting video output at "
+         + String (getOutputSizeFor (videoWidth.load(), videoHeight.load()).getWidth()) + " pixels wide");
     
-    return 1; // Success
+    // libVLC only asks for a format when its video output starts, so the track is reselected.
+    // The restarted decoder waits for a keyframe; seeking in place fills the gap.
+    libvlc_video_set_track (mediaPlayer, -1);
+    libvlc_video_set_track (mediaPlayer, track);
+    seekToTime (getCurrentTime(), SeekMode::Precise);
 }
 
-void VLCMediaPlayer::videoCleanupCallback (void* data)
+void VLCMediaPlayer::componentMovedOrResized (Component&, bool, bool wasResized)
 {
-    ignoreUnused (data);
+    if (! wasResized || ! outputFollowsComponent.load())
+        return;
+    
+    updateComponentOutputSize();
+    requestOutputRenegotiation();
 }
 
-// Event callback removed - using polling instead for compatibility
+void VLCMediaPlayer::setMaxVideoOutputSize (int maxWidth, int maxHeight)
+{
+    maxOutputWidth = jmax (0, maxWidth);
+    maxOutputHeight = jmax (0, maxHeight);
+    requestOutputRenegotiation();
+}
 
-//==============================================================================
-// Internal methods
-void VLCMediaPlayer::setupAudioCallbacks()
+Rectangle<int> VLCMediaPlayer::getMaxVideoOutputSize() const
 {
-    if (mediaPlayer == nullptr)
-        return;
-    
-    // For now, use default audio output - we'll route through JUCE's audio system
-    // This avoids libVLC audio callback API compatibility issues
-    // TODO: Implement proper audio routing in future versions
+    return { 0, 0, maxOutputWidth.load(), maxOutputHeight.load() };
 }
 
-void VLCMediaPlayer::setupVideoCallbacks()
+void VLCMediaPlayer::setVideoOutputFollowsComponent (bool shouldFollow)
 {
-    if (mediaPlayer == nullptr)
-        return;
-    
-    DBG("VLCMediaPlayer::setupVideoCallbacks - Setting up video callbacks for frame capture");
-    
-    // Enable video callbacks for frame capture
-    libvlc_video_set_callbacks (mediaPlayer,
-                               videoLockCallback,
-                               videoUnlockCallback,
-                               videoDisplayCallback,
-                               this);
-    
-    libvlc_video_set_format_callbacks (mediaPlayer,
-                                      videoFormatCallback,
-                                      videoCleanupCallback);
+    outputFollowsComponent = shouldFollow;
+    updateComponentOutputSize();
+    requestOutputRenegotiation();
 }
 
-void VLCMediaPlayer::setupVideoOutput()
+bool VLCMediaPlayer::isVideoOutputFollowingComponent() const
 {
-    if (mediaPlayer == nullptr)
-        return;
-    
-    // We use video memory callbacks (vmem) to capture frames into JUCE images,
-    // NOT native window rendering. The callbacks are set up in setupVideoCallbacks().
-    // Do NOT set native window handles (nsobject/hwnd/xwindow) as they conflict
-    // with the callback-based approach.
-    
-    DBG ("Video output configured for memory callbacks (vmem)");
-    DBG ("  Video component: " + (videoComponent != nullptr ? 
-        juce::String::toHexString ((juce::pointer_sized_int)videoComponent.getComponent()) : "none"));
-    
-    // Note: If you want to render directly to a native window instead of using callbacks,
-    // uncomment the native window code below and remove setupVideoCallbacks() from open().
-    // The two approaches are mutually exclusive.
-    
-    /*
-    // Native window rendering (alternative to callbacks):
-    if (videoComponent != nullptr)
-    {
-        #if JUCE_WINDOWS
-            auto windowHandle = videoComponent->getWindowHandle();
-            libvlc_media_player_set_hwnd (mediaPlayer, windowHandle);
-        #elif JUCE_MAC
-            auto windowHandle = videoComponent->getWindowHandle();
-            libvlc_media_player_set_nsobject (mediaPlayer, windowHandle);
-        #elif JUCE_LINUX
-            auto windowHandle = videoComponent->getWindowHandle();
-            libvlc_media_player_set_xwindow (mediaPlayer, (uint32_t)(juce::pointer_sized_int)windowHandle);
-        #endif
-    }
-    */
+    return outputFollowsComponent.load();
 }
 
-void VLCMediaPlayer::setupEventHandling()
+Rectangle<int> VLCMediaPlayer::getVideoOutputSize() const
 {
-    if (mediaPlayer == nullptr)
-        return;
+    if (auto* pool = videoFramePool.load())
+        return { 0, 0, pool->formatWidth.load(), pool->formatHeight.load() };
     
-    // Simplified event handling - avoid libVLC event API compatibility issues
-    // We'll use polling in timerCallback() instead
-    // TODO: Implement proper event handling in future versions
+    return {};
 }
 
-void VLCMediaPlayer::updateMediaInfo()
+juce::Image VLCMediaPlayer::getCurrentVideoFrame() const
 {
-    if (currentMedia == nullptr)
+    // Scrubbing back over cached frames shows the target straight away, not when the seek lands
+    if (frameCacheEnabled.load() && isSeeking())
     {
-        DBG("VLCMediaPlayer::updateMediaInfo - No current media");
-        return;
+        auto cached = getFrameAt (requestedSeekTime.load());
+        
+        if (cached.isValid())
+            return cached;
     }
     
-    DBG("VLCMediaPlayer::updateMediaInfo - Updating media information");
-    
-    // Get duration
-    int64_t durationMs = libvlc_media_get_duration (currentMedia);
-    DBG("VLCMediaPlayer::updateMediaInfo - Duration from libVLC: " + juce::String(durationMs) + " ms");
+    auto* pool = videoFramePool.load();
+    if (pool == nullptr)
+        return {};
     
-    if (durationMs > 0)
-    {
-        mediaDuration = static_cast<double>(durationMs) / 1000.0;
-        DBG("VLCMediaPlayer::updateMediaInfo - Set mediaDuration to: " + juce::String(mediaDuration.load()) + " seconds");
-        
-        double sampleRate = currentSampleRate.load();
-        if (sampleRate > 0.0)
-        {
-            totalAudioSamples = static_cast<int64_t>(mediaDuration.load() * sampleRate);
-            DBG("VLCMediaPlayer::updateMediaInfo - Calculated totalAudioSamples: " + juce::String(totalAudioSamples.load()));
-        }
-    }
-    else if (durationMs == 0)
-    {
-        DBG("VLCMediaPlayer::updateMediaInfo - Duration is 0, might be a live stream or unknown duration");
-        mediaDuration = -1.0;  // Keep as unknown
-    }
-    else
-    {
-        DBG("VLCMediaPlayer::updateMediaInfo - Duration is negative (" + juce::String(durationMs) + "), media not yet parsed");
-        mediaDuration = -1.0;  // Keep as unknown until parsing completes
-    }
+    // VLC's RV32 format is BGRA (32-bit with bytes: B, G, R, A in memory)
+    // JUCE's ARGB format is also stored as BGRA in memory (little-endian),
+    // so libVLC decodes directly into the image without any channel swapping
+    int64_t holdUpTo;
+    auto showUpTo = getPresentationLimit (holdUpTo);
     
-    // Check for audio/video tracks using media tracks (not player tracks)
-    // Note: libvlc_audio_get_track_count and libvlc_video_get_track_count only work after playback starts
-    // We need to use libvlc_media_tracks_get to get track info from parsed media
-    if (currentMedia != nullptr)
+    if (auto* slot = pool->acquireForReading (showUpTo, holdUpTo))
     {
-        libvlc_media_track_t** tracks = nullptr;
-        unsigned int trackCount = libvlc_media_tracks_get(currentMedia, &tracks);
-        
-        DBG("VLCMediaPlayer::updateMediaInfo - Total track count from media: " + juce::String(trackCount));
-        
-        int audioTrackCount = 0;
-        int videoTrackCount = 0;
-        
-        for (unsigned int i = 0; i < trackCount; ++i)
-        {
-            if (tracks[i] != nullptr)
-            {
-                switch (tracks[i]->i_type)
-                {
-                    case libvlc_track_audio:
-                        audioTrackCount++;
-                        DBG("VLCMediaPlayer::updateMediaInfo - Found audio track " + juce::String(i));
-                        break;
-                    case libvlc_track_video:
-                        videoTrackCount++;
-                        DBG("VLCMediaPlayer::updateMediaInfo - Found video track " + juce::String(i) + 
-                            " - " + juce::String(tracks[i]->video->i_width) + "x" + juce::String(tracks[i]->video->i_height));
-                        
-                        // Store video dimensions
-                        if (tracks[i]->video != nullptr)
-                        {
-                            videoWidth = tracks[i]->video->i_width;
-                            videoHeight = tracks[i]->video->i_height;
-                        }
-                        break;
-                    case libvlc_track_text:
-                        DBG("VLCMediaPlayer::updateMediaInfo - Found subtitle track " + juce::String(i));
-                        break;
-                    default:
-                        DBG("VLCMediaPlayer::updateMediaInfo - Found unknown track type " + juce::String(tracks[i]->i_type));
-                        break;
-                }
-            }
-        }
-        
-        // Release track info
-        if (tracks != nullptr)
-        {
-            libvlc_media_tracks_release(tracks, trackCount);
-        }
-        
-        DBG("VLCMediaPlayer::updateMediaInfo - Audio track count: " + juce::String(audioTrackCount));
-        DBG("VLCMediaPlayer::updateMediaInfo - Video track count: " + juce::String(videoTrackCount));
+        auto presentation = slot->presentationPosition.load (std::memory_order_relaxed);
         
-        hasAudioStream = (audioTrackCount > 0);
-        hasVideoStream = (videoTrackCount > 0);
+        if (presentation >= 0)
+            stats.avOffsetSeconds = getMediaTimeForPresentation (presentation) - getCurrentTime();
         
-        DBG("VLCMediaPlayer::updateMediaInfo - hasAudioStream: " + juce::String(hasAudioStream.load() ? "true" : "false"));
-        DBG("VLCMediaPlayer::updateMediaInfo - hasVideoStream: " + juce::String(hasVideoStream.load() ? "true" : "false"));
+        return slot->image;    // Invalid while a YUV pixel format is active
     }
-    else
+    
+    return {};
+}
+
+void VLCMediaPlayer::setFrameCacheSettings (const FrameCacheSettings& settings)
+{
+    frameCacheSettings = settings;
+    frameCacheDownscale = jmax (1, settings.downscale);
+    
+    if (settings.maxBytes == 0)
     {
-        DBG("VLCMediaPlayer::updateMediaInfo - No current media available");
+        frameCacheEnabled = false;
+        frameCacheWriter = nullptr;
+        frameCache = nullptr;
+        return;
     }
     
-    // Notify listeners that media is ready
-    notifyListeners ([this](Listener* l) { l->mediaReady (this); });
+    if (frameCache == nullptr)
+        frameCache = std::make_unique<FrameCache> (settings.maxBytes);
+    
+    frameCache->setMaxBytes (settings.maxBytes);
+    frameCache->setCompressionQuality (settings.compressionQuality);
+    
+    if (frameCacheWriter == nullptr)
+        frameCacheWriter = std::make_unique<FrameCacheWriter> (*this);
+    
+    frameCacheEnabled = true;
 }
 
-void VLCMediaPlayer::notifyListeners (std::function<void(Listener*)> callback)
+VLCMediaPlayer::FrameCacheSettings VLCMediaPlayer::getFrameCacheSettings() const
 {
-    listeners.call ([&callback](Listener& l) { callback (&l); });
+    return frameCacheSettings;
 }
 
-void VLCMediaPlayer::processAudioData (void* buffer, size_t size)
+juce::Image VLCMediaPlayer::getFrameAt (double timeInSeconds) const
 {
-    if (audioRingBuffer == nullptr || buffer == nullptr || size == 0)
-        return;
-    
-    // Assume 32-bit float, stereo
-    int numSamples = static_cast<int>(size / (sizeof(float) * 2));
-    float* audioData = static_cast<float*>(buffer);
+    if (frameCache == nullptr || timeInSeconds < 0.0)
+        return {};
     
-    int writePos = audioRingBuffer->writePosition.load();
-    int availableSpace = audioRingBuffer->numSamples - audioRingBuffer->availableSamples.load();
-    int samplesToWrite = jmin (numSamples, availableSpace);
+    auto mediaId = frameCacheMediaId.load();
+    auto frameRate = videoFrameRate.load();
     
-    if (samplesToWrite > 0)
+    if (frameRate > 0.0)
     {
-        for (int i = 0; i < samplesToWrite; ++i)
-        {
-            int bufferIndex = (writePos + i) % audioRingBuffer->numSamples;
-            audioRingBuffer->data[0][bufferIndex] = audioData[i * 2];     // Left
-            audioRingBuffer->data[1][bufferIndex] = audioData[i * 2 + 1]; // Right
-        }
-        
-        audioRingBuffer->writePosition = (writePos + samplesToWrite) % audioRingBuffer->numSamples;
-        audioRingBuffer->availableSamples += samplesToWrite;
+        // The frame on screen at a time is the last one that started at or before it
+        auto frameStart = std::floor (timeInSeconds * frameRate + 1.0e-3) / frameRate;
+        return frameCache->get (mediaId, getFrameCacheTime (frameStart));
     }
+    
+    return frameCache->getAtOrBefore (mediaId, getFrameCacheTime (timeInSeconds), 50000);
 }
 
-void VLCMediaPlayer::updateAudioPosition()
+double VLCMediaPlayer::getVideoFrameRate() const
 {
-    if (mediaPlayer == nullptr || !isPlaying())
-        return;
+    return videoFrameRate.load();
+}
+
+double VLCMediaPlayer::getMediaTimeForPresentation (int64_t presentationPosition) const
+{
+    auto deviceRate = jmax (1.0, currentSampleRate.load());
+    TimelinePoint::Values delivered;
     
-    // Get current time from libVLC
-    int64_t currentTimeMs = libvlc_media_player_get_time (mediaPlayer);
-    if (currentTimeMs >= 0)
+    // Frames are stamped with the ring position they play with; map that through the audio clock
+    if (presentationPosition >= 0 && deliveredClock.read (delivered))
     {
-        double currentTimeSeconds = static_cast<double>(currentTimeMs) / 1000.0;
-        double sampleRate = currentSampleRate.load();
-        if (sampleRate > 0.0)
-        {
-            int64_t newSamplePosition = static_cast<int64_t>(currentTimeSeconds * sampleRate);
-            currentAudioSample = newSamplePosition;
-        }
+        auto ringRate = jmax (1.0, sourceSampleRate.load());
+        auto offset = static_cast<double>(presentationPosition - delivered.position);
+        
+        if (std::abs (offset) < ringRate * 2.0)
+            return (static_cast<double>(delivered.sample) + offset * deviceRate / ringRate * playbackRate.load()) / deviceRate;
     }
+    
+    // Without audio (or while paused after a seek) libVLC's own clock is as close as it gets
+    return getCurrentTime();
 }
 
-void VLCMediaPlayer::updateVideoSize (int width, int height)
+int64 VLCMediaPlayer::getFrameCacheTime (double timeInSeconds) const
 {
-    videoWidth = width;
-    videoHeight = height;
+    auto frameRate = videoFrameRate.load();
     
-    if (videoComponent != nullptr)
-    {
-        MessageManager::callAsync ([this, width, height]()
-        {
-            if (videoComponent != nullptr)
-                videoComponent->setSize (width, height);
-        });
-    }
+    // Snapping to the frame grid absorbs the jitter in working out when a frame was shown
+    if (frameRate > 0.0)
+        return static_cast<int64>(std::llround (std::llround (timeInSeconds * frameRate) * 1.0e6 / frameRate));
+    
+    return static_cast<int64>(std::llround (timeInSeconds * 1.0e6));
 }
 
-void VLCMediaPlayer::updateVideoFrameFromBuffer()
+void VLCMediaPlayer::resetFrameCache()
 {
-    if (videoFrameBuffer == nullptr || videoFrameBufferSize == 0)
-        return;
+    auto previousId = frameCacheMediaId++;
+    
+    if (frameCache != nullptr)
+        frameCache->remove (previousId);
+}
+
+void VLCMediaPlayer::setVideoPixelFormat (VideoPixelFormat format)
+{
+    requestedPixelFormat = static_cast<int>(format);
+}
+
+VLCMediaPlayer::VideoPixelFormat VLCMediaPlayer::getVideoPixelFormat() const
+{
+    return static_cast<VideoPixelFormat>(requestedPixelFormat.load());
+}
+
+bool VLCMediaPlayer::getCurrentVideoFrameView (VideoFrameView& view) const
+{
+    auto* pool = videoFramePool.load();
+    if (pool == nullptr)
+        return false;
     
-    int width = videoWidth.load();
-    int height = videoHeight.load();
+    int64_t holdUpTo;
+    auto showUpTo = getPresentationLimit (holdUpTo);
     
-    if (width <= 0 || height <= 0)
-        return;
+    auto* slot = pool->acquireForReading (showUpTo, holdUpTo);
+    if (slot == nullptr)
+        return false;
     
-    std::lock_guard<std::mutex> lock(videoFrameMutex);
+    view.format = slot->format;
+    view.width = slot->width;
+    view.height = slot->height;
+    view.numPlanes = slot->numPlanes;
+    view.sequenceNumber = slot->sequenceNumber;
     
-    // Create or recreate the JUCE Image if dimensions changed
-    if (!currentVideoFrame.isValid() || 
-        currentVideoFrame.getWidth() != width || 
-        currentVideoFrame.getHeight() != height)
+    for (int plane = 0; plane < VideoFramePool::maxPlanes; ++plane)
     {
-        currentVideoFrame = juce::Image(juce::Image::ARGB, width, height, true);
-        DBG("VLCMediaPlayer::updateVideoFrameFromBuffer - Created new video frame: " + 
-            juce::String(width) + "x" + juce::String(height));
+        bool used = plane < slot->numPlanes;
+        view.planes[plane] = used ? slot->planes[plane] : nullptr;
+        view.pitches[plane] = used ? slot->pitches[plane] : 0;
+        view.lines[plane] = used ? slot->lines[plane] : 0;
     }
     
-    // Copy video data from VLC buffer to JUCE Image
-    juce::Image::BitmapData bitmapData(currentVideoFrame, juce::Image::BitmapData::writeOnly);
+    return true;
+}
+
+VLCMediaPlayer::VideoFrame VLCMediaPlayer::getCurrentVideoFrameHandle() const
+{
+    auto* pool = videoFramePool.load();
+    if (pool == nullptr)
+        return {};
+    
+    int64_t holdUpTo;
+    auto showUpTo = getPresentationLimit (holdUpTo);
     
-    // VLC's RV32 format is BGRA (32-bit with bytes: B, G, R, A in memory)
-    // JUCE's ARGB format on macOS is also stored as BGRA in memory (little-endian)
-    // So we can copy directly without channel swapping
-    const uint8_t* srcData = videoFrameBuffer.get();
-    uint8_t* destData = bitmapData.data;
+    // The reading slot is never freed or written under us, so taking a hold on it here is safe
+    if (auto* slot = pool->acquireForReading (showUpTo, holdUpTo))
+        return VideoFrame (*slot);
     
-    // Calculate source pitch (bytes per row)
-    int srcPitch = width * 4;
+    return {};
+}
+
+//==============================================================================
+VLCMediaPlayer::VideoFrame::VideoFrame (VideoFramePool::Slot& slotToHold) noexcept
+    : slot (&slotToHold)
+{
+    slot->numHolders.fetch_add (1, std::memory_order_relaxed);
+}
+
+VLCMediaPlayer::VideoFrame::VideoFrame (const VideoFrame& other) noexcept
+    : slot (other.slot)
+{
+    if (slot != nullptr)
+        slot->numHolders.fetch_add (1, std::memory_order_relaxed);
+}
+
+VLCMediaPlayer::VideoFrame::VideoFrame (VideoFrame&& other) noexcept
+    : slot (std::exchange (other.slot, nullptr))
+{
+}
+
+VLCMediaPlayer::VideoFrame& VLCMediaPlayer::VideoFrame::operator= (const VideoFrame& other) noexcept
+{
+    // Taken before the old one is dropped, so assigning a handle to itself is harmless
+    if (other.slot != nullptr)
+        other.slot->numHolders.fetch_add (1, std::memory_order_relaxed);
     
-    // Copy row by row to handle different line strides
-    for (int y = 0; y < height; ++y)
+    reset();
+    slot = other.slot;
+    return *this;
+}
+
+VLCMediaPlayer::VideoFrame& VLCMediaPlayer::VideoFrame::operator= (VideoFrame&& other) noexcept
+{
+    if (this != &other)
     {
-        const uint8_t* srcRow = srcData + (y * srcPitch);
-        uint8_t* destRow = destData + (y * bitmapData.lineStride);
-        
-        // Direct copy - VLC BGRA matches JUCE ARGB memory layout on macOS
-        std::memcpy(destRow, srcRow, srcPitch);
+        reset();
+        slot = std::exchange (other.slot, nullptr);
     }
+    
+    return *this;
 }
 
-juce::Image VLCMediaPlayer::getCurrentVideoFrame() const
+VLCMediaPlayer::VideoFrame::~VideoFrame()
+{
+    reset();
+}
+
+void VLCMediaPlayer::VideoFrame::reset() noexcept
+{
+    // Releasing orders this holder's reads before libVLC's next write into the slot
+    if (slot != nullptr)
+        std::exchange (slot, nullptr)->numHolders.fetch_sub (1, std::memory_order_release);
+}
+
+VLCMediaPlayer::VideoPixelFormat VLCMediaPlayer::VideoFrame::getFormat() const noexcept
+{
+    return slot != nullptr ? slot->format : VideoPixelFormat::RGB32;
+}
+
+int VLCMediaPlayer::VideoFrame::getWidth() const noexcept
+{
+    return slot != nullptr ? slot->width : 0;
+}
+
+int VLCMediaPlayer::VideoFrame::getHeight() const noexcept
+{
+    return slot != nullptr ? slot->height : 0;
+}
+
+int VLCMediaPlayer::VideoFrame::getNumPlanes() const noexcept
+{
+    return slot != nullptr ? slot->numPlanes : 0;
+}
+
+const uint8_t* VLCMediaPlayer::VideoFrame::getPlane (int plane) const noexcept
+{
+    return slot != nullptr && isPositiveAndBelow (plane, slot->numPlanes) ? slot->planes[plane] : nullptr;
+}
+
+int VLCMediaPlayer::VideoFrame::getPitch (int plane) const noexcept
+{
+    return slot != nullptr && isPositiveAndBelow (plane, slot->numPlanes) ? slot->pitches[plane] : 0;
+}
+
+int VLCMediaPlayer::VideoFrame::getNumLines (int plane) const noexcept
+{
+    return slot != nullptr && isPositiveAndBelow (plane, slot->numPlanes) ? slot->lines[plane] : 0;
+}
+
+uint64_t VLCMediaPlayer::VideoFrame::getSequenceNumber() const noexcept
+{
+    return slot != nullptr ? slot->sequenceNumber : 0;
+}
+
+double VLCMediaPlayer::VideoFrame::getTime() const noexcept
+{
+    return slot != nullptr ? slot->timeInSeconds : -1.0;
+}
+
+Image VLCMediaPlayer::VideoFrame::getImage() const
 {
-    std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(videoFrameMutex));
-    return currentVideoFrame;
+    return slot != nullptr && slot->format == VideoPixelFormat::RGB32 ? slot->image : Image();
 }
 
 } // namespace juce
@@ -8,9 +8,16 @@
 #pragma once
 
 #include "ISeekableMedia.h"
+#include "AudioDeinterleaver.h"
+#include "VLCInstanceManager.h"
+#include "KeyframeIndex.h"
+#include "FrameCache.h"
+#include "RealtimeChecks.h"
+#include "../juce_libvlc_config.h"
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_audio_devices/juce_audio_devices.h>
 #include <atomic>
+#include <limits>
 #include <memory>
 #include <mutex>
 
@@ -18,6 +25,7 @@
 struct libvlc_instance_t;
 struct libvlc_media_player_t;
 struct libvlc_media_t;
+struct libvlc_event_t;
 
 namespace juce
 {
@@ -29,16 +37,63 @@ namespace juce
  */
 class VLCMediaPlayer : public ISeekableMedia,
                        public AudioIODeviceCallback,
-                       public Timer
+                       public Timer,
+                       private AsyncUpdater,
+                       private ComponentListener
 {
 public:
     //==============================================================================
+    /** Creates a player on the shared instance for the default arguments. */
     VLCMediaPlayer();
+    
+    /**
+     * Creates a player on the shared instance for a custom libVLC argument set.
+     * Players passing identical arguments share one instance.
+     */
+    explicit VLCMediaPlayer (const StringArray& vlcArguments);
+    
+    /**
+     * Stops playback and frees the player. Blocks for up to two seconds while any
+     * VideoFrame handles are still held, since they point into the frame pool.
+     */
     ~VLCMediaPlayer() override;
 
     //==============================================================================
     // ISeekableMedia implementation
+    
+    /**
+     * Opens a media file without blocking. libVLC parses the file in the background,
+     * and Listener::mediaReady is called on the message thread once duration and
+     * track information are available (or mediaError if parsing fails or times out).
+     * Playback can be started before then.
+     */
     bool open(const File& media, String* error = nullptr) override;
+    
+    /**
+     * Opens media from a stream, read through libvlc_media_new_callbacks instead of
+     * a file. Memory streams are read in place; other streams should be seekable
+     * for seeking to work. Listener::mediaReady follows as for files.
+     */
+    bool open (std::unique_ptr<InputStream> stream, String* error = nullptr);
+    
+    /** Opens media held in a memory block, which is moved into the player rather than copied. */
+    bool open (MemoryBlock data, String* error = nullptr);
+    
+    /** Opens media in a caller's buffer, read in place. The buffer must outlive the media. */
+    bool open (const void* data, size_t numBytes, String* error = nullptr);
+    
+    /**
+     * Opens a memory-mapped file or a range of one, such as an asset inside a
+     * bundle. libVLC reads straight from the mapping.
+     */
+    bool open (std::unique_ptr<MemoryMappedFile> mappedFile, String* error = nullptr);
+    
+    /**
+     * Opens a URL with libvlc_media_new_location, so libVLC's own access modules
+     * (http, rtsp, smb and so on) fetch it. file:// URLs open as files.
+     */
+    bool open (const URL& url, String* error = nullptr);
+    
     void close() override;
     
     void play() override;
@@ -54,6 +109,13 @@ public:
     
     int getSampleRate() const override;
     int64_t getTotalSamples() const override;
+    
+    /**
+     * Returns the sample being heard right now. While the audio device is running
+     * this comes from the samples actually delivered to it, interpolated between
+     * callbacks with the device's host time; otherwise it falls back to libVLC's
+     * millisecond clock.
+     */
     int64_t getCurrentSample() const override;
     double getTotalDuration() const override;
     double getCurrentTime() const override;
@@ -62,8 +124,500 @@ public:
     Rectangle<int> getVideoSize() const override;
     
     // Video frame access
+    
+    /**
+     * Returns the most recently decoded video frame.
+     * The image shares its pixels with the decoder's frame pool: it stays intact
+     * until the next call to this method, after which its slot may be reused.
+     * Should be called from a single thread (usually the message thread).
+     */
     juce::Image getCurrentVideoFrame() const;
     
+    /** Pixel layouts libVLC can be asked to decode into. */
+    enum class VideoPixelFormat
+    {
+        RGB32,      ///< Packed BGRA, usable directly as a juce::Image
+        I420,       ///< Planar 8-bit YUV 4:2:0 (Y, U and V planes)
+        NV12        ///< Semi-planar 8-bit YUV 4:2:0 (Y plane, interleaved UV plane)
+    };
+    
+    /**
+     * Chooses the pixel layout requested from libVLC. Takes effect the next time
+     * libVLC negotiates its video output, i.e. on the next play() after open().
+     * YUV layouts roughly halve upload bandwidth for GPU renderers, but while one
+     * is active getCurrentVideoFrame() returns an invalid image.
+     */
+    void setVideoPixelFormat (VideoPixelFormat format);
+    VideoPixelFormat getVideoPixelFormat() const;
+    
+    /** A read-only view of a decoded frame's planes, exactly as libVLC wrote them. */
+    struct VideoFrameView
+    {
+        VideoPixelFormat format = VideoPixelFormat::RGB32;
+        int width = 0;
+        int height = 0;
+        int numPlanes = 0;
+        const uint8_t* planes[3] {};
+        int pitches[3] {};              ///< Bytes per row of each plane
+        int lines[3] {};                ///< Rows allocated for each plane
+        uint64_t sequenceNumber = 0;    ///< Increases with every published frame
+    };
+    
+    /**
+     * Fills view with the most recently decoded frame without copying it.
+     * Same contract as getCurrentVideoFrame(): the planes stay intact until the
+     * next call to either method, and only one thread may call them.
+     * @return false if no frame has been decoded yet
+     */
+    bool getCurrentVideoFrameView (VideoFrameView& view) const;
+    
+    /** A reference-counted handle to a decoded frame, shared without copying (see below). */
+    class VideoFrame;
+    
+    /**
+     * Returns a handle to the most recently decoded frame. It's picked the same way
+     * as by getCurrentVideoFrame(), and the same single-thread rule applies, but the
+     * pixels stay intact for as long as the handle is held, even if the player is
+     * closed or opens other media in the meantime. Renderers on their own thread
+     * should use this rather than getCurrentVideoFrameView().
+     * @return an invalid handle if no frame has been decoded yet
+     */
+    VideoFrame getCurrentVideoFrameHandle() const;
+    
+    /**
+     * Receives every frame the player presents, as a VideoFrame handle. Any number
+     * of listeners share the same decode buffer: libVLC only decodes into it again
+     * once every handle to it has been released.
+     */
+    class FrameListener
+    {
+    public:
+        virtual ~FrameListener() = default;
+        
+        /**
+         * Called on libVLC's video output thread as each frame is presented. Keep
+         * it short: copy the handle and hand it to your own thread. Frames that are
+         * held up stall decoding once the pool's spare buffers run out, after which
+         * new frames are dropped until handles are released.
+         */
+        virtual void videoFrameReady (VLCMediaPlayer* player, const VideoFrame& frame) = 0;
+    };
+    
+    /**
+     * Adds or removes a frame listener. Safe from any thread; once removeFrameListener()
+     * returns, the listener isn't called again. Frames only reach listeners in
+     * MemoryCallbacks mode. Handles should be released before the player is destroyed,
+     * whose destructor waits for them (see VideoFrame).
+     */
+    void addFrameListener (FrameListener* listener);
+    void removeFrameListener (FrameListener* listener);
+    
+    /**
+     * Limits the size of the frames libVLC hands over. Larger video is scaled down
+     * by libVLC, keeping its aspect ratio, before it's copied into the frame pool,
+     * so small previews don't pay for full-resolution frames. 0 means no limit.
+     * getVideoSize() still reports the media's own size.
+     */
+    void setMaxVideoOutputSize (int maxWidth, int maxHeight);
+    Rectangle<int> getMaxVideoOutputSize() const;
+    
+    /**
+     * When on, frames are also limited to the video component's size in physical
+     * pixels, and the output is renegotiated shortly after the component is resized.
+     * The component is then no longer resized to match the video.
+     * Must be called on the message thread.
+     */
+    void setVideoOutputFollowsComponent (bool shouldFollow);
+    bool isVideoOutputFollowingComponent() const;
+    
+    /** Returns the size of the frames libVLC is currently delivering. */
+    Rectangle<int> getVideoOutputSize() const;
+    
+    //==============================================================================
+    /** How many recently decoded frames are kept for scrubbing back over. */
+    struct FrameCacheSettings
+    {
+        size_t maxBytes = 0;                // Memory the cached frames may use; 0 turns the cache off
+        int downscale = 1;                  // Frames are stored at 1/downscale of their decoded size
+        float compressionQuality = 0.0f;    // JPEG quality for stored frames, or 0 to store them raw
+    };
+    
+    /**
+     * Turns the decoded-frame cache on or off. While it's on, every RGB32 frame
+     * libVLC displays is copied into a memory-budgeted LRU cache, keyed by its
+     * time in the media. Jogging back over recent frames is then answered from the
+     * cache: getFrameAt() returns them directly, and getCurrentVideoFrame() returns
+     * the cached frame for a seek target while the seek is still landing.
+     * Off by default. Must be called on the message thread.
+     */
+    void setFrameCacheSettings (const FrameCacheSettings& settings);
+    FrameCacheSettings getFrameCacheSettings() const;
+    
+    /**
+     * Returns the cached frame shown at a time, without decoding, or an invalid
+     * image if it isn't cached. Call it from the same thread as getCurrentVideoFrame().
+     */
+    juce::Image getFrameAt (double timeInSeconds) const;
+    
+    /** Returns the video track's frame rate, or 0 until the media has been parsed. */
+    double getVideoFrameRate() const;
+    
+    //==============================================================================
+    /** How decoded video reaches the screen. */
+    enum class VideoOutputMode
+    {
+        MemoryCallbacks,    ///< libVLC decodes into our frame pool (frames are available in CPU memory)
+        NativeWindow        ///< libVLC's own hardware-accelerated vout renders into a native child window
+    };
+    
+    /**
+     * Chooses the video output mode. It's applied by open(), setVideoComponent() and
+     * play(), and takes effect the next time libVLC starts its video output.
+     * NativeWindow needs a video component that is on screen; until it has a native
+     * peer, memory callbacks are used instead. No frames are available from
+     * getCurrentVideoFrame() while VLC renders natively.
+     * Must be called on the message thread.
+     */
+    void setVideoOutputMode (VideoOutputMode mode);
+    VideoOutputMode getVideoOutputMode() const;
+    
+    /**
+     * Sets how long open() lets libVLC parse a file's metadata before giving up.
+     * Applies to the next call to open().
+     */
+    void setParseTimeout (int timeoutMilliseconds);
+    int getParseTimeout() const;
+    
+    /** Which of the media's streams open() and preload() decode. */
+    struct OpenOptions
+    {
+        /**
+         * With video off, libVLC never starts a video decoder or output, no frame
+         * memory is allocated and hasVideo() is false, for background players that
+         * only need the soundtrack. Subtitles are off too.
+         */
+        bool decodeVideo = true;
+        
+        /** With audio off, no audio decoder runs and the clock comes from libVLC alone. */
+        bool decodeAudio = true;
+    };
+    
+    /**
+     * Chooses the streams to decode. Applies to the next call to open() or preload().
+     * To decode video at a smaller size instead of not at all, see setMaxVideoOutputSize().
+     * Must be called on the message thread.
+     */
+    void setOpenOptions (const OpenOptions& options);
+    OpenOptions getOpenOptions() const;
+    
+    //==============================================================================
+    /** Trade-offs between how quickly audio reaches the device and how well it rides out stalls. */
+    enum class LatencyProfile
+    {
+        Live,       // 100 ms of input caching, a ring of a few device blocks, for monitoring
+        Balanced,   // 300 ms of input caching, about half a second in the ring
+        Robust      // 1 s of input caching, JUCE_LIBVLC_AUDIO_BUFFER_SIZE in the ring
+    };
+    
+    /**
+     * Chooses how much audio is buffered between libVLC and the device. The ring
+     * is sized from the profile, the device's block size and the media's sample
+     * rate, and libVLC's file, network and live caching are set to match.
+     * Applies to the next call to open() or preload(). The default is Robust.
+     */
+    void setLatencyProfile (LatencyProfile profile);
+    LatencyProfile getLatencyProfile() const;
+    
+    /** Returns how many seconds of audio are buffered and not yet handed to the device. */
+    double getAudioBufferLevel() const;
+    
+    /** Returns how many seconds of audio the ring can hold. */
+    double getAudioBufferCapacity() const;
+    
+    /** Returns how many device blocks ran out of audio while playing, since open(). */
+    int getNumAudioUnderruns() const;
+    
+    //==============================================================================
+    /** A snapshot of the player's performance counters. Counts run from open(). */
+    struct Stats
+    {
+        // Video handoff, counted in libVLC's callbacks
+        int64 framesDecoded = 0;            // Pictures libVLC decoded into our frame slots
+        int64 framesDisplayed = 0;          // Pictures libVLC presented to us
+        int64 framesLate = 0;               // Presented after the audio they belong with was already heard
+        int64 framesDropped = 0;            // Pictures libVLC discarded as too late (from its stats)
+        double averageFrameCopyMs = 0.0;    // Copying presented frames into the frame cache, if enabled
+        double maxFrameCopyMs = 0.0;
+        
+        // Audio output
+        double audioBufferLevel = 0.0;      // Seconds waiting in the ring
+        double audioBufferCapacity = 0.0;   // Seconds the ring holds
+        int audioUnderruns = 0;             // Device blocks that ran out of audio
+        double averageAudioCallbackMs = 0.0;
+        double maxAudioCallbackMs = 0.0;
+        int64 audioBuffersLost = 0;         // Audio blocks libVLC dropped (from its stats)
+        
+        // Seeking: from seekToTime() to the first frame presented after it lands
+        int numSeeks = 0;
+        double lastSeekLatencyMs = 0.0;
+        double averageSeekLatencyMs = 0.0;
+        double maxSeekLatencyMs = 0.0;
+        
+        // How far the last frame handed out was ahead of (positive) or behind the audio being heard
+        double avOffsetMs = 0.0;
+        
+        // libvlc_media_get_stats()
+        int64 inputBytesRead = 0;
+        int64 demuxBytesRead = 0;
+        double inputBitrate = 0.0;          // Bits per second
+        double demuxBitrate = 0.0;
+        int64 demuxCorrupted = 0;
+        int64 demuxDiscontinuities = 0;
+        int64 videoBlocksDecoded = 0;
+        int64 audioBlocksDecoded = 0;
+    };
+    
+    /**
+     * Returns the current counters. The counters themselves are lock-free atomics
+     * updated on the threads being measured; this call also asks libVLC for its
+     * input statistics, so poll it from a timer rather than from a realtime thread.
+     */
+    Stats getStats() const;
+    
+    /** Zeroes the counters, e.g. before measuring one scene. */
+    void resetStats();
+    
+    //==============================================================================
+    /** Describes one of the media's audio tracks. */
+    struct AudioTrackInfo
+    {
+        int id = -1;                // libVLC's track id, as passed to setAudioTrack()
+        String name;                // The track's description, if the container has one
+        String language;
+        String codec;
+        int numChannels = 0;
+        double sampleRate = 0.0;
+    };
+    
+    /** Returns the media's audio tracks, in container order. Empty until mediaReady. */
+    Array<AudioTrackInfo> getAudioTracks() const;
+    
+    /**
+     * Chooses the audio track that plays through the first output channels.
+     * Applies straight away while playing, otherwise from the next play().
+     * @return false if the media has no track with this id
+     */
+    bool setAudioTrack (int trackId);
+    
+    /**
+     * Returns the id of the track playing through the first output channels: the
+     * one chosen with setAudioTrack(), otherwise libVLC's own choice, or -1 if none.
+     */
+    int getAudioTrack() const;
+    
+    /**
+     * Decodes further audio tracks of the open file alongside the main one, e.g.
+     * the dialogue, music and effects stems of a master. Each stem is decoded by
+     * an audio-only libVLC player on the same instance, with its own ring, so no
+     * video is decoded twice. Stems follow this player's transport, seeks and
+     * play state, and are output after the main track's channels, each taking
+     * as many channels as the track has (see getAudioStemChannels()).
+     *
+     * Only media opened from a File can have stems. Stems are dropped by open(),
+     * close() and a switch to queued media. Pass an empty array to remove them.
+     * @return false if a track id isn't one of the media's audio tracks, or if a
+     *         stem couldn't be opened, in which case no stems are left
+     */
+    bool setAudioStems (const Array<int>& trackIds);
+    Array<int> getAudioStems() const;
+    
+    /**
+     * Returns the output channels a stem plays through, starting after the main
+     * track's. Empty until the stem's audio format is known.
+     */
+    Range<int> getAudioStemChannels (int stemIndex) const;
+    
+    //==============================================================================
+    /** Which video decoder libVLC should try first. */
+    enum class HardwareDecoding
+    {
+        Automatic,      // Whichever hardware decoder the platform offers, else software
+        Disabled,       // Always decode in software
+        VideoToolbox,   // macOS and iOS
+        D3D11VA,        // Windows 8 and later
+        DXVA2,          // Windows
+        VAAPI,          // Linux, Intel and AMD
+        VDPAU,          // Linux, older NVIDIA drivers
+        NVDEC           // NVIDIA's CUVID decoder
+    };
+    
+    /** How open() and preload() set up the video decoder. */
+    struct DecoderSettings
+    {
+        HardwareDecoding hardware = HardwareDecoding::Automatic;
+        
+        /** If false, media that only decodes in software is stopped with a mediaError. */
+        bool allowSoftwareFallback = true;
+        
+        /** Decoder threads for software decoding; 0 lets libVLC pick from the core count. */
+        int numThreads = 0;
+        
+        /**
+         * Decodes at 1/2, 1/4 or 1/8 size (1 to 3) where the codec can: MPEG-1/2/4,
+         * MJPEG and other DCT codecs decoded in software. H.264 and HEVC ignore it.
+         */
+        int lowResolution = 0;
+        
+        /** Let libVLC drop frames that are decoded too late, or skip decoding them, to keep up. */
+        bool dropLateFrames = false;
+        bool skipFrames = false;
+        
+        /** Skips frames no other frame depends on (usually B-frames), roughly halving the frame rate. */
+        bool skipNonReferenceFrames = false;
+    };
+    
+    /** The video decoder libVLC chose for the current media. */
+    struct DecoderInfo
+    {
+        String name;                // The hardware back end or decoder module, or "software"
+        bool isHardware = false;
+        bool isKnown = false;       // False until the media's video output has started
+    };
+    
+    /**
+     * Chooses the video decoder and its frame-dropping policy. Applies to the next
+     * call to open() or preload(). The defaults try hardware decoding and never
+     * drop frames, which keeps seeks frame-accurate. Must be called on the message thread.
+     */
+    void setDecoderSettings (const DecoderSettings& settings);
+    DecoderSettings getDecoderSettings() const;
+    
+    /**
+     * Reports the decoder libVLC actually chose once the video has started. libVLC
+     * has no API for this, so it's read from libVLC's log; when several players
+     * share a libVLC instance and open media at the same moment, a decoder may be
+     * attributed to the wrong one.
+     */
+    DecoderInfo getDecoderInfo() const;
+    
+    //==============================================================================
+    /**
+     * Prepares a file on a standby libVLC player while the current one keeps
+     * playing: the media is parsed and decoded up to its first frame, then held
+     * paused. A later open() of the same file becomes a switch to the standby
+     * player rather than a cold start. Only one file is held; preloading another
+     * replaces it. Must be called on the message thread.
+     *
+     * In NativeWindow output mode nothing is prerolled (the standby player has no
+     * window to draw into) and the file is just remembered for queueNext().
+     */
+    bool preload (const File& media, String* error = nullptr);
+    
+    /**
+     * Preloads a file and switches to it as soon as the current media ends,
+     * without a gap. Listeners get mediaReady for the new media rather than
+     * mediaFinished for the old one. Must be called on the message thread.
+     */
+    bool queueNext (const File& media, String* error = nullptr);
+    
+    /** Drops any preloaded or queued file. */
+    void cancelPreload();
+    
+    /** Returns the file held by preload() or queueNext(), if any. */
+    File getPreloadedFile() const;
+    
+    //==============================================================================
+    /**
+     * Turns the keyframe index on or off. When on, open() reads the file's keyframe
+     * table on a background thread (or loads it from its cache), and Fast seeks
+     * snap to the nearest keyframe once it's available. Applies to the next open().
+     * The cache is a hidden sidecar file next to the media, so indexing is off
+     * unless JUCE_LIBVLC_KEYFRAME_INDEX is set to 1.
+     */
+    void setKeyframeIndexingEnabled (bool shouldBuildIndex);
+    bool isKeyframeIndexingEnabled() const;
+    
+    /** Returns the current media's keyframe index, or nullptr until one is available. */
+    std::shared_ptr<const KeyframeIndex> getKeyframeIndex() const;
+    
+    /**
+     * Estimates how many seconds of video a Precise seek to a time has to decode
+     * before it can show the target frame, or -1 without a keyframe index.
+     */
+    double getSeekDecodeDistance (double timeInSeconds) const;
+    
+    /**
+     * Seeks are scheduled rather than issued one by one: only one is handed to
+     * libVLC at a time, and requests made while it lands are coalesced into the
+     * latest target. With scrub preview on (the default), a Precise seek that was
+     * coalesced during a burst such as a slider drag first jumps to the nearest
+     * keyframe, then refines to the exact frame once no newer target is waiting.
+     * Listener::seekCompleted is only called for the final target of a burst. A
+     * seek libVLC never reports back on is given up after a few seconds (longer
+     * if seeks have been slow) and reported through Listener::mediaError instead.
+     */
+    void setScrubPreviewEnabled (bool shouldPreview);
+    bool isScrubPreviewEnabled() const;
+    
+    /** Returns true while a seek is landing or waiting to be issued. */
+    bool isSeeking() const;
+    
+    //==============================================================================
+    /**
+     * Sets how far audio and video may stray from libVLC's schedule before being
+     * corrected. Audio that reaches the device later than libVLC intended is skipped
+     * forward, early audio is delayed with silence, and video frames are held until
+     * the audio clock reaches them. Smaller values sync more tightly but correct
+     * (audibly) more often. The default is 20 ms.
+     */
+    void setSyncTolerance (double seconds);
+    double getSyncTolerance() const;
+    
+    /** Interpolators that bring libVLC's output to the device rate, from cheapest to cleanest. */
+    enum class ResamplingQuality
+    {
+        Linear,
+        Lagrange,
+        WindowedSinc
+    };
+    
+    /**
+     * Sets how audio is converted from the media's sample rate to the device's.
+     * libVLC always delivers audio at the media's own rate; the conversion happens
+     * as the device pulls from the ring, which is also where small drift is trimmed
+     * out by reading very slightly faster or slower. The default is Lagrange.
+     */
+    void setResamplingQuality (ResamplingQuality quality);
+    ResamplingQuality getResamplingQuality() const;
+    
+    //==============================================================================
+    /**
+     * Slaves playback to an external transport such as a DAW playhead. Call it with
+     * the host's position, play state and speed whenever they're known; once per
+     * audio block is fine. It only publishes them through a sequence lock and
+     * returns, without locking, allocating or posting messages, so it's safe to call
+     * from the audio thread, as long as only one thread reports at a time. The
+     * message thread polls for the reports, so it can take up to a tenth of a second
+     * for the player to notice a transport it wasn't already following.
+     *
+     * Small drift is pulled in by nudging libVLC's playback rate. The player only
+     * re-seeks once it's further out than the seek threshold, and then aims ahead
+     * by the time its seeks have been taking to land. While the host is stopped the
+     * player parks on the host's position, so the frame is already decoded when the
+     * host starts.
+     */
+    void followTransport (double positionInSeconds, bool isPlaying, double rate = 1.0);
+    
+    /** Stops following the transport and returns to normal speed. Call from the message thread. */
+    void stopFollowingTransport();
+    
+    /** Returns true between followTransport() and stopFollowingTransport(). */
+    bool isFollowingTransport() const;
+    
+    /** Sets how far behind or ahead of the transport the player can drift before it re-seeks. The default is 250 ms. */
+    void setTransportSeekThreshold (double seconds);
+    double getTransportSeekThreshold() const;
+    
     void addListener (Listener* listener) override;
     void removeListener (Listener* listener) override;
 
@@ -83,74 +637,448 @@ public:
     void audioDeviceAboutToStart (AudioIODevice* device) override;
     void audioDeviceStopped() override;
     void audioDeviceError (const String& errorMessage) override;
+    
+    /**
+     * Prepares the audio output for a consumer other than an audio device, such as
+     * VLCAudioSource. Call it while nothing is pulling audio, as a device would
+     * before starting, then pull with audioDeviceIOCallbackWithContext().
+     */
+    void prepareAudioOutput (double sampleRate, int maximumBlockSize, int latencyInSamples = 0);
 
     //==============================================================================
-    // Timer implementation (for position updates)
+    // Timer implementation (for position updates while playing)
     void timerCallback() override;
 
 private:
+    friend class VLCMediaPlayerInternalsTests;  // Drives the ring and frame pool directly
+    
     //==============================================================================
+    /**
+     * Single-producer/single-consumer planar ring buffer. libVLC's audio thread
+     * is the only writer and the audio device callback the only reader. The
+     * capacity is a power of two, so head and tail are free-running counters
+     * and every transfer is at most two contiguous block copies.
+     */
     struct AudioBuffer
     {
         AudioBuffer (int channels, int samples);
         ~AudioBuffer();
         
+        /** Not thread safe: only call while neither side is running. */
         void resize (int channels, int samples);
         void clear();
         
+        /**
+         * Asks the consumer to discard everything written so far.
+         * Safe from any thread; the consumer honours it on its next read.
+         */
+        void flush();
+        
+        // Producer side
+        int getFreeSpace() const;
+        void prepareToWrite (int numWanted, int& start1, int& size1, int& start2, int& size2) const;
+        void finishedWrite (int numWritten);
+        int write (const float* const* source, int numSourceChannels, int numToWrite);
+        
+        // Consumer side
+        int getNumReady() const;
+        int read (float* const* dest, int numDestChannels, int numToRead);
+        int peek (float* const* dest, int numDestChannels, int numToPeek) const;    // Copies without consuming
+        
         float** data = nullptr;
         int numChannels = 0;
-        int numSamples = 0;
-        std::atomic<int> writePosition { 0 };
-        std::atomic<int> readPosition { 0 };
-        std::atomic<int> availableSamples { 0 };
+        int numSamples = 0;                     // Capacity, always a power of two
+        int mask = 0;
+        std::atomic<uint64_t> head { 0 };       // Written by the producer
+        std::atomic<uint64_t> tail { 0 };       // Written by the consumer
+        std::atomic<uint64_t> flushPosition { 0 };
+        std::atomic<uint32_t> flushGeneration { 0 };
+        uint32_t consumerGeneration = 0;        // Owned by the consumer
+    };
+
+    //==============================================================================
+    /**
+     * A block of samples in the ring, where it sits on the media timeline and the
+     * time it's heard at. Published by one thread and read by others through a
+     * sequence lock, so readers always see the fields of a single block.
+     */
+    struct TimelinePoint
+    {
+        struct Values
+        {
+            int64_t position = -1;              // Ring position of the block's first sample
+            int64_t sample = 0;                 // Media sample of that position
+            int64_t timeNs = 0;                 // When it's heard
+            int64_t span = 0;                   // Block length in samples
+            uint32_t epoch = 0;                 // Ring flush generation it was written in
+        };
+        
+        void publish (const Values& values) noexcept;
+        bool read (Values& values) const noexcept;
+        
+        std::atomic<uint32_t> sequence { 0 };
+        std::atomic<int64_t> position { -1 };
+        std::atomic<int64_t> sample { 0 };
+        std::atomic<int64_t> timeNs { 0 };
+        std::atomic<int64_t> span { 0 };
+        std::atomic<uint32_t> epoch { 0 };
+    };
+    
+    /** The last state an external transport reported, published the same way. */
+    struct TransportReport
+    {
+        struct Values
+        {
+            double position = 0.0;
+            double rate = 1.0;
+            int64_t reportedAtNs = 0;           // Host time it was reported at
+            bool isPlaying = false;
+        };
+        
+        void publish (const Values& values) noexcept;
+        bool read (Values& values) const noexcept;
+        
+        std::atomic<uint32_t> sequence { 0 };
+        std::atomic<double> position { 0.0 };
+        std::atomic<double> rate { 1.0 };
+        std::atomic<int64_t> reportedAtNs { 0 };
+        std::atomic<bool> isPlaying { false };
+    };
+    
+    //==============================================================================
+    /**
+     * Lock-free pool of frame slots shared between libVLC's vmem callbacks and
+     * the thread reading frames. libVLC decodes straight into a free slot, the
+     * display callback publishes it with an atomic index swap, and the reader
+     * picks up the latest published slot without taking a lock or copying.
+     */
+    struct VideoFramePool
+    {
+        static constexpr int numSlots = 6;
+        static constexpr int numCoreSlots = 3;  // Sized up front; the rest only come into use while VideoFrames are held
+        
+        enum SlotState
+        {
+            slotFree,
+            slotWriting,
+            slotReady,
+            slotReading
+        };
+        
+        static constexpr int maxPlanes = 3;
+        
+        struct Slot
+        {
+            juce::Image image;                  // RGB32 frames decode straight into this
+            HeapBlock<uint8_t> planarData;      // YUV frames decode into this
+            VideoPixelFormat format = VideoPixelFormat::RGB32;
+            int width = 0;
+            int height = 0;
+            int numPlanes = 0;
+            uint8_t* planes[maxPlanes] {};
+            int pitches[maxPlanes] {};
+            int lines[maxPlanes] {};
+            uint64_t sequenceNumber = 0;
+            double timeInSeconds = -1.0;        // Media time, set for frames handed to frame listeners
+            std::atomic<int64_t> presentationPosition { -1 };  // Ring position it belongs with, -1 if unknown
+            std::atomic<int> state { slotFree };
+            std::atomic<int> numHolders { 0 };  // VideoFrame handles; a held slot is never written
+        };
+        
+        /** Works out the plane pitches and line counts we promise libVLC for a format. */
+        static int getPlaneLayout (VideoPixelFormat format, int width, int height, int* pitches, int* lines);
+        
+        void setFormat (int width, int height, VideoPixelFormat format);
+        void reset();
+        void releaseMemory();                   // Frees the slots nobody holds or reads; same rules as reset()
+        bool isAnyFrameHeld() const;
+        
+        // Called from libVLC's decoder/vout threads
+        void preallocate();                     // Sizes idle slots for the current format
+        Slot* acquireForWriting();
+        void publish (Slot* slot);
+        
+        // Called from the single consumer thread (usually the message thread).
+        // The latest frame is held back while its presentation position is in (showUpTo, holdUpTo].
+        Slot* acquireForReading (int64_t showUpTo = std::numeric_limits<int64_t>::max(),
+                                 int64_t holdUpTo = std::numeric_limits<int64_t>::max());
+        
+        Slot slots[numSlots];
+        Slot overflowSlot;                      // Discard target if every slot is busy
+        std::atomic<int> latestSlot { -1 };
+        std::atomic<int> formatWidth { 0 };
+        std::atomic<int> formatHeight { 0 };
+        std::atomic<int> formatPixelFormat { static_cast<int>(VideoPixelFormat::RGB32) };
+        std::atomic<uint64_t> publishedFrames { 0 };
+        std::atomic<uint32_t> resetCount { 0 };
+        int readingSlot = -1;                   // Owned by the consumer thread
+        uint32_t readerResetCount = 0;          // Owned by the consumer thread
+        
+    private:
+        Slot* prepareForWriting (Slot& slot);
+    };
+    
+    //==============================================================================
+    /**
+     * Staging between videoDisplayCallback and the frame cache. The display callback
+     * copies a frame into a free buffer (never allocating); FrameCacheWriter takes it
+     * from there, and grows the buffers when frames stop fitting.
+     */
+    struct FrameIntake
+    {
+        static constexpr int numBuffers = 4;
+        
+        enum BufferState
+        {
+            bufferFree,
+            bufferBusy,         // Claimed by whichever side changed it from free or filled
+            bufferFilled
+        };
+        
+        struct Buffer
+        {
+            HeapBlock<uint8_t> pixels;          // Tightly packed RGB32
+            size_t capacity = 0;
+            int width = 0;
+            int height = 0;
+            int64_t presentationPosition = -1;
+            uint64 mediaId = 0;
+            std::atomic<int> state { bufferFree };
+        };
+        
+        /** Copies a displayed frame into a free buffer. Called from libVLC's vout thread. */
+        bool offer (const VideoFramePool::Slot& slot, uint64 mediaId);
+        
+        Buffer buffers[numBuffers];
+        std::atomic<size_t> requiredCapacity { 0 };
+        WaitableEvent frameOffered;
+    };
+    
+    //==============================================================================
+    /**
+     * One libVLC media player and the frame pool it decodes into. libVLC is given
+     * the deck, not the VLCMediaPlayer, as the callbacks' opaque pointer, so a
+     * standby deck can preroll the next media without its audio or frames
+     * reaching the live output. Decks are recycled rather than re-created.
+     */
+    struct Deck : public VLCInstanceManager::Instance::DecoderListener
+    {
+        explicit Deck (VLCMediaPlayer& ownerToUse) : owner (ownerToUse) {}
+        
+        void videoDecoderOpened (const String& name, bool isHardware) override;
+        void resetDecoderInfo (bool detectNextDecoder);
+        bool finishDecoderDetection();
+        
+        VLCMediaPlayer& owner;
+        libvlc_media_player_t* player = nullptr;
+        VideoFramePool framePool;
+        std::atomic<bool> isLive { false };
+        std::atomic<bool> hasPrerolled { false };   // First frame decoded while on standby
+        std::atomic<bool> hasAudioOutput { false };
+        std::atomic<int> audioChannels { 2 };
+        std::atomic<double> audioSampleRate { 0.0 };     // libVLC's output rate for this deck's media
+        OpenOptions openOptions;                    // What this deck's media was opened with; message thread only
+        
+        // The decoder heard about since this deck's media was opened
+        std::atomic<bool> isAwaitingDecoder { false };
+        DecoderInfo decoderInfo;                    // Guarded by decoderInfoLock
+        mutable SpinLock decoderInfoLock;
+        
+        JUCE_DECLARE_NON_COPYABLE (Deck)
     };
 
     //==============================================================================
-    // libVLC instance and player
+    // libVLC instance and player; vlcInstance is owned by sharedInstance
+    VLCInstanceManager::Instance::Ptr sharedInstance;
     libvlc_instance_t* vlcInstance = nullptr;
-    libvlc_media_player_t* mediaPlayer = nullptr;
+    libvlc_media_player_t* mediaPlayer = nullptr;   // Always liveDeck->player
     libvlc_media_t* currentMedia = nullptr;
     
+    // Byte sources for media opened from memory or streams, deleted with their libvlc_media_t
+    class MediaSource;
+    class MemorySource;
+    class StreamSource;
+    
+    // Players for the current and the preloaded media
+    std::unique_ptr<Deck> liveDeck;
+    std::unique_ptr<Deck> standbyDeck;
+    libvlc_media_t* standbyMedia = nullptr;
+    File preloadedFile;
+    bool switchAtEnd = false;
+    bool resumeAfterPreroll = false;
+    
     // Audio system integration
     AudioDeviceManager* audioDeviceManager = nullptr;
     std::unique_ptr<AudioBuffer> audioRingBuffer;
-    std::atomic<double> currentSampleRate { 44100.0 };
-    std::atomic<int> audioChannels { 2 };
+    SpinLock audioRingBufferLock;               // Held briefly; the audio thread only ever tries it
+    std::atomic<double> currentSampleRate { 44100.0 };   // The device's rate
+    std::atomic<double> sourceSampleRate { 44100.0 };    // The rate of the samples in the ring
     std::atomic<int64_t> totalAudioSamples { -1 };
-    std::atomic<int64_t> currentAudioSample { 0 };
+    std::atomic<int64_t> currentAudioSample { 0 };      // libVLC's clock, used when no audio is being delivered
+    
+    // Master clock: the samples actually delivered to the device, and libVLC's schedule for them
+    TimelinePoint deliveredClock;                   // Last block handed to the device (host time)
+    TimelinePoint scheduledClock;                   // Last block libVLC wrote (libvlc_clock time it's due)
+    uint64_t anchorPosition = 0;                    // Ring position the media timeline restarts at...
+    int64_t anchorSample = 0;                       // ...the media sample found there...
+    uint32_t anchorEpoch = 0;                       // ...all three guarded by audioRingBufferLock
+    std::atomic<int> outputLatencySamples { 0 };
+    std::atomic<int> deviceBlockSize { 512 };
+    std::atomic<int> latencyProfile { static_cast<int>(LatencyProfile::Robust) };
+    DecoderSettings decoderSettings;                // Message thread only
+    OpenOptions openOptions;                        // Message thread only
+    std::atomic<int> numAudioUnderruns { 0 };
+    
+    // Counters behind getStats(), updated lock-free by the threads being measured
+    struct StatsCounters
+    {
+        std::atomic<int64> framesDecoded { 0 }, framesDisplayed { 0 }, framesLate { 0 };
+        std::atomic<int64> frameCopyTicks { 0 }, maxFrameCopyTicks { 0 }, numFrameCopies { 0 };
+        std::atomic<int64> audioCallbackTicks { 0 }, maxAudioCallbackTicks { 0 }, numAudioCallbacks { 0 };
+        std::atomic<int64> seekLatencyTicks { 0 }, maxSeekLatencyTicks { 0 }, lastSeekLatencyTicks { 0 };
+        std::atomic<int> numSeeks { 0 };
+        std::atomic<int64> seekRequestedAt { 0 };       // High-resolution ticks; 0 when no seek is being timed
+        std::atomic<bool> isAwaitingSeekFrame { false };
+        std::atomic<double> avOffsetSeconds { 0.0 };
+        
+        void reset() noexcept;
+    };
+    
+    mutable StatsCounters stats;
+    
+    // Audio track choice and the audio-only players that decode further tracks
+    Array<AudioTrackInfo> audioTracks;              // Message thread only
+    int selectedAudioTrack = -1;                    // Message thread only
+    int stemTrackId = -1;                           // Set on a stem, which decodes only this track
+    File currentFile;                               // Message thread only, for opening stems
+    OwnedArray<VLCMediaPlayer> audioStems;          // Swapped under audioStemsLock, read by the audio thread
+    SpinLock audioStemsLock;
+    std::atomic<int> numRingChannels { 0 };
+    std::atomic<double> syncToleranceSeconds { 0.020 };
+    std::atomic<double> playbackRate { 1.0 };       // Media samples per delivered sample
+    double deliveredSample = 0.0;                   // Owned by the audio thread
+    uint32_t deliveredAnchorEpoch = 0;              // Owned by the audio thread
+    
+    // Rate conversion from the ring to the device, owned by the audio thread
+    // (resized in audioDeviceAboutToStart, while no callbacks run)
+    std::atomic<int> resamplingQuality { static_cast<int>(ResamplingQuality::Lagrange) };
+    int activeResamplingQuality = -1;
+    juce::AudioBuffer<float> resampleInput;         // Plus one spare channel, for outputs nobody listens to
+    LinearInterpolator linearResamplers[AudioDeinterleaver::maxChannels];
+    LagrangeInterpolator lagrangeResamplers[AudioDeinterleaver::maxChannels];
+    WindowedSincInterpolator sincResamplers[AudioDeinterleaver::maxChannels];
     
     // Video system integration
+    class NativeVideoSurface;
     Component::SafePointer<Component> videoComponent;
+    std::unique_ptr<NativeVideoSurface> nativeVideoSurface;
+    VideoOutputMode videoOutputMode { JUCE_LIBVLC_USE_NATIVE_WINDOW ? VideoOutputMode::NativeWindow
+                                                                    : VideoOutputMode::MemoryCallbacks };
     std::atomic<int> videoWidth { 0 };
     std::atomic<int> videoHeight { 0 };
+    
+    // Limits on the size libVLC scales its output to (0 for none)
+    std::atomic<int> maxOutputWidth { 0 };
+    std::atomic<int> maxOutputHeight { 0 };
+    std::atomic<int> componentOutputWidth { 0 };
+    std::atomic<int> componentOutputHeight { 0 };
+    std::atomic<bool> outputFollowsComponent { false };
+    bool outputRenegotiationPending = false;        // Message thread only
+    uint32 renegotiateOutputAt = 0;                 // Message thread only
     std::atomic<bool> hasVideoStream { false };
     std::atomic<bool> hasAudioStream { false };
+    std::atomic<double> videoFrameRate { 0.0 };
     
-    // Video frame capture
-    juce::Image currentVideoFrame;
-    std::mutex videoFrameMutex;
-    std::unique_ptr<uint8_t[]> videoFrameBuffer;
-    size_t videoFrameBufferSize { 0 };
+    // Decoded-frame cache, filled by the writer from frames the live deck displays
+    class FrameCacheWriter;
+    FrameIntake frameIntake;
+    std::unique_ptr<FrameCache> frameCache;         // Created and destroyed on the message thread
+    std::unique_ptr<FrameCacheWriter> frameCacheWriter;
+    FrameCacheSettings frameCacheSettings;          // Message thread only
+    std::atomic<bool> frameCacheEnabled { false };
+    std::atomic<int> frameCacheDownscale { 1 };
+    std::atomic<uint64> frameCacheMediaId { 0 };    // Changes with each media, so old frames never match
+    std::atomic<double> requestedSeekTime { -1.0 };
+    
+    // Video frame capture; points at the live deck's pool
+    std::atomic<VideoFramePool*> videoFramePool { nullptr };
+    std::atomic<int> requestedPixelFormat { static_cast<int>(VideoPixelFormat::RGB32) };
     
     // Playback state
     std::atomic<bool> isCurrentlyPlaying { false };
+    std::atomic<int> pendingParseStatus { 0 };      // libvlc_media_parsed_status_t, 0 when none
+    std::atomic<bool> seekInProgress { false };
+    std::atomic<bool> seekHasFlushed { false };     // libVLC has flushed the audio output for the seek in flight
+    std::atomic<int64_t> lastSeekLandedSample { 0 };
+    
+    // Seek scheduling: one seek in flight, later requests coalesce into the next one
+    struct SeekRequest
+    {
+        double time = 0.0;
+        SeekMode mode = SeekMode::Precise;
+        int64_t generation = 0;
+    };
+    
+    SeekRequest pendingSeek;                        // Guarded by stateMutex
+    SeekRequest inFlightSeek;                       // Guarded by stateMutex
+    bool hasPendingSeek = false;                    // Guarded by stateMutex
+    bool isSeekInFlight = false;                    // Guarded by stateMutex
+    bool inFlightSeekIsPreview = false;             // Guarded by stateMutex
+    uint32 seekIssuedAt = 0;                        // Guarded by stateMutex
+    std::atomic<int64_t> issuedSeekTargetMs { 0 };
+    std::atomic<int64_t> issuedSeekGeneration { 0 };
+    std::atomic<int64_t> landedSeekGeneration { 0 };
+    std::atomic<bool> scrubPreviewEnabled { true };
+    
+    // Keyframe index for the current media, built in the background
+    class KeyframeIndexBuilder;
+    std::unique_ptr<KeyframeIndexBuilder> keyframeIndexBuilder;
+    std::shared_ptr<const KeyframeIndex> keyframeIndex;
+    SpinLock keyframeIndexLock;
+    std::atomic<bool> keyframeIndexingEnabled { JUCE_LIBVLC_KEYFRAME_INDEX != 0 };
+    
+    // External transport, reported from any thread by followTransport()
+    std::atomic<bool> followingTransport { false };
+    TransportReport transportReport;
+    std::atomic<double> transportSeekThreshold { 0.25 };
+    double transportSeekLatency = 0.1;              // Smoothed time seeks take to land (message thread)
+    double parkedTransportPosition = -1.0;          // Where a stopped transport was last followed to (message thread)
+    bool wasTransportPlaying = false;               // Message thread only
+    
+    // Events from libVLC's threads, coalesced into bits and drained on the message thread
+    enum PendingEvent : uint32_t
+    {
+        pendingMediaParsed      = 1 << 0,
+        pendingPlaybackStarted  = 1 << 1,
+        pendingPlaybackStopped  = 1 << 2,
+        pendingEndReached       = 1 << 3,
+        pendingPlaybackError    = 1 << 4,
+        pendingSeekCompleted    = 1 << 5,
+        pendingStandbyPrerolled = 1 << 6,
+        pendingVideoSizeChanged = 1 << 7,
+        pendingDecoderChosen    = 1 << 8,
+        pendingSeekScheduled    = 1 << 9
+    };
+    
+    std::atomic<uint32_t> pendingEvents { 0 };
+    std::atomic<int> parseTimeoutMs { JUCE_LIBVLC_PARSE_TIMEOUT_MS };
     std::atomic<double> mediaDuration { -1.0 };
     std::atomic<int64_t> seekGeneration { 0 };
     
     // Thread safety
     mutable std::mutex stateMutex;
     ListenerList<Listener> listeners;
+    ListenerList<FrameListener, Array<FrameListener*, CriticalSection>> frameListeners;   // Called from libVLC's vout thread
     
     //==============================================================================
     // libVLC callback functions
-    static void* audioLockCallback (void* data, void** pcm_buffer, size_t size);
-    static void audioUnlockCallback (void* data, void* pcm_buffer, size_t size);
-    static void audioPlayCallback (void* data, void* pcm_buffer, size_t size);
+    static void audioPlayCallback (void* data, const void* samples, unsigned count, int64_t pts);
     static void audioPauseCallback (void* data, int64_t pts);
     static void audioResumeCallback (void* data, int64_t pts);
     static void audioFlushCallback (void* data, int64_t pts);
     static void audioDrainCallback (void* data);
+    static int audioSetupCallback (void** data, char* format, unsigned* rate, unsigned* channels);
+    static void audioCleanupCallback (void* data);
     
     static void* videoLockCallback (void* data, void** planes);
     static void videoUnlockCallback (void* data, void* picture, void* const* planes);
@@ -159,29 +1087,141 @@ private:
                                        unsigned* height, unsigned* pitches, unsigned* lines);
     static void videoCleanupCallback (void* data);
     
-    // Event callbacks removed for compatibility
+    static void vlcEventCallback (const libvlc_event_t* event, void* data);
     
     //==============================================================================
     // Internal methods
-    void initializeVLC();
+    void initializeVLC (const StringArray& vlcArguments);
     void shutdownVLC();
-    void setupAudioCallbacks();
-    void setupVideoCallbacks();
+    std::unique_ptr<Deck> createDeck();
+    void releaseDeck (Deck& deck);
+    static bool waitForFrameHandles (Deck& deck, int timeoutMs);
+    void releaseCurrentMedia();
+    bool openSource (std::unique_ptr<MediaSource> source, String* error);
+    bool startMedia (libvlc_media_t* media, int parseFlags, String* error);
+    void promoteStandbyDeck (bool startPlaying);
+    void switchToQueuedMedia();
+    void startKeyframeIndexing (const File& media);
+    void stopKeyframeIndexing();
+    void issuePendingSeek (bool isCoalesced);
+    void handleSeekLanded();
+    void checkSeekTimeout();
+    void updateTimerState();
+    void updateTransportFollower();
+    void applyPlaybackRate (double rate);
+    void setupAudioCallbacks (Deck& deck);
+    void setupVideoCallbacks (Deck& deck);
     void setupEventHandling();
+    void removeEventHandling();
+    void postEvent (PendingEvent event);
     void updateMediaInfo();
-    void notifyListeners (std::function<void(Listener*)> callback);
+    void handleMediaParsed (int parsedStatus);
+    void handleAsyncUpdate() override;
+    template <typename Callback>
+    void notifyListeners (Callback&& callback)
+    {
+        // Taken by reference, so no std::function has to be built for each notification
+        listeners.call ([&callback] (Listener& l) { callback (&l); });
+    }
     
     // Audio processing
-    void processAudioData (void* buffer, size_t size);
+    void renderAudio (float* const* outputChannelData, int numOutputChannels, int numSamples, int64_t presentationTimeNs);
+    int resampleFromRing (AudioBuffer& ring, float* const* outputChannelData, int numOutputChannels,
+                          int startSample, int numSamples, double speedRatio);
+    void resetResamplers();
+    void setClockAnchor (int64_t sample, bool flushRing);
+    int64_t getPresentationLimit (int64_t& holdUpTo) const;
+    void processAudioData (const void* buffer, size_t size);
     int getAvailableAudioSamples() const;
+    int getRingCapacity() const;
+    void applyLatencyProfile (libvlc_media_t* media) const;
+    void applyDecoderSettings (libvlc_media_t* media) const;
+    void applyOpenOptions (libvlc_media_t* media) const;
+    void handleDecoderChosen();
     void updateAudioPosition();
     
     // Video processing
     void setupVideoOutput();
+    void attachNativeWindow (void* nativeHandle);
     void updateVideoSize (int width, int height);
-    void updateVideoFrameFromBuffer();
+    Rectangle<int> getOutputSizeFor (int sourceWidth, int sourceHeight) const;
+    double getMediaTimeForPresentation (int64_t presentationPosition) const;
+    void updateFrameStats (int64_t presentationPosition);
+    void updateAudioStems();
+    void renderAudioStems (float* const* outputChannelData, int numOutputChannels, int numSamples, int64_t presentationTimeNs);
+    void removeAudioStems();
+    int64 getFrameCacheTime (double timeInSeconds) const;
+    void resetFrameCache();
+    void updateComponentOutputSize();
+    void requestOutputRenegotiation();
+    void renegotiateVideoOutput();
+    void componentMovedOrResized (Component& component, bool wasMoved, bool wasResized) override;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VLCMediaPlayer)
 };
 
+//==============================================================================
+/**
+ * A handle to one decoded frame, pointing straight into the player's frame pool:
+ * plane pointers, pitches and pixel layout are exactly as libVLC wrote them.
+ * Copying a handle only bumps a reference count, so any number of consumers (an
+ * encoder, a network sender, the UI) can hold the same frame without copying its
+ * pixels. The buffer goes back to libVLC once the last handle is released.
+ *
+ * Handles are cheap to copy and safe to pass between threads. A held frame
+ * survives close() and open(), but its memory belongs to the player: destroying
+ * the player blocks until every handle has been released, for up to two seconds.
+ * Past that it asserts and leaks the pool rather than free it under the handles.
+ */
+class VLCMediaPlayer::VideoFrame
+{
+public:
+    /** Creates a handle to no frame. */
+    VideoFrame() noexcept = default;
+    
+    VideoFrame (const VideoFrame& other) noexcept;
+    VideoFrame (VideoFrame&& other) noexcept;
+    VideoFrame& operator= (const VideoFrame& other) noexcept;
+    VideoFrame& operator= (VideoFrame&& other) noexcept;
+    ~VideoFrame();
+    
+    /** Releases this handle's hold on the frame. */
+    void reset() noexcept;
+    
+    bool isValid() const noexcept                               { return slot != nullptr; }
+    
+    VideoPixelFormat getFormat() const noexcept;
+    int getWidth() const noexcept;
+    int getHeight() const noexcept;
+    int getNumPlanes() const noexcept;
+    
+    /** Returns a plane's pixels, or nullptr past the last plane. */
+    const uint8_t* getPlane (int plane) const noexcept;
+    
+    /** Returns the bytes per row of a plane. */
+    int getPitch (int plane) const noexcept;
+    
+    /** Returns the rows allocated for a plane. */
+    int getNumLines (int plane) const noexcept;
+    
+    /** Increases with every frame the player publishes. */
+    uint64_t getSequenceNumber() const noexcept;
+    
+    /** Returns the media time the frame was presented at, in seconds. */
+    double getTime() const noexcept;
+    
+    /**
+     * Returns an RGB32 frame as an image sharing the frame's pixels, or an invalid
+     * image for YUV layouts. The pixels only stay intact while a handle is held.
+     */
+    Image getImage() const;
+    
+private:
+    friend class VLCMediaPlayer;
+    friend class VLCMediaPlayerInternalsTests;
+    explicit VideoFrame (VideoFramePool::Slot& slotToHold) noexcept;
+    
+    VideoFramePool::Slot* slot = nullptr;
+};
+
 } // namespace juce
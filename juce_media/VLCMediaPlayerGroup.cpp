@@ -0,0 +1,249 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#include "VLCMediaPlayerGroup.h"
+
+namespace juce
+{
+
+//==============================================================================
+VLCMediaPlayerGroup::VLCMediaPlayerGroup (const StringArray& vlcArguments)
+    : arguments (vlcArguments)
+{
+}
+
+VLCMediaPlayerGroup::~VLCMediaPlayerGroup()
+{
+    clear();
+}
+
+VLCMediaPlayer& VLCMediaPlayerGroup::addMember()
+{
+    // Players made with the same arguments share the libVLC instance
+    auto* member = members.add (new VLCMediaPlayer (arguments));
+    member->addListener (this);
+
+    priorities.add (Priority::Full);
+    isSeekLanding.add (false);
+
+    if (members.size() == 1)
+        setLeader (0);
+
+    updateTimer();
+    return *member;
+}
+
+void VLCMediaPlayerGroup::clear()
+{
+    stopTimer();
+
+    for (auto* member : members)
+    {
+        member->removeListener (this);
+        member->setAudioDevice (nullptr);
+    }
+
+    members.clear();
+    priorities.clear();
+    isSeekLanding.clear();
+    leaderIndex = 0;
+    numSeeksLanding = 0;
+}
+
+//==============================================================================
+void VLCMediaPlayerGroup::setLeader (int index)
+{
+    if (! isPositiveAndBelow (index, members.size()))
+        return;
+
+    if (auto* previous = members[leaderIndex])
+        previous->setAudioDevice (nullptr);
+
+    leaderIndex = index;
+
+    // The leader runs on its own clock; everyone else follows it from the next tick
+    auto* leader = members[leaderIndex];
+    leader->stopFollowingTransport();
+    leader->setAudioDevice (audioDeviceManager);
+
+    updateTimer();
+}
+
+void VLCMediaPlayerGroup::setAudioDevice (AudioDeviceManager* deviceManager)
+{
+    audioDeviceManager = deviceManager;
+
+    if (auto* leader = members[leaderIndex])
+        leader->setAudioDevice (deviceManager);
+}
+
+//==============================================================================
+void VLCMediaPlayerGroup::play()
+{
+    // Followers start when they hear the leader has
+    if (auto* leader = members[leaderIndex])
+        leader->play();
+
+    timerCallback();
+}
+
+void VLCMediaPlayerGroup::pause()
+{
+    if (auto* leader = members[leaderIndex])
+        leader->pause();
+
+    timerCallback();
+}
+
+void VLCMediaPlayerGroup::stop()
+{
+    for (auto* member : members)
+    {
+        member->stopFollowingTransport();
+        member->stop();
+    }
+
+    numSeeksLanding = 0;
+    isSeekLanding.fill (false);
+}
+
+bool VLCMediaPlayerGroup::isPlaying() const
+{
+    auto* leader = members[leaderIndex];
+    return leader != nullptr && leader->isPlaying();
+}
+
+double VLCMediaPlayerGroup::getCurrentTime() const
+{
+    auto* leader = members[leaderIndex];
+    return leader != nullptr ? leader->getCurrentTime() : 0.0;
+}
+
+void VLCMediaPlayerGroup::seekToTime (double timeInSeconds, ISeekableMedia::SeekMode mode)
+{
+    seekTarget = timeInSeconds;
+    numSeeksLanding = 0;
+
+    // Every member's seek is in flight at once, each on its own libVLC input thread
+    for (int i = 0; i < members.size(); ++i)
+    {
+        auto* member = members.getUnchecked (i);
+
+        if (i != leaderIndex)
+            member->stopFollowingTransport();
+
+        bool isLanding = member->seekToTime (timeInSeconds, mode);
+        isSeekLanding.set (i, isLanding);
+
+        if (isLanding)
+            ++numSeeksLanding;
+    }
+
+    if (numSeeksLanding == 0 && onSeekCompleted != nullptr)
+        onSeekCompleted (seekTarget);
+}
+
+//==============================================================================
+void VLCMediaPlayerGroup::setPriority (int index, Priority priority)
+{
+    if (! isPositiveAndBelow (index, members.size()))
+        return;
+
+    priorities.set (index, priority);
+    applyPriority (index);
+}
+
+VLCMediaPlayerGroup::Priority VLCMediaPlayerGroup::getPriority (int index) const
+{
+    return priorities[index];
+}
+
+void VLCMediaPlayerGroup::applyPriority (int index)
+{
+    auto* member = members[index];
+    auto settings = member->getDecoderSettings();
+
+    switch (priorities[index])
+    {
+        case Priority::Reduced:
+            member->setMaxVideoOutputSize (960, 540);
+            settings.dropLateFrames = true;
+            settings.skipNonReferenceFrames = false;
+            break;
+
+        case Priority::Minimal:
+            member->setMaxVideoOutputSize (320, 180);
+            settings.dropLateFrames = true;
+            settings.skipNonReferenceFrames = true;
+            break;
+
+        case Priority::Full:
+        default:
+            member->setMaxVideoOutputSize (0, 0);
+            settings.dropLateFrames = false;
+            settings.skipNonReferenceFrames = false;
+            break;
+    }
+
+    member->setDecoderSettings (settings);
+}
+
+void VLCMediaPlayerGroup::getCurrentFrames (Array<Image>& frames) const
+{
+    frames.clearQuick();
+
+    for (auto* member : members)
+        frames.add (member->getCurrentVideoFrame());
+}
+
+//==============================================================================
+void VLCMediaPlayerGroup::timerCallback()
+{
+    auto* leader = members[leaderIndex];
+
+    // Followers are left alone until a group seek has landed everywhere
+    if (leader == nullptr || numSeeksLanding > 0)
+        return;
+
+    auto position = leader->getCurrentTime();
+    auto playing = leader->isPlaying();
+
+    for (int i = 0; i < members.size(); ++i)
+        if (i != leaderIndex)
+            members.getUnchecked (i)->followTransport (position, playing);
+}
+
+void VLCMediaPlayerGroup::seekCompleted (ISeekableMedia* media, int64_t)
+{
+    for (int i = 0; i < members.size(); ++i)
+    {
+        if (members.getUnchecked (i) == media && isSeekLanding[i])
+        {
+            isSeekLanding.set (i, false);
+
+            if (--numSeeksLanding == 0)
+            {
+                timerCallback();
+
+                if (onSeekCompleted != nullptr)
+                    onSeekCompleted (seekTarget);
+            }
+        }
+    }
+}
+
+void VLCMediaPlayerGroup::updateTimer()
+{
+    // Followers extrapolate between reports, so this needn't be fast
+    if (members.size() > 1)
+        startTimerHz (30);
+    else
+        stopTimer();
+}
+
+} // namespace juce
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "VLCMediaPlayer.h"
+#include <functional>
+
+namespace juce
+{
+
+/**
+ * Plays several media files in sync, e.g. the camera angles of a multicam shoot.
+ * All members share one libVLC instance. One member, the leader, plays its audio
+ * through the audio device and is the group's clock; every other member follows
+ * it with VLCMediaPlayer::followTransport(), so drift is pulled in by nudging the
+ * followers' playback rate rather than by re-seeking.
+ *
+ * Seeks are issued to all members at once, so they land in parallel, and the
+ * group reports when the last one has landed. Members that are off screen or
+ * shown small can be given a lower priority, which decodes fewer pixels and
+ * fewer frames.
+ *
+ * Must be used on the message thread.
+ */
+class VLCMediaPlayerGroup : private Timer,
+                            private ISeekableMedia::Listener
+{
+public:
+    //==============================================================================
+    /** Creates an empty group whose members use a libVLC argument set. */
+    explicit VLCMediaPlayerGroup (const StringArray& vlcArguments = VLCInstanceManager::getDefaultArguments());
+    ~VLCMediaPlayerGroup() override;
+
+    /** Adds a player to the group and returns it. The first one added leads. */
+    VLCMediaPlayer& addMember();
+
+    /** Returns the number of members. */
+    int getNumMembers() const noexcept                          { return members.size(); }
+
+    /** Returns a member, or nullptr if the index is out of range. */
+    VLCMediaPlayer* getMember (int index) const noexcept       { return members[index]; }
+
+    /** Removes every member. */
+    void clear();
+
+    //==============================================================================
+    /** Chooses which member's audio is heard and drives the other members. */
+    void setLeader (int index);
+    int getLeader() const noexcept                              { return leaderIndex; }
+
+    /** Sets the device the leader plays through. */
+    void setAudioDevice (AudioDeviceManager* deviceManager);
+
+    //==============================================================================
+    void play();
+    void pause();
+    void stop();
+    bool isPlaying() const;
+
+    /** Returns the leader's position, in seconds. */
+    double getCurrentTime() const;
+
+    /**
+     * Seeks every member to a time at once. Followers stop following the leader
+     * until every member has landed, then onSeekCompleted is called.
+     */
+    void seekToTime (double timeInSeconds, ISeekableMedia::SeekMode mode = ISeekableMedia::SeekMode::Precise);
+
+    /** Returns true while any member's group seek hasn't landed. */
+    bool isSeeking() const noexcept                             { return numSeeksLanding > 0; }
+
+    /** Called on the message thread once every member has landed after seekToTime(). */
+    std::function<void (double timeInSeconds)> onSeekCompleted;
+
+    //==============================================================================
+    /** How much decoding effort a member gets. */
+    enum class Priority
+    {
+        Full,       // Every frame at full resolution
+        Reduced,    // Output at most 960x540, late frames dropped
+        Minimal     // Output at most 320x180, non-reference frames skipped, for small or hidden tiles
+    };
+
+    /**
+     * Sets a member's priority. The output size changes straight away (libVLC
+     * renegotiates it); the frame skipping applies when the member next opens media.
+     */
+    void setPriority (int index, Priority priority);
+    Priority getPriority (int index) const;
+
+    /**
+     * Fills frames with every member's current frame, collected in one pass so a
+     * video wall paints all tiles from the same moment. Replaces the members'
+     * getCurrentVideoFrame(), which must then not be called elsewhere.
+     */
+    void getCurrentFrames (Array<Image>& frames) const;
+
+private:
+    //==============================================================================
+    void timerCallback() override;
+    void seekCompleted (ISeekableMedia* media, int64_t sample) override;
+    void applyPriority (int index);
+    void updateTimer();
+
+    StringArray arguments;
+    OwnedArray<VLCMediaPlayer> members;
+    Array<Priority> priorities;
+    Array<bool> isSeekLanding;
+    int leaderIndex = 0;
+    int numSeeksLanding = 0;
+    double seekTarget = 0.0;
+    AudioDeviceManager* audioDeviceManager = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VLCMediaPlayerGroup)
+};
+
+} // namespace juce
@@ -0,0 +1,642 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#include "VLCMediaReader.h"
+#include "AudioDeinterleaver.h"
+
+#include <vlc/vlc.h>
+
+namespace juce
+{
+
+namespace
+{
+    // smem takes its callbacks and their context as decimal addresses in the chain string
+    template <typename Pointer>
+    String toAddressString (Pointer pointer)
+    {
+        return String (static_cast<int64>(reinterpret_cast<pointer_sized_int>(pointer)));
+    }
+}
+
+//==============================================================================
+/**
+ * Presents a VLCMediaReader's audio as 32-bit float samples. Reads carry on from
+ * wherever the previous one stopped; a read elsewhere skips forward through a
+ * couple of seconds of decoded audio, or reopens the file at the new position.
+ */
+class VLCMediaReader::AudioReader : public AudioFormatReader
+{
+public:
+    explicit AudioReader (VLCMediaReader& ownerToUse, std::unique_ptr<VLCMediaReader> readerToOwn = {})
+        : AudioFormatReader (nullptr, "libVLC"),
+          ownedReader (std::move (readerToOwn)),
+          owner (ownerToUse)
+    {
+        sampleRate = owner.getSampleRate();
+        numChannels = static_cast<unsigned int>(owner.getNumChannels());
+        bitsPerSample = 32;
+        usesFloatingPointData = true;
+        lengthInSamples = static_cast<int64>(owner.getDuration() * sampleRate);
+    }
+
+    bool readSamples (int* const* destChannels, int numDestChannels, int startOffsetInDestBuffer,
+                      int64 startSampleInFile, int numSamples) override
+    {
+        if (! moveTo (startSampleInFile))
+            return false;
+
+        float* dest[AudioDeinterleaver::maxChannels] = {};
+        auto numToRead = jmin (numDestChannels, static_cast<int>(numChannels), AudioDeinterleaver::maxChannels);
+
+        for (int i = 0; i < numToRead; ++i)
+            if (destChannels[i] != nullptr)
+                dest[i] = reinterpret_cast<float*>(destChannels[i]) + startOffsetInDestBuffer;
+
+        auto numRead = owner.readAudio (dest, numToRead, numSamples);
+
+        // Past the end of the file, and channels the file doesn't have, read as silence
+        for (int i = 0; i < numDestChannels; ++i)
+        {
+            auto numValid = i < numToRead ? numRead : 0;
+
+            if (destChannels[i] != nullptr)
+                zeromem (destChannels[i] + startOffsetInDestBuffer + numValid,
+                         sizeof (float) * static_cast<size_t>(numSamples - numValid));
+        }
+
+        return true;
+    }
+
+private:
+    bool moveTo (int64 sample)
+    {
+        auto position = owner.getAudioReadPosition();
+
+        if (sample == position)
+            return true;
+
+        // A short hop forward is cheaper to decode through than to seek
+        if (sample > position && sample - position < static_cast<int64>(sampleRate * 2.0))
+        {
+            HeapBlock<float> scratch (4096);
+            float* dest[AudioDeinterleaver::maxChannels] = {};
+
+            while (position < sample)
+            {
+                dest[0] = scratch.get();
+                auto numRead = owner.readAudio (dest, 1, static_cast<int>(jmin<int64> (4096, sample - position)));
+
+                if (numRead == 0)
+                    break;
+
+                position += numRead;
+            }
+
+            return true;
+        }
+
+        return owner.open (owner.currentFile, static_cast<double>(sample) / sampleRate);
+    }
+
+    std::unique_ptr<VLCMediaReader> ownedReader;
+    VLCMediaReader& owner;
+
+    JUCE_DECLARE_NON_COPYABLE (AudioReader)
+};
+
+//==============================================================================
+VLCMediaReader::VLCMediaReader()
+    : VLCMediaReader (Options())
+{
+}
+
+VLCMediaReader::VLCMediaReader (const Options& optionsToUse)
+    : options (optionsToUse),
+      sharedInstance (VLCInstanceManager::getInstance (optionsToUse.vlcArguments))
+{
+}
+
+VLCMediaReader::~VLCMediaReader()
+{
+    close();
+    VLCInstanceManager::releaseInstance (sharedInstance);
+}
+
+//==============================================================================
+bool VLCMediaReader::open (const File& file, double startTimeInSeconds, String* error)
+{
+    stopDecoding();
+
+    if (! file.existsAsFile())
+    {
+        if (error != nullptr)
+            *error = "File not found: " + file.getFullPathName();
+        return false;
+    }
+
+    if (file != currentFile)
+    {
+        const std::lock_guard<std::mutex> sl (lock);
+        hasAudioFormat = false;
+        sampleRate = 0.0;
+        numChannels = 0;
+        ptsOrigin = -1;
+    }
+
+    currentFile = file;
+    return startDecoding (jmax (0.0, startTimeInSeconds), error);
+}
+
+void VLCMediaReader::close()
+{
+    stopDecoding();
+    currentFile = File();
+
+    const std::lock_guard<std::mutex> sl (lock);
+    hasAudioFormat = false;
+    sampleRate = 0.0;
+    numChannels = 0;
+    ptsOrigin = -1;
+}
+
+bool VLCMediaReader::isOpen() const
+{
+    return player != nullptr;
+}
+
+bool VLCMediaReader::isFinished() const
+{
+    const std::lock_guard<std::mutex> sl (lock);
+    return hasEnded && audioFifo.getNumReady() == 0;
+}
+
+bool VLCMediaReader::waitForEnd (int timeoutMs)
+{
+    std::unique_lock<std::mutex> sl (lock);
+    auto ended = [this] { return hasEnded || player == nullptr; };
+
+    if (timeoutMs < 0)
+    {
+        stateChanged.wait (sl, ended);
+        return true;
+    }
+
+    return stateChanged.wait_for (sl, std::chrono::milliseconds (timeoutMs), ended);
+}
+
+double VLCMediaReader::getDecodedTime() const
+{
+    const std::lock_guard<std::mutex> sl (lock);
+    return decodedTime;
+}
+
+double VLCMediaReader::getDuration() const
+{
+    if (player == nullptr)
+        return 0.0;
+
+    auto lengthMs = libvlc_media_player_get_length (player);
+    return lengthMs > 0 ? static_cast<double>(lengthMs) / 1000.0 : 0.0;
+}
+
+//==============================================================================
+bool VLCMediaReader::waitForAudioFormat (int timeoutMs)
+{
+    std::unique_lock<std::mutex> sl (lock);
+
+    stateChanged.wait_for (sl, std::chrono::milliseconds (timeoutMs),
+                           [this] { return hasAudioFormat || hasEnded || player == nullptr; });
+    return hasAudioFormat;
+}
+
+double VLCMediaReader::getSampleRate() const
+{
+    const std::lock_guard<std::mutex> sl (lock);
+    return sampleRate;
+}
+
+int VLCMediaReader::getNumChannels() const
+{
+    const std::lock_guard<std::mutex> sl (lock);
+    return numChannels;
+}
+
+int VLCMediaReader::readAudio (float* const* dest, int numDestChannels, int numSamples)
+{
+    int numRead = 0;
+
+    while (numRead < numSamples)
+    {
+        std::unique_lock<std::mutex> sl (lock);
+        stateChanged.wait (sl, [this] { return audioFifo.getNumReady() > 0 || hasEnded || player == nullptr; });
+
+        int start1, size1, start2, size2;
+        audioFifo.prepareToRead (numSamples - numRead, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            break;
+
+        // The decoder only ever appends, so the samples can be copied without the lock
+        sl.unlock();
+
+        for (int ch = 0; ch < jmin (numDestChannels, audioSamples.getNumChannels()); ++ch)
+        {
+            if (dest[ch] == nullptr)
+                continue;
+
+            FloatVectorOperations::copy (dest[ch] + numRead, audioSamples.getReadPointer (ch, start1), size1);
+
+            if (size2 > 0)
+                FloatVectorOperations::copy (dest[ch] + numRead + size1, audioSamples.getReadPointer (ch, start2), size2);
+        }
+
+        sl.lock();
+        audioFifo.finishedRead (size1 + size2);
+        readPosition += size1 + size2;
+        numRead += size1 + size2;
+        stateChanged.notify_all();
+    }
+
+    return numRead;
+}
+
+int64 VLCMediaReader::getAudioReadPosition() const
+{
+    const std::lock_guard<std::mutex> sl (lock);
+    return readPosition;
+}
+
+std::unique_ptr<AudioFormatReader> VLCMediaReader::createAudioFormatReader (int timeoutMs)
+{
+    if (! waitForAudioFormat (timeoutMs))
+        return {};
+
+    return std::make_unique<AudioReader> (*this);
+}
+
+std::unique_ptr<AudioFormatReader> VLCMediaReader::createAudioFormatReaderFor (const File& file, Options options, int timeoutMs)
+{
+    options.decodeAudio = true;
+    options.decodeVideo = false;
+
+    auto reader = std::make_unique<VLCMediaReader> (options);
+
+    if (! reader->open (file) || ! reader->waitForAudioFormat (timeoutMs))
+        return {};
+
+    auto& owner = *reader;
+    return std::make_unique<AudioReader> (owner, std::move (reader));
+}
+
+//==============================================================================
+bool VLCMediaReader::startDecoding (double startTimeInSeconds, String* error)
+{
+    auto* instance = sharedInstance != nullptr ? sharedInstance->get() : nullptr;
+
+    if (instance == nullptr)
+    {
+        if (error != nullptr)
+            *error = "libVLC not initialized";
+        return false;
+    }
+
+    auto* media = libvlc_media_new_path (instance, currentFile.getFullPathName().toRawUTF8());
+
+    if (media == nullptr)
+    {
+        if (error != nullptr)
+            *error = "Failed to create media from file";
+        return false;
+    }
+
+    StringArray mediaOptions { ":sout=" + getStreamOutputChain(), ":no-sout-spu", ":no-sub-autodetect-file" };
+
+    if (! options.decodeAudio)  mediaOptions.add (":no-sout-audio");
+    if (! options.decodeVideo)  mediaOptions.add (":no-sout-video");
+
+    if (startTimeInSeconds > 0.0)
+        mediaOptions.add (":start-time=" + String (startTimeInSeconds, 3));
+
+    for (auto& option : mediaOptions)
+        libvlc_media_add_option (media, option.toRawUTF8());
+
+    {
+        const std::lock_guard<std::mutex> sl (lock);
+        startTime = decodedTime = startTimeInSeconds;
+        firstPts = -1;
+        hasEnded = isStopping = false;
+        audioFifo.reset();
+
+        // The format is kept across restarts, so a seek doesn't have to wait for it again.
+        // The first block's timestamp then lines the audio up with this position.
+        readPosition = static_cast<int64>(std::llround (startTimeInSeconds * sampleRate));
+        isAwaitingFirstAudioBlock = true;
+        numSamplesToSkip = 0;
+    }
+
+    player = libvlc_media_player_new_from_media (media);
+    libvlc_media_release (media);
+
+    if (player == nullptr)
+    {
+        if (error != nullptr)
+            *error = "Failed to create media player";
+        return false;
+    }
+
+    auto* eventManager = libvlc_media_player_event_manager (player);
+
+    for (auto eventType : { libvlc_MediaPlayerEndReached, libvlc_MediaPlayerEncounteredError })
+        libvlc_event_attach (eventManager, eventType, eventCallback, this);
+
+    if (libvlc_media_player_play (player) != 0)
+    {
+        if (error != nullptr)
+            *error = "Failed to start decoding";
+        stopDecoding();
+        return false;
+    }
+
+    return true;
+}
+
+void VLCMediaReader::stopDecoding()
+{
+    if (player == nullptr)
+        return;
+
+    {
+        // Lets a decoder thread that's waiting for room give up, so libVLC can stop
+        const std::lock_guard<std::mutex> sl (lock);
+        isStopping = true;
+        stateChanged.notify_all();
+    }
+
+    libvlc_media_player_stop (player);
+
+    auto* eventManager = libvlc_media_player_event_manager (player);
+
+    for (auto eventType : { libvlc_MediaPlayerEndReached, libvlc_MediaPlayerEncounteredError })
+        libvlc_event_detach (eventManager, eventType, eventCallback, this);
+
+    libvlc_media_player_release (player);
+
+    const std::lock_guard<std::mutex> sl (lock);
+    player = nullptr;
+    hasEnded = true;
+    audioFifo.reset();
+    stateChanged.notify_all();
+}
+
+String VLCMediaReader::getStreamOutputChain() const
+{
+    // Transcoding to raw formats only decodes and converts; nothing is re-encoded
+    StringArray transcode;
+
+    if (options.decodeVideo)
+    {
+        transcode.add ("vcodec=RV32");
+
+        if (options.maxVideoWidth > 0)   transcode.add ("maxwidth=" + String (options.maxVideoWidth));
+        if (options.maxVideoHeight > 0)  transcode.add ("maxheight=" + String (options.maxVideoHeight));
+    }
+
+    if (options.decodeAudio)
+    {
+        transcode.add ("acodec=f32l");
+
+        if (options.sampleRate > 0)   transcode.add ("samplerate=" + String (options.sampleRate));
+        if (options.numChannels > 0)  transcode.add ("channels=" + String (jmin (options.numChannels, AudioDeinterleaver::maxChannels)));
+    }
+
+    // time-sync=0 is what lets smem hand data over as soon as it's decoded
+    StringArray smem { "time-sync=0",
+                       "audio-prerender-callback=" + toAddressString (&audioPrerenderCallback),
+                       "audio-postrender-callback=" + toAddressString (&audioPostrenderCallback),
+                       "video-prerender-callback=" + toAddressString (&videoPrerenderCallback),
+                       "video-postrender-callback=" + toAddressString (&videoPostrenderCallback),
+                       "audio-data=" + toAddressString (this),
+                       "video-data=" + toAddressString (this) };
+
+    return "#transcode{" + transcode.joinIntoString (",") + "}:smem{" + smem.joinIntoString (",") + "}";
+}
+
+//==============================================================================
+void VLCMediaReader::audioBlockDecoded (const float* samples, int channels, int rate, int numFrames, int64 pts)
+{
+    std::unique_lock<std::mutex> sl (lock);
+
+    if (! hasAudioFormat)
+    {
+        if (! isPositiveAndNotGreaterThan (channels, AudioDeinterleaver::maxChannels) || rate <= 0)
+        {
+            DBG("VLCMediaReader::audioBlockDecoded - Unsupported audio format: " + String (channels) + " channels");
+            return;
+        }
+
+        sampleRate = rate;
+        numChannels = channels;
+        hasAudioFormat = true;
+        readPosition = static_cast<int64>(std::llround (startTime * sampleRate));
+
+        auto capacity = jmax (4096, roundToInt (options.audioBufferSeconds * sampleRate));
+        audioSamples.setSize (numChannels, capacity);
+        audioFifo.setTotalSize (capacity);
+        stateChanged.notify_all();
+    }
+    else if (channels != numChannels)
+    {
+        // Converting to a fixed layout (Options::numChannels) avoids this
+        DBG("VLCMediaReader::audioBlockDecoded - Channel count changed mid-stream, block skipped");
+        return;
+    }
+
+    if (isAwaitingFirstAudioBlock)
+    {
+        isAwaitingFirstAudioBlock = false;
+
+        // Demuxers resume on a packet boundary, so the first block rarely starts exactly at the
+        // requested sample. Until a decode from the start has seen where the timeline begins,
+        // file demuxers' timestamps are taken to count from zero; a wildly different answer
+        // means they don't, and the block is used as it comes.
+        auto origin = ptsOrigin >= 0 ? ptsOrigin : 0;
+        auto blockStart = static_cast<int64>(std::llround (static_cast<double>(pts - origin) * sampleRate / 1000000.0));
+        auto earlyBy = static_cast<int64>(std::llround (startTime * sampleRate)) - blockStart;
+
+        if (std::abs (earlyBy) < static_cast<int64>(sampleRate * 2.0))
+        {
+            if (earlyBy > 0)
+                numSamplesToSkip = earlyBy;
+            else if (earlyBy < 0 && ! writeAudio (sl, nullptr, static_cast<int>(-earlyBy)))
+                return;
+        }
+    }
+
+    // Decoded ahead of the requested sample
+    auto numToSkip = static_cast<int>(jmin<int64> (numSamplesToSkip, numFrames));
+    numSamplesToSkip -= numToSkip;
+    samples += numToSkip * numChannels;
+    numFrames -= numToSkip;
+
+    writeAudio (sl, samples, numFrames);
+}
+
+bool VLCMediaReader::writeAudio (std::unique_lock<std::mutex>& sl, const float* samples, int numFrames)
+{
+    // Called with the lock held; null samples write silence, for audio that starts late
+    while (numFrames > 0)
+    {
+        // Blocking here holds up the whole decoding chain until the consumer catches up
+        stateChanged.wait (sl, [this] { return audioFifo.getFreeSpace() > 0 || isStopping; });
+
+        if (isStopping)
+            return false;
+
+        int start1, size1, start2, size2;
+        audioFifo.prepareToWrite (numFrames, start1, size1, start2, size2);
+        sl.unlock();
+
+        if (samples == nullptr)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                audioSamples.clear (ch, start1, size1);
+
+                if (size2 > 0)
+                    audioSamples.clear (ch, start2, size2);
+            }
+        }
+        else
+        {
+            float* dest[AudioDeinterleaver::maxChannels];
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                dest[ch] = audioSamples.getWritePointer (ch, start1);
+
+            AudioDeinterleaver::deinterleave (samples, dest, numChannels, size1);
+
+            if (size2 > 0)
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                    dest[ch] = audioSamples.getWritePointer (ch, start2);
+
+                AudioDeinterleaver::deinterleave (samples + size1 * numChannels, dest, numChannels, size2);
+            }
+
+            samples += (size1 + size2) * numChannels;
+        }
+
+        sl.lock();
+        audioFifo.finishedWrite (size1 + size2);
+        numFrames -= size1 + size2;
+        stateChanged.notify_all();
+    }
+
+    return true;
+}
+
+void VLCMediaReader::videoFrameDecoded (const uint8* pixels, int width, int height, int pixelPitch, int64 pts)
+{
+    auto timeInSeconds = getTimeForPts (pts);
+    auto* sink = frameSink.load();
+
+    if (sink == nullptr || pixelPitch != 4 || width <= 0 || height <= 0)
+        return;
+
+    // RV32 is BGRA in memory, which is what juce::Image uses on little-endian machines
+    Image frame (Image::ARGB, width, height, false);
+
+    {
+        const Image::BitmapData bitmap (frame, Image::BitmapData::writeOnly);
+
+        for (int y = 0; y < height; ++y)
+            memcpy (bitmap.getLinePointer (y), pixels + y * width * 4, static_cast<size_t>(width) * 4);
+    }
+
+    sink->videoFrameDecoded (frame, timeInSeconds);
+}
+
+double VLCMediaReader::getTimeForPts (int64 pts)
+{
+    // Stream output doesn't promise timestamps start at zero, so they're measured from the
+    // media's start once a decode from there has seen it, and until then from the first one seen
+    const std::lock_guard<std::mutex> sl (lock);
+
+    if (firstPts < 0)
+    {
+        firstPts = pts;
+
+        // A decode from the start sees where the media's timeline begins
+        if (startTime <= 0.0)
+            ptsOrigin = pts;
+    }
+
+    auto time = ptsOrigin >= 0 ? static_cast<double>(pts - ptsOrigin) / 1000000.0
+                               : startTime + static_cast<double>(pts - firstPts) / 1000000.0;
+    decodedTime = jmax (decodedTime, time);
+    return time;
+}
+
+//==============================================================================
+void VLCMediaReader::audioPrerenderCallback (void* data, uint8** buffer, size_t size)
+{
+    auto* reader = static_cast<VLCMediaReader*>(data);
+
+    if (size > reader->audioBlockSize)
+    {
+        reader->audioBlock.realloc (size);
+        reader->audioBlockSize = size;
+    }
+
+    *buffer = reader->audioBlock.get();
+}
+
+void VLCMediaReader::audioPostrenderCallback (void* data, uint8* buffer, unsigned channels, unsigned rate,
+                                              unsigned numFrames, unsigned bitsPerSample, size_t, int64_t pts)
+{
+    auto* reader = static_cast<VLCMediaReader*>(data);
+
+    if (bitsPerSample != 32)
+        return;
+
+    reader->getTimeForPts (pts);
+    reader->audioBlockDecoded (reinterpret_cast<const float*>(buffer), static_cast<int>(channels),
+                               static_cast<int>(rate), static_cast<int>(numFrames), pts);
+}
+
+void VLCMediaReader::videoPrerenderCallback (void* data, uint8** buffer, size_t size)
+{
+    auto* reader = static_cast<VLCMediaReader*>(data);
+
+    if (size > reader->videoBlockSize)
+    {
+        reader->videoBlock.realloc (size);
+        reader->videoBlockSize = size;
+    }
+
+    *buffer = reader->videoBlock.get();
+}
+
+void VLCMediaReader::videoPostrenderCallback (void* data, uint8* buffer, int width, int height,
+                                              int pixelPitch, size_t, int64_t pts)
+{
+    static_cast<VLCMediaReader*>(data)->videoFrameDecoded (buffer, width, height, pixelPitch, pts);
+}
+
+void VLCMediaReader::eventCallback (const libvlc_event_t*, void* data)
+{
+    auto* reader = static_cast<VLCMediaReader*>(data);
+
+    // End of file and errors both mean no more data is coming
+    const std::lock_guard<std::mutex> sl (reader->lock);
+    reader->hasEnded = true;
+    reader->stateChanged.notify_all();
+}
+
+} // namespace juce
@@ -0,0 +1,199 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "VLCInstanceManager.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_graphics/juce_graphics.h>
+#include <condition_variable>
+#include <mutex>
+
+struct libvlc_media_player_t;
+struct libvlc_event_t;
+
+namespace juce
+{
+
+/**
+ * Decodes a media file as fast as the decoders and the consumer allow, for
+ * analysis and export: loudness measurement, waveforms, proxy frames.
+ *
+ * Nothing is paced to the wall clock and nothing is dropped. libVLC's callback
+ * outputs used by VLCMediaPlayer are always timed against the playback clock
+ * (and audio above 4x speed is discarded), so the reader instead decodes into
+ * libVLC's stream output, converted to raw float samples and RV32 pixels and
+ * handed over by memory callbacks with time synchronisation turned off. The
+ * decoder thread blocks while the audio buffer is full or while the frame sink
+ * is busy, so a slow consumer slows decoding down rather than losing data.
+ *
+ * Audio is pulled with readAudio() or through createAudioFormatReader(), which
+ * works with anything that reads an AudioFormatReader. Video frames are pushed
+ * to a FrameSink on libVLC's thread.
+ */
+class VLCMediaReader
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        /** Turn off whichever stream isn't needed; an unread audio stream stalls decoding once its buffer fills. */
+        bool decodeAudio = true;
+        bool decodeVideo = true;
+
+        /** The audio format to convert to; 0 keeps the source's. */
+        int sampleRate = 0;
+        int numChannels = 0;
+
+        /** Frames are scaled down to fit this, keeping their aspect ratio; 0 keeps the source size. */
+        int maxVideoWidth = 0;
+        int maxVideoHeight = 0;
+
+        /** How much decoded audio may wait to be read before the decoder blocks. */
+        double audioBufferSeconds = 4.0;
+
+        /** Arguments for the shared libVLC instance. */
+        StringArray vlcArguments = VLCInstanceManager::getDefaultArguments();
+    };
+
+    /** Receives decoded frames, in presentation order. */
+    class FrameSink
+    {
+    public:
+        virtual ~FrameSink() = default;
+
+        /**
+         * Called on libVLC's decoder thread for every frame. Decoding waits until
+         * this returns, so it may take as long as it needs.
+         */
+        virtual void videoFrameDecoded (const Image& frame, double timeInSeconds) = 0;
+    };
+
+    VLCMediaReader();
+    explicit VLCMediaReader (const Options& options);
+    ~VLCMediaReader();
+
+    //==============================================================================
+    /** Sets where decoded frames go. Set it before opening; nullptr discards them. */
+    void setFrameSink (FrameSink* sink) noexcept                 { frameSink = sink; }
+
+    /**
+     * Starts decoding a file from a position, replacing anything being read.
+     * @return false if the file can't be opened
+     */
+    bool open (const File& file, double startTimeInSeconds = 0.0, String* error = nullptr);
+
+    /** Stops decoding and forgets the file. */
+    void close();
+
+    bool isOpen() const;
+
+    /** Returns true once the decoder has reached the end and all audio has been read. */
+    bool isFinished() const;
+
+    /**
+     * Blocks until the decoder reaches the end of the file, for video-only
+     * reading where the frame sink does all the work.
+     * @return false on timeout
+     */
+    bool waitForEnd (int timeoutMs = -1);
+
+    /** Returns the media time decoding has reached, in seconds, for progress reports. */
+    double getDecodedTime() const;
+
+    /** Returns the file's duration in seconds, or 0 if it isn't known yet. */
+    double getDuration() const;
+
+    //==============================================================================
+    /**
+     * Blocks until the first audio has been decoded, so the format is known.
+     * @return false if there's no audio, or on timeout
+     */
+    bool waitForAudioFormat (int timeoutMs = 10000);
+
+    /** The decoded audio's format; 0 until it's known. */
+    double getSampleRate() const;
+    int getNumChannels() const;
+
+    /**
+     * Reads the next planar samples, blocking until they have been decoded.
+     * Missing destination channels are skipped.
+     * @return the number of samples read, which is only short at the end of the file
+     */
+    int readAudio (float* const* dest, int numDestChannels, int numSamples);
+
+    /** Returns the sample index, in the file, that readAudio() reads next. */
+    int64 getAudioReadPosition() const;
+
+    /**
+     * Returns an AudioFormatReader that pulls from this reader, opening the audio
+     * format first. Reads that jump backwards or far ahead restart decoding at the
+     * new position, so sequential reads are much the fastest. The reader must not
+     * outlive this object.
+     * @return nullptr if the file has no audio
+     */
+    std::unique_ptr<AudioFormatReader> createAudioFormatReader (int timeoutMs = 10000);
+
+    /**
+     * Opens a file's audio for offline reading, as an AudioFormatReader that owns
+     * its own VLCMediaReader. Video isn't decoded.
+     * @return nullptr if the file can't be opened or has no audio
+     */
+    static std::unique_ptr<AudioFormatReader> createAudioFormatReaderFor (const File& file, Options options = {},
+                                                                         int timeoutMs = 10000);
+
+private:
+    //==============================================================================
+    class AudioReader;
+
+    bool startDecoding (double startTimeInSeconds, String* error);
+    void stopDecoding();
+    String getStreamOutputChain() const;
+
+    void audioBlockDecoded (const float* samples, int channels, int rate, int numFrames, int64 pts);
+    bool writeAudio (std::unique_lock<std::mutex>& sl, const float* samples, int numFrames);
+    void videoFrameDecoded (const uint8* pixels, int width, int height, int pixelPitch, int64 pts);
+    double getTimeForPts (int64 pts);
+
+    static void audioPrerenderCallback (void* data, uint8** buffer, size_t size);
+    static void audioPostrenderCallback (void* data, uint8* buffer, unsigned channels, unsigned rate,
+                                         unsigned numFrames, unsigned bitsPerSample, size_t size, int64_t pts);
+    static void videoPrerenderCallback (void* data, uint8** buffer, size_t size);
+    static void videoPostrenderCallback (void* data, uint8* buffer, int width, int height,
+                                         int pixelPitch, size_t size, int64_t pts);
+    static void eventCallback (const libvlc_event_t* event, void* data);
+
+    Options options;
+    VLCInstanceManager::Instance::Ptr sharedInstance;
+    libvlc_media_player_t* player = nullptr;
+    File currentFile;
+    std::atomic<FrameSink*> frameSink { nullptr };
+
+    // Owned by libVLC's threads between prerender and postrender
+    HeapBlock<uint8> audioBlock, videoBlock;
+    size_t audioBlockSize = 0, videoBlockSize = 0;
+
+    // Everything below is guarded by lock; the fifo's contents are exchanged through it lock-free
+    mutable std::mutex lock;
+    std::condition_variable stateChanged;
+    AbstractFifo audioFifo { 1 };
+    AudioBuffer<float> audioSamples;
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    bool hasAudioFormat = false, hasEnded = false, isStopping = false;
+    double startTime = 0.0, decodedTime = 0.0;
+    int64 firstPts = -1;
+    int64 ptsOrigin = -1;                   // The pts of the media's start, once a decode from there has seen it
+    int64 readPosition = 0;
+    bool isAwaitingFirstAudioBlock = false;
+    int64 numSamplesToSkip = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VLCMediaReader)
+};
+
+} // namespace juce
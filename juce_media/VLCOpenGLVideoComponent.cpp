@@ -0,0 +1,452 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#include "VLCOpenGLVideoComponent.h"
+
+#include <cstring>  // for std::memcpy
+
+namespace juce
+{
+
+using namespace juce::gl;
+
+namespace
+{
+    struct PlaneFormat
+    {
+        int width;
+        int height;
+        int bytesPerPixel;
+        GLint internalFormat;
+        GLenum format;
+    };
+
+    // Texture layout for one plane of a frame, matching VideoFramePool::getPlaneLayout()
+    PlaneFormat getPlaneFormat (VLCMediaPlayer::VideoPixelFormat format, int width, int height, int plane)
+    {
+        if (format == VLCMediaPlayer::VideoPixelFormat::RGB32)
+            return { width, height, 4, GL_RGBA8, GL_BGRA };
+
+        if (plane == 0)
+            return { width, height, 1, GL_R8, GL_RED };
+
+        int chromaWidth = (width + 1) / 2;
+        int chromaHeight = (height + 1) / 2;
+
+        if (format == VLCMediaPlayer::VideoPixelFormat::NV12)
+            return { chromaWidth, chromaHeight, 2, GL_RG8, GL_RG };
+
+        return { chromaWidth, chromaHeight, 1, GL_R8, GL_RED };
+    }
+
+    const char* const vertexShaderSource = R"(
+        attribute vec2 position;
+        attribute vec2 textureCoordinateIn;
+        uniform vec2 scale;
+        varying vec2 textureCoordinate;
+
+        void main()
+        {
+            textureCoordinate = textureCoordinateIn;
+            gl_Position = vec4 (position * scale, 0.0, 1.0);
+        }
+    )";
+
+    const char* const rgbFragmentShaderSource = R"(
+        varying vec2 textureCoordinate;
+        uniform sampler2D planeY;
+
+        void main()
+        {
+            gl_FragColor = vec4 (texture2D (planeY, textureCoordinate).rgb, 1.0);
+        }
+    )";
+
+    const char* const i420FragmentShaderSource = R"(
+        varying vec2 textureCoordinate;
+        uniform sampler2D planeY;
+        uniform sampler2D planeU;
+        uniform sampler2D planeV;
+        uniform mat3 yuvToRgb;
+        uniform vec3 yuvOffset;
+
+        void main()
+        {
+            vec3 yuv = vec3 (texture2D (planeY, textureCoordinate).r,
+                             texture2D (planeU, textureCoordinate).r,
+                             texture2D (planeV, textureCoordinate).r);
+            gl_FragColor = vec4 (clamp (yuvToRgb * (yuv - yuvOffset), 0.0, 1.0), 1.0);
+        }
+    )";
+
+    const char* const nv12FragmentShaderSource = R"(
+        varying vec2 textureCoordinate;
+        uniform sampler2D planeY;
+        uniform sampler2D planeU;
+        uniform mat3 yuvToRgb;
+        uniform vec3 yuvOffset;
+
+        void main()
+        {
+            vec3 yuv = vec3 (texture2D (planeY, textureCoordinate).r,
+                             texture2D (planeU, textureCoordinate).rg);
+            gl_FragColor = vec4 (clamp (yuvToRgb * (yuv - yuvOffset), 0.0, 1.0), 1.0);
+        }
+    )";
+
+    // Limited-range YUV to RGB, column-major as GLSL expects
+    const GLfloat bt709Matrix[9] = { 1.164f,  1.164f, 1.164f,
+                                     0.0f,   -0.213f, 2.112f,
+                                     1.793f, -0.533f, 0.0f };
+
+    const GLfloat bt601Matrix[9] = { 1.164f,  1.164f, 1.164f,
+                                     0.0f,   -0.392f, 2.017f,
+                                     1.596f, -0.813f, 0.0f };
+
+    // The same conversion on the CPU, for when a YUV shader won't build; writes BGRA
+    void convertYuvToBgra (const VLCMediaPlayer::VideoFrame& frame, uint8_t* destination)
+    {
+        auto width = frame.getWidth();
+        auto height = frame.getHeight();
+        auto isNV12 = frame.getFormat() == VLCMediaPlayer::VideoPixelFormat::NV12;
+        auto* matrix = height >= 720 ? bt709Matrix : bt601Matrix;
+
+        auto toByte = [] (float value) { return static_cast<uint8_t> (jlimit (0, 255, roundToInt (value * 255.0f))); };
+
+        for (int y = 0; y < jmin (height, frame.getNumLines (0)); ++y)
+        {
+            auto* lumaRow = frame.getPlane (0) + y * frame.getPitch (0);
+            auto* uRow = frame.getPlane (1) + (y / 2) * frame.getPitch (1);
+            auto* vRow = isNV12 ? uRow + 1 : frame.getPlane (2) + (y / 2) * frame.getPitch (2);
+            auto chromaStep = isNV12 ? 2 : 1;
+            auto* out = destination + static_cast<size_t> (y) * static_cast<size_t> (width) * 4;
+
+            for (int x = 0; x < width; ++x)
+            {
+                auto luma = static_cast<float> (lumaRow[x]) / 255.0f - 16.0f / 255.0f;
+                auto u = static_cast<float> (uRow[(x / 2) * chromaStep]) / 255.0f - 128.0f / 255.0f;
+                auto v = static_cast<float> (vRow[(x / 2) * chromaStep]) / 255.0f - 128.0f / 255.0f;
+
+                *out++ = toByte (matrix[2] * luma + matrix[5] * u + matrix[8] * v);
+                *out++ = toByte (matrix[1] * luma + matrix[4] * u + matrix[7] * v);
+                *out++ = toByte (matrix[0] * luma + matrix[3] * u + matrix[6] * v);
+                *out++ = 255;
+            }
+        }
+    }
+}
+
+//==============================================================================
+VLCOpenGLVideoComponent::VLCOpenGLVideoComponent (VLCMediaPlayer& playerToUse,
+                                                  VLCMediaPlayer::VideoPixelFormat pixelFormat)
+    : player (playerToUse)
+{
+    setOpaque (true);
+
+    // Ask libVLC for the layout we'll upload; applies when the video output next starts
+    player.setVideoPixelFormat (pixelFormat);
+
+    openGLContext.setOpenGLVersionRequired (OpenGLContext::openGL3_2);
+    openGLContext.setRenderer (this);
+    openGLContext.setContinuousRepainting (true);
+    openGLContext.setComponentPaintingEnabled (false);
+    openGLContext.attachTo (*this);
+}
+
+VLCOpenGLVideoComponent::~VLCOpenGLVideoComponent()
+{
+    openGLContext.detach();
+}
+
+//==============================================================================
+void VLCOpenGLVideoComponent::newOpenGLContextCreated()
+{
+    // Full-screen quad as (x, y, u, v); row 0 of each plane is the top of the picture
+    const GLfloat vertices[] = { -1.0f, -1.0f, 0.0f, 1.0f,
+                                  1.0f, -1.0f, 1.0f, 1.0f,
+                                 -1.0f,  1.0f, 0.0f, 0.0f,
+                                  1.0f,  1.0f, 1.0f, 0.0f };
+
+    glGenVertexArrays (1, &vertexArray);
+    glBindVertexArray (vertexArray);
+
+    glGenBuffers (1, &vertexBuffer);
+    glBindBuffer (GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData (GL_ARRAY_BUFFER, sizeof (vertices), vertices, GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray (0);
+    glVertexAttribPointer (0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof (GLfloat), nullptr);
+    glEnableVertexAttribArray (1);
+    glVertexAttribPointer (1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof (GLfloat),
+                           reinterpret_cast<const void*> (2 * sizeof (GLfloat)));
+
+    glBindVertexArray (0);
+
+    glGenTextures (maxPlanes, textures);
+
+    for (auto texture : textures)
+    {
+        glBindTexture (GL_TEXTURE_2D, texture);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    glBindTexture (GL_TEXTURE_2D, 0);
+
+    for (auto& set : pixelBuffers)
+        glGenBuffers (maxPlanes, set);
+
+    createShader (player.getVideoPixelFormat());
+}
+
+void VLCOpenGLVideoComponent::openGLContextClosing()
+{
+    shader.reset();
+
+    glDeleteTextures (maxPlanes, textures);
+
+    for (auto& set : pixelBuffers)
+        glDeleteBuffers (maxPlanes, set);
+
+    glDeleteBuffers (1, &vertexBuffer);
+    glDeleteVertexArrays (1, &vertexArray);
+
+    zeromem (textures, sizeof (textures));
+    zeromem (textureWidths, sizeof (textureWidths));
+    zeromem (textureHeights, sizeof (textureHeights));
+    zeromem (textureFormats, sizeof (textureFormats));
+    zeromem (pixelBuffers, sizeof (pixelBuffers));
+    vertexBuffer = 0;
+    vertexArray = 0;
+    lastFrameSequence = 0;
+    frameWidth = frameHeight = 0;
+
+    // A new context may well have a different driver behind it
+    failedShaderFormats = 0;
+}
+
+bool VLCOpenGLVideoComponent::createShader (VLCMediaPlayer::VideoPixelFormat format)
+{
+    const char* fragmentSource = rgbFragmentShaderSource;
+
+    if (format == VLCMediaPlayer::VideoPixelFormat::I420)
+        fragmentSource = i420FragmentShaderSource;
+    else if (format == VLCMediaPlayer::VideoPixelFormat::NV12)
+        fragmentSource = nv12FragmentShaderSource;
+
+    auto newShader = std::make_unique<OpenGLShaderProgram> (openGLContext);
+
+    // Attribute slots must match the vertex array set up in newOpenGLContextCreated()
+    glBindAttribLocation (newShader->getProgramID(), 0, "position");
+    glBindAttribLocation (newShader->getProgramID(), 1, "textureCoordinateIn");
+
+    if (! newShader->addVertexShader (OpenGLHelpers::translateVertexShaderToV3 (vertexShaderSource))
+        || ! newShader->addFragmentShader (OpenGLHelpers::translateFragmentShaderToV3 (fragmentSource))
+        || ! newShader->link())
+    {
+        // Latched, so the failure is reported once rather than retried on every frame
+        DBG ("VLCOpenGLVideoComponent - Shader error: " + newShader->getLastError());
+        failedShaderFormats |= 1 << static_cast<int> (format);
+        shader.reset();
+        return false;
+    }
+
+    shader = std::move (newShader);
+    shaderFormat = format;
+    return true;
+}
+
+bool VLCOpenGLVideoComponent::prepareShader (VLCMediaPlayer::VideoPixelFormat format)
+{
+    if (shader != nullptr && shaderFormat == format)
+        return true;
+
+    return ! hasShaderFailed (format) && createShader (format);
+}
+
+bool VLCOpenGLVideoComponent::hasShaderFailed (VLCMediaPlayer::VideoPixelFormat format) const noexcept
+{
+    return (failedShaderFormats & (1 << static_cast<int> (format))) != 0;
+}
+
+//==============================================================================
+void VLCOpenGLVideoComponent::uploadFrame (const VLCMediaPlayer::VideoFrame& frame)
+{
+    const uint8_t* planes[maxPlanes] {};
+    int pitches[maxPlanes] {};
+    int lines[maxPlanes] {};
+
+    for (int plane = 0; plane < frame.getNumPlanes(); ++plane)
+    {
+        planes[plane] = frame.getPlane (plane);
+        pitches[plane] = frame.getPitch (plane);
+        lines[plane] = frame.getNumLines (plane);
+    }
+
+    uploadPlanes (frame.getFormat(), frame.getWidth(), frame.getHeight(), frame.getNumPlanes(), planes, pitches, lines);
+}
+
+void VLCOpenGLVideoComponent::uploadConvertedFrame (const VLCMediaPlayer::VideoFrame& frame)
+{
+    auto size = static_cast<size_t> (frame.getWidth()) * static_cast<size_t> (frame.getHeight()) * 4;
+
+    if (size != convertedFrameSize)
+    {
+        convertedFrame.allocate (size, true);
+        convertedFrameSize = size;
+    }
+
+    convertYuvToBgra (frame, convertedFrame.get());
+
+    const uint8_t* planes[] = { convertedFrame.get() };
+    const int pitches[] = { frame.getWidth() * 4 };
+    const int lines[] = { frame.getHeight() };
+
+    uploadPlanes (VLCMediaPlayer::VideoPixelFormat::RGB32, frame.getWidth(), frame.getHeight(), 1, planes, pitches, lines);
+}
+
+void VLCOpenGLVideoComponent::uploadPlanes (VLCMediaPlayer::VideoPixelFormat format, int width, int height, int numPlanes,
+                                            const uint8_t* const* planes, const int* pitches, const int* lines)
+{
+    auto& buffers = pixelBuffers[nextPixelBufferSet];
+    nextPixelBufferSet ^= 1;
+
+    glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+
+    for (int plane = 0; plane < numPlanes; ++plane)
+    {
+        auto planeFormat = getPlaneFormat (format, width, height, plane);
+        auto rowsToUpload = jmin (planeFormat.height, lines[plane]);
+        auto size = static_cast<GLsizeiptr> (pitches[plane]) * rowsToUpload;
+
+        // Orphan the previous storage and copy the plane straight into driver memory
+        glBindBuffer (GL_PIXEL_UNPACK_BUFFER, buffers[plane]);
+        glBufferData (GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+        if (auto* destination = glMapBufferRange (GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT))
+        {
+            std::memcpy (destination, planes[plane], static_cast<size_t> (size));
+            glUnmapBuffer (GL_PIXEL_UNPACK_BUFFER);
+        }
+
+        glBindTexture (GL_TEXTURE_2D, textures[plane]);
+        glPixelStorei (GL_UNPACK_ROW_LENGTH, pitches[plane] / planeFormat.bytesPerPixel);
+
+        if (textureWidths[plane] != planeFormat.width || textureHeights[plane] != planeFormat.height
+             || textureFormats[plane] != planeFormat.internalFormat)
+        {
+            glTexImage2D (GL_TEXTURE_2D, 0, planeFormat.internalFormat, planeFormat.width, planeFormat.height,
+                          0, planeFormat.format, GL_UNSIGNED_BYTE, nullptr);
+            textureWidths[plane] = planeFormat.width;
+            textureHeights[plane] = planeFormat.height;
+            textureFormats[plane] = planeFormat.internalFormat;
+        }
+
+        // Sources from the bound pixel buffer, so the transfer runs asynchronously
+        glTexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, planeFormat.width, rowsToUpload,
+                         planeFormat.format, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+    glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture (GL_TEXTURE_2D, 0);
+
+    frameWidth = width;
+    frameHeight = height;
+}
+
+void VLCOpenGLVideoComponent::renderOpenGL()
+{
+    OpenGLHelpers::clear (Colours::black);
+
+    // Holding the frame keeps its planes alive while they're copied, whatever the player does meanwhile
+    auto frame = player.getCurrentVideoFrameHandle();
+
+    if (frame.isValid())
+    {
+        auto format = frame.getFormat();
+        auto convertInSoftware = false;
+
+        // If a YUV shader won't build, the frames are converted on the CPU and drawn with the
+        // RGB one instead, and libVLC is asked for RGB32 the next time it negotiates
+        if (! prepareShader (format) && format != VLCMediaPlayer::VideoPixelFormat::RGB32)
+        {
+            convertInSoftware = prepareShader (VLCMediaPlayer::VideoPixelFormat::RGB32);
+            player.setVideoPixelFormat (VLCMediaPlayer::VideoPixelFormat::RGB32);
+        }
+
+        if (shader != nullptr && frame.getSequenceNumber() != lastFrameSequence)
+        {
+            if (convertInSoftware)
+                uploadConvertedFrame (frame);
+            else
+                uploadFrame (frame);
+
+            lastFrameSequence = frame.getSequenceNumber();
+        }
+
+        frame.reset();
+    }
+
+    if (shader == nullptr || frameWidth <= 0 || frameHeight <= 0)
+        return;
+
+    auto renderingScale = static_cast<float> (openGLContext.getRenderingScale());
+    auto viewWidth = roundToInt (renderingScale * static_cast<float> (getWidth()));
+    auto viewHeight = roundToInt (renderingScale * static_cast<float> (getHeight()));
+
+    if (viewWidth <= 0 || viewHeight <= 0)
+        return;
+
+    glViewport (0, 0, viewWidth, viewHeight);
+
+    // Letterbox the picture inside the component, preserving its aspect ratio
+    auto frameAspect = static_cast<float> (frameWidth) / static_cast<float> (frameHeight);
+    auto viewAspect = static_cast<float> (viewWidth) / static_cast<float> (viewHeight);
+    auto scaleX = frameAspect > viewAspect ? 1.0f : frameAspect / viewAspect;
+    auto scaleY = frameAspect > viewAspect ? viewAspect / frameAspect : 1.0f;
+
+    shader->use();
+    shader->setUniform ("scale", scaleX, scaleY);
+    shader->setUniform ("planeY", 0);
+
+    if (shaderFormat != VLCMediaPlayer::VideoPixelFormat::RGB32)
+    {
+        shader->setUniform ("planeU", 1);
+        shader->setUniform ("planeV", 2);
+        shader->setUniform ("yuvOffset", 16.0f / 255.0f, 128.0f / 255.0f, 128.0f / 255.0f);
+
+        // HD and larger material is BT.709; SD is almost always BT.601
+        OpenGLShaderProgram::Uniform matrix (*shader, "yuvToRgb");
+        matrix.setMatrix3 (frameHeight >= 720 ? bt709Matrix : bt601Matrix, 1, GL_FALSE);
+    }
+
+    int numPlanes = shaderFormat == VLCMediaPlayer::VideoPixelFormat::RGB32 ? 1
+                  : shaderFormat == VLCMediaPlayer::VideoPixelFormat::NV12 ? 2 : 3;
+
+    for (int plane = 0; plane < numPlanes; ++plane)
+    {
+        glActiveTexture (static_cast<GLenum> (GL_TEXTURE0 + plane));
+        glBindTexture (GL_TEXTURE_2D, textures[plane]);
+    }
+
+    glBindVertexArray (vertexArray);
+    glDrawArrays (GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray (0);
+
+    for (int plane = numPlanes; --plane >= 0;)
+    {
+        glActiveTexture (static_cast<GLenum> (GL_TEXTURE0 + plane));
+        glBindTexture (GL_TEXTURE_2D, 0);
+    }
+}
+
+} // namespace juce
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+   This file is part of the juce_libvlc module.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "VLCMediaPlayer.h"
+#include <juce_opengl/juce_opengl.h>
+
+namespace juce
+{
+
+/**
+ * Renders a VLCMediaPlayer's frames with OpenGL, bypassing juce::Image and
+ * software compositing entirely. Frames are streamed from the player's frame
+ * pool into textures through pixel buffer objects, and YUV layouts are
+ * converted to RGB in the fragment shader. If a YUV shader won't build on the
+ * driver, its frames are converted on the CPU instead and RGB32 is requested
+ * from libVLC for the next time it negotiates.
+ *
+ * The component becomes the player's only frame consumer: don't call
+ * getCurrentVideoFrame() on the same player while one is attached.
+ * The player must outlive the component.
+ */
+class VLCOpenGLVideoComponent : public Component,
+                                private OpenGLRenderer
+{
+public:
+    //==============================================================================
+    /**
+     * Creates a component that draws the given player's video.
+     * @param player The player to take frames from
+     * @param pixelFormat The layout to ask libVLC for; I420 halves upload bandwidth
+     *                    compared with RGB32 and moves colour conversion to the GPU
+     */
+    explicit VLCOpenGLVideoComponent (VLCMediaPlayer& player,
+                                      VLCMediaPlayer::VideoPixelFormat pixelFormat = VLCMediaPlayer::VideoPixelFormat::I420);
+    ~VLCOpenGLVideoComponent() override;
+
+    //==============================================================================
+    void paint (Graphics&) override {}
+
+private:
+    //==============================================================================
+    void newOpenGLContextCreated() override;
+    void renderOpenGL() override;
+    void openGLContextClosing() override;
+
+    bool createShader (VLCMediaPlayer::VideoPixelFormat format);
+    bool prepareShader (VLCMediaPlayer::VideoPixelFormat format);
+    bool hasShaderFailed (VLCMediaPlayer::VideoPixelFormat format) const noexcept;
+    void uploadFrame (const VLCMediaPlayer::VideoFrame& frame);
+    void uploadConvertedFrame (const VLCMediaPlayer::VideoFrame& frame);
+    void uploadPlanes (VLCMediaPlayer::VideoPixelFormat format, int width, int height, int numPlanes,
+                       const uint8_t* const* planes, const int* pitches, const int* lines);
+
+    //==============================================================================
+    static constexpr int maxPlanes = 3;
+
+    VLCMediaPlayer& player;
+    OpenGLContext openGLContext;
+
+    std::unique_ptr<OpenGLShaderProgram> shader;
+    VLCMediaPlayer::VideoPixelFormat shaderFormat = VLCMediaPlayer::VideoPixelFormat::RGB32;
+    int failedShaderFormats = 0;        // One bit per pixel format whose shader wouldn't build
+
+    // YUV frames are converted here when their shader failed, and drawn as RGB32
+    HeapBlock<uint8_t> convertedFrame;
+    size_t convertedFrameSize = 0;
+
+    GLuint textures[maxPlanes] {};
+    int textureWidths[maxPlanes] {};
+    int textureHeights[maxPlanes] {};
+    GLint textureFormats[maxPlanes] {};
+
+    // Two sets of pixel buffers, orphaned on every upload, so a new frame rarely has to
+    // wait for the driver to finish with the previous one (there's no fence, so it can)
+    GLuint pixelBuffers[2][maxPlanes] {};
+    int nextPixelBufferSet = 0;
+
+    GLuint vertexArray = 0;
+    GLuint vertexBuffer = 0;
+
+    uint64_t lastFrameSequence = 0;
+    int frameWidth = 0;
+    int frameHeight = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VLCOpenGLVideoComponent)
+};
+
+} // namespace juce
@@ -7,7 +7,8 @@
   ==============================================================================
 */
 
-#include <juce_libvlc/juce_libvlc.h>
+#include <JuceHeader.h>
+#include "../juce_libvlc.h"
 #include <iostream>
 
 int main()
@@ -34,6 +35,22 @@ int main()
         return 1;
     }
     
+    // The unit tests in unit_tests.cpp exercise the module's parts without libVLC
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure (false);
+    runner.runTestsInCategory ("juce_libvlc");
+    
+    for (int i = 0; i < runner.getNumResults(); ++i)
+    {
+        if (runner.getResult (i)->failures > 0)
+        {
+            std::cerr << "✗ Unit tests failed" << std::endl;
+            return 1;
+        }
+    }
+    
+    std::cout << "✓ Unit tests passed" << std::endl;
+    
     std::cout << "juce_libvlc module test completed successfully!" << std::endl;
     return 0;
 }
@@ -0,0 +1,581 @@
+/*
+  ==============================================================================
+
+   Unit tests for the juce_libvlc module's building blocks: the audio ring,
+   the deinterleaver, the frame cache, the keyframe index and the frame pool.
+   None of them need libVLC to be running.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../juce_libvlc.h"
+
+namespace juce
+{
+
+//==============================================================================
+class VLCMediaPlayerInternalsTests : public UnitTest
+{
+public:
+    VLCMediaPlayerInternalsTests() : UnitTest ("VLCMediaPlayer internals", "juce_libvlc") {}
+
+    void runTest() override
+    {
+        testRingWrap();
+        testRingPeek();
+        testRingFlush();
+        testPoolHandles();
+        testPoolSpareSlots();
+        testPoolReleaseAndReset();
+    }
+
+private:
+    using AudioBuffer = VLCMediaPlayer::AudioBuffer;
+    using VideoFramePool = VLCMediaPlayer::VideoFramePool;
+    using VideoFrame = VLCMediaPlayer::VideoFrame;
+
+    static constexpr int numRingChannels = 2;
+
+    // Channel c of sample n holds c * 100000 + n, so any misplaced sample shows up
+    static void fillRamp (juce::AudioBuffer<float>& block, int firstSample)
+    {
+        for (int channel = 0; channel < block.getNumChannels(); ++channel)
+            for (int i = 0; i < block.getNumSamples(); ++i)
+                block.setSample (channel, i, static_cast<float>(channel * 100000 + firstSample + i));
+    }
+
+    bool isRamp (const juce::AudioBuffer<float>& block, int numSamples, int firstSample)
+    {
+        for (int channel = 0; channel < block.getNumChannels(); ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                if (block.getSample (channel, i) != static_cast<float>(channel * 100000 + firstSample + i))
+                    return false;
+
+        return true;
+    }
+
+    int writeRamp (AudioBuffer& ring, int numSamples, int firstSample)
+    {
+        juce::AudioBuffer<float> block (numRingChannels, numSamples);
+        fillRamp (block, firstSample);
+        return ring.write (block.getArrayOfReadPointers(), numRingChannels, numSamples);
+    }
+
+    void testRingWrap()
+    {
+        beginTest ("Audio ring wraps around its end");
+
+        AudioBuffer ring (numRingChannels, 100);
+        expectEquals (ring.numSamples, 128);
+        expectEquals (ring.getFreeSpace(), 128);
+
+        juce::AudioBuffer<float> block (numRingChannels, 128);
+
+        // Move the read position most of the way along, so the next writes straddle the end
+        expectEquals (writeRamp (ring, 100, 0), 100);
+        expectEquals (ring.read (block.getArrayOfWritePointers(), numRingChannels, 80), 80);
+        expect (isRamp (block, 80, 0));
+
+        expectEquals (writeRamp (ring, 100, 100), 100);
+        expectEquals (ring.getNumReady(), 120);
+        expectEquals (ring.getFreeSpace(), 8);
+
+        expectEquals (ring.read (block.getArrayOfWritePointers(), numRingChannels, 128), 120);
+        expect (isRamp (block, 120, 80));
+        expectEquals (ring.getNumReady(), 0);
+
+        // Writes beyond the free space are cut short rather than overwriting unread samples
+        expectEquals (writeRamp (ring, 200, 200), 128);
+        expectEquals (ring.getFreeSpace(), 0);
+        expectEquals (writeRamp (ring, 10, 328), 0);
+    }
+
+    void testRingPeek()
+    {
+        beginTest ("Audio ring peek doesn't consume");
+
+        AudioBuffer ring (numRingChannels, 64);
+        juce::AudioBuffer<float> block (numRingChannels, 64);
+
+        writeRamp (ring, 50, 0);
+        ring.read (block.getArrayOfWritePointers(), numRingChannels, 40);
+        writeRamp (ring, 40, 50);
+
+        // 50 ready, starting 40 along, so the peek wraps too
+        expectEquals (ring.peek (block.getArrayOfWritePointers(), numRingChannels, 64), 50);
+        expect (isRamp (block, 50, 40));
+        expectEquals (ring.getNumReady(), 50);
+
+        block.clear();
+        expectEquals (ring.read (block.getArrayOfWritePointers(), numRingChannels, 30), 30);
+        expect (isRamp (block, 30, 40));
+    }
+
+    void testRingFlush()
+    {
+        beginTest ("Audio ring flush discards what was written before it");
+
+        AudioBuffer ring (numRingChannels, 128);
+        juce::AudioBuffer<float> block (numRingChannels, 128);
+
+        writeRamp (ring, 60, 0);
+        ring.read (block.getArrayOfWritePointers(), numRingChannels, 10);
+
+        auto generation = ring.flushGeneration.load();
+        ring.flush();
+
+        expectEquals (static_cast<int>(ring.flushGeneration.load() - generation), 1);
+        expect (ring.flushPosition.load() == ring.head.load());
+
+        // A second flush with nothing new written doesn't move the flush position
+        auto position = ring.flushPosition.load();
+        ring.flush();
+        expect (ring.flushPosition.load() == position);
+
+        writeRamp (ring, 20, 1000);
+
+        // The flush is only honoured by the consumer's next read; a peek still sees the stale audio
+        expectEquals (ring.peek (block.getArrayOfWritePointers(), numRingChannels, 5), 5);
+        expect (isRamp (block, 5, 10));
+
+        expectEquals (ring.read (block.getArrayOfWritePointers(), numRingChannels, 128), 20);
+        expect (isRamp (block, 20, 1000));
+        expectEquals (ring.getNumReady(), 0);
+    }
+
+    //==============================================================================
+    static int indexOf (VideoFramePool& pool, VideoFramePool::Slot* slot)
+    {
+        if (slot == &pool.overflowSlot)
+            return -1;
+
+        return static_cast<int>(slot - pool.slots);
+    }
+
+    // Writes a frame into the pool and moves the reader on to it
+    static VideoFramePool::Slot* presentFrame (VideoFramePool& pool)
+    {
+        pool.publish (pool.acquireForWriting());
+        return pool.acquireForReading();
+    }
+
+    void testPoolHandles()
+    {
+        beginTest ("Frame pool handles count their holders");
+
+        VideoFramePool pool;
+        pool.setFormat (16, 16, VLCMediaPlayer::VideoPixelFormat::RGB32);
+        pool.preallocate();
+
+        auto* slot = presentFrame (pool);
+        expect (slot != nullptr);
+        expect (! pool.isAnyFrameHeld());
+
+        {
+            VideoFrame frame (*slot);
+            expectEquals (slot->numHolders.load(), 1);
+            expect (pool.isAnyFrameHeld());
+            expect (frame.getPlane (0) == slot->planes[0]);
+            expectEquals (frame.getWidth(), 16);
+
+            auto copy = frame;
+            expectEquals (slot->numHolders.load(), 2);
+
+            auto moved = std::move (copy);
+            expectEquals (slot->numHolders.load(), 2);
+            expect (! copy.isValid());
+
+            moved = frame;
+            expectEquals (slot->numHolders.load(), 2);
+
+            moved.reset();
+            expectEquals (slot->numHolders.load(), 1);
+        }
+
+        expectEquals (slot->numHolders.load(), 0);
+        expect (! pool.isAnyFrameHeld());
+    }
+
+    void testPoolSpareSlots()
+    {
+        beginTest ("Frame pool only uses spare slots while frames are held");
+
+        VideoFramePool pool;
+        pool.setFormat (16, 16, VLCMediaPlayer::VideoPixelFormat::RGB32);
+        pool.preallocate();
+
+        // With nothing held, the core slots are all there is; after them comes the overflow slot
+        for (int i = 0; i < VideoFramePool::numCoreSlots; ++i)
+            expect (indexOf (pool, pool.acquireForWriting()) < VideoFramePool::numCoreSlots);
+
+        expectEquals (indexOf (pool, pool.acquireForWriting()), -1);
+
+        pool.reset();
+
+        auto* held = presentFrame (pool);
+        auto heldIndex = indexOf (pool, held);
+        VideoFrame frame (*held);
+
+        // The held slot is skipped, and the spare slots open up
+        Array<int> written;
+
+        for (int i = 0; i < VideoFramePool::numSlots - 1; ++i)
+            written.add (indexOf (pool, pool.acquireForWriting()));
+
+        expect (! written.contains (heldIndex));
+        expect (! written.contains (-1));
+        expect (written.contains (VideoFramePool::numCoreSlots));
+
+        // A slot the reader has moved off stays untouched for as long as it's held
+        pool.reset();
+        presentFrame (pool);
+        auto* next = presentFrame (pool);
+        expect (next != held);
+        expectEquals (held->state.load(), static_cast<int>(VideoFramePool::slotFree));
+
+        for (int i = 0; i < VideoFramePool::numSlots; ++i)
+            expect (pool.acquireForWriting() != held);
+
+        frame.reset();
+        expect (! pool.isAnyFrameHeld());
+    }
+
+    void testPoolReleaseAndReset()
+    {
+        beginTest ("Frame pool keeps the frames still in use when it's reset or released");
+
+        VideoFramePool pool;
+        pool.setFormat (16, 16, VLCMediaPlayer::VideoPixelFormat::I420);
+        pool.preallocate();
+
+        auto* held = presentFrame (pool);
+        VideoFrame frame (*held);
+        auto* reading = presentFrame (pool);
+        expect (reading != held);
+
+        pool.releaseMemory();
+
+        // Both the held slot and the one being read keep their pixels; idle ones are freed
+        expect (held->planes[0] != nullptr);
+        expect (reading->planes[0] != nullptr);
+
+        for (auto& slot : pool.slots)
+            if (&slot != held && &slot != reading)
+                expectEquals (slot.numPlanes, 0);
+
+        // The reader lets go of its slot on its first read after the reset
+        expectEquals (reading->state.load(), static_cast<int>(VideoFramePool::slotReading));
+        expect (pool.acquireForReading() == nullptr);
+        expectEquals (reading->state.load(), static_cast<int>(VideoFramePool::slotFree));
+
+        frame.reset();
+    }
+};
+
+static VLCMediaPlayerInternalsTests vlcMediaPlayerInternalsTests;
+
+//==============================================================================
+class AudioDeinterleaverTests : public UnitTest
+{
+public:
+    AudioDeinterleaverTests() : UnitTest ("AudioDeinterleaver", "juce_libvlc") {}
+
+    void runTest() override
+    {
+        auto random = getRandom();
+
+        for (auto numChannels : { 1, 2, 6, 8, 16 })
+        {
+            beginTest (String (numChannels) + " channels match the scalar reference");
+
+            // Odd lengths leave frames over for the scalar tail after the vector kernels
+            for (auto numFrames : { 0, 1, 3, 7, 64, 1023 })
+            {
+                HeapBlock<float> interleaved (static_cast<size_t>(numChannels * numFrames) + 1);
+
+                for (int i = 0; i < numChannels * numFrames; ++i)
+                    interleaved[i] = random.nextFloat() * 2.0f - 1.0f;
+
+                juce::AudioBuffer<float> fast (numChannels, jmax (1, numFrames));
+                juce::AudioBuffer<float> reference (numChannels, jmax (1, numFrames));
+                fast.clear();
+                reference.clear();
+
+                AudioDeinterleaver::deinterleave (interleaved, fast.getArrayOfWritePointers(), numChannels, numFrames);
+                AudioDeinterleaver::deinterleaveScalar (interleaved, reference.getArrayOfWritePointers(), numChannels, numFrames);
+
+                bool matches = true;
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    for (int i = 0; i < numFrames; ++i)
+                        matches = matches && fast.getSample (channel, i) == reference.getSample (channel, i)
+                                          && reference.getSample (channel, i) == interleaved[i * numChannels + channel];
+
+                expect (matches, String (numFrames) + " frames");
+            }
+        }
+    }
+};
+
+static AudioDeinterleaverTests audioDeinterleaverTests;
+
+//==============================================================================
+class FrameCacheTests : public UnitTest
+{
+public:
+    FrameCacheTests() : UnitTest ("FrameCache", "juce_libvlc") {}
+
+    void runTest() override
+    {
+        auto makeFrame = [] { return Image (Image::ARGB, 16, 16, true); };
+        const size_t frameBytes = 16 * 16 * 4;
+
+        beginTest ("Evicts the least recently used frame");
+        {
+            FrameCache cache (frameBytes * 3);
+
+            for (int64 time = 0; time < 3; ++time)
+                cache.add (1, time, makeFrame());
+
+            expectEquals (cache.getNumFrames(), 3);
+            expect (cache.getNumBytes() == frameBytes * 3);
+
+            // Looking frame 0 up makes frame 1 the oldest
+            expect (cache.get (1, 0).isValid());
+            cache.add (1, 3, makeFrame());
+
+            expectEquals (cache.getNumFrames(), 3);
+            expect (! cache.get (1, 1).isValid());
+            expect (cache.get (1, 0).isValid());
+            expect (cache.get (1, 2).isValid());
+            expect (cache.get (1, 3).isValid());
+        }
+
+        beginTest ("Replacing a frame doesn't count it twice");
+        {
+            FrameCache cache (frameBytes * 3);
+            cache.add (1, 0, makeFrame());
+            cache.add (1, 0, makeFrame());
+
+            expectEquals (cache.getNumFrames(), 1);
+            expect (cache.getNumBytes() == frameBytes);
+        }
+
+        beginTest ("Shrinking the budget keeps the most recent frames");
+        {
+            FrameCache cache (frameBytes * 4);
+
+            for (int64 time = 0; time < 4; ++time)
+                cache.add (1, time, makeFrame());
+
+            expect (cache.get (1, 1).isValid());
+            cache.setMaxBytes (frameBytes * 2);
+
+            expectEquals (cache.getNumFrames(), 2);
+            expect (cache.get (1, 1).isValid());
+            expect (cache.get (1, 3).isValid());
+            expect (! cache.get (1, 0).isValid());
+        }
+
+        beginTest ("Frames bigger than the budget aren't stored");
+        {
+            FrameCache cache (frameBytes / 2);
+            cache.add (1, 0, makeFrame());
+            expectEquals (cache.getNumFrames(), 0);
+        }
+
+        beginTest ("Finds the latest frame at or before a time, per media");
+        {
+            FrameCache cache (frameBytes * 4);
+            cache.add (1, 1000, makeFrame());
+            cache.add (1, 2000, makeFrame());
+            cache.add (2, 1500, makeFrame());
+
+            int64 found = 0;
+            expect (cache.getAtOrBefore (1, 1900, 1000, &found).isValid());
+            expectEquals (found, static_cast<int64>(1000));
+            expect (! cache.getAtOrBefore (1, 1900, 500).isValid());
+            expect (! cache.getAtOrBefore (2, 1000, 1000).isValid());
+
+            cache.remove (1);
+            expectEquals (cache.getNumFrames(), 1);
+        }
+    }
+};
+
+static FrameCacheTests frameCacheTests;
+
+//==============================================================================
+class KeyframeIndexTests : public UnitTest
+{
+public:
+    KeyframeIndexTests() : UnitTest ("KeyframeIndex", "juce_libvlc") {}
+
+    void runTest() override
+    {
+        beginTest ("Reads keyframe times from stts, stss and ctts");
+        {
+            // Ten samples 100 ticks apart at 1000 ticks a second, each shown 200 ticks late
+            TemporaryFile file (".mp4");
+            writeMovie (file.getFile(), { 1, 5, 9 }, true);
+
+            auto index = KeyframeIndex::build (file.getFile());
+            expect (index != nullptr);
+
+            if (index != nullptr)
+            {
+                expectEquals (index->getNumKeyframes(), 3);
+                expect (! index->isEveryFrameAKeyframe());
+                expectWithinAbsoluteError (index->getKeyframeAtOrBefore (0.7), 0.6, 1.0e-9);
+                expectWithinAbsoluteError (index->getKeyframeAtOrBefore (0.1), 0.2, 1.0e-9);
+                expectWithinAbsoluteError (index->getNearestKeyframe (0.85), 1.0, 1.0e-9);
+                expectWithinAbsoluteError (index->getDecodeDistance (0.7), 0.1, 1.0e-9);
+            }
+
+            // Building never writes the sidecar cache
+            expect (! KeyframeIndex::getCacheFileFor (file.getFile()).exists());
+        }
+
+        beginTest ("Decode times alone without a ctts");
+        {
+            TemporaryFile file (".mp4");
+            writeMovie (file.getFile(), { 1, 5, 9 }, false);
+
+            auto index = KeyframeIndex::build (file.getFile());
+            expect (index != nullptr);
+
+            if (index != nullptr)
+                expectWithinAbsoluteError (index->getKeyframeAtOrBefore (0.5), 0.4, 1.0e-9);
+        }
+
+        beginTest ("No stss means every frame is a keyframe");
+        {
+            TemporaryFile file (".mp4");
+            writeMovie (file.getFile(), {}, true);
+
+            auto index = KeyframeIndex::build (file.getFile());
+            expect (index != nullptr && index->isEveryFrameAKeyframe());
+        }
+
+        beginTest ("Edit lists shift keyframes onto the presentation timeline");
+        {
+            // Starting 200 ticks into the media cancels the composition offset...
+            TemporaryFile file (".mp4");
+            writeMovie (file.getFile(), { 1, 5, 9 }, true, { 1000, 200 });
+
+            auto index = KeyframeIndex::build (file.getFile());
+            expect (index != nullptr);
+
+            if (index != nullptr)
+                expectWithinAbsoluteError (index->getKeyframeAtOrBefore (0.5), 0.4, 1.0e-9);
+
+            // ...and a leading empty edit of 300 ticks at 600 a second delays everything by 0.5 s
+            TemporaryFile delayed (".mp4");
+            writeMovie (delayed.getFile(), { 1, 5, 9 }, true, { 300, -1, 1000, 200 });
+
+            index = KeyframeIndex::build (delayed.getFile());
+            expect (index != nullptr);
+
+            if (index != nullptr)
+                expectWithinAbsoluteError (index->getKeyframeAtOrBefore (1.0), 0.9, 1.0e-9);
+        }
+
+        beginTest ("Several media edits mean no index");
+        {
+            TemporaryFile file (".mp4");
+            writeMovie (file.getFile(), { 1, 5, 9 }, true, { 500, 0, 500, 500 });
+            expect (KeyframeIndex::build (file.getFile()) == nullptr);
+        }
+
+        beginTest ("Files without a movie box have no index");
+        {
+            TemporaryFile file (".mp4");
+            file.getFile().replaceWithText ("not a movie");
+            expect (KeyframeIndex::build (file.getFile()) == nullptr);
+        }
+    }
+
+private:
+    static MemoryBlock makeBox (const char* type, const MemoryBlock& payload)
+    {
+        MemoryOutputStream box;
+        box.writeIntBigEndian (static_cast<int>(payload.getSize()) + 8);
+        box.write (type, 4);
+        box.write (payload.getData(), payload.getSize());
+        return box.getMemoryBlock();
+    }
+
+    static MemoryBlock makeFullBox (const char* type, const Array<int>& fields)
+    {
+        MemoryOutputStream payload;
+        payload.writeIntBigEndian (0);      // Version and flags
+
+        for (auto field : fields)
+            payload.writeIntBigEndian (field);
+
+        return makeBox (type, payload.getMemoryBlock());
+    }
+
+    static MemoryBlock join (std::initializer_list<MemoryBlock> boxes)
+    {
+        MemoryBlock joined;
+
+        for (auto& box : boxes)
+            joined.append (box.getData(), box.getSize());
+
+        return joined;
+    }
+
+    // Edits are (duration in movie ticks, media time) pairs; the movie runs at 600 ticks a second
+    static void writeMovie (const File& file, const Array<int>& syncSamples, bool withCompositionOffsets,
+                            const Array<int>& edits = {})
+    {
+        constexpr int numSamples = 10, sampleDelta = 100, compositionOffset = 200;
+
+        auto movieHeader = makeFullBox ("mvhd", { 0, 0, 600, numSamples * sampleDelta * 600 / 1000 });
+        auto mediaHeader = makeFullBox ("mdhd", { 0, 0, 1000, numSamples * sampleDelta, 0 });
+
+        MemoryOutputStream handlerPayload;
+        handlerPayload.writeIntBigEndian (0);
+        handlerPayload.writeIntBigEndian (0);
+        handlerPayload.write ("vide", 4);
+        auto handler = makeBox ("hdlr", handlerPayload.getMemoryBlock());
+
+        MemoryBlock tables = makeFullBox ("stts", { 1, numSamples, sampleDelta });
+
+        if (! syncSamples.isEmpty())
+        {
+            Array<int> stss { syncSamples.size() };
+            stss.addArray (syncSamples);
+            tables = join ({ tables, makeFullBox ("stss", stss) });
+        }
+
+        if (withCompositionOffsets)
+            tables = join ({ tables, makeFullBox ("ctts", { 1, numSamples, compositionOffset }) });
+
+        auto sampleTable = makeBox ("stbl", tables);
+        auto track = makeBox ("mdia", join ({ mediaHeader, handler, makeBox ("minf", sampleTable) }));
+
+        if (! edits.isEmpty())
+        {
+            Array<int> elst { edits.size() / 2 };
+
+            for (int i = 0; i + 1 < edits.size(); i += 2)
+                elst.addArray ({ edits[i], edits[i + 1], 0x10000 });     // Normal playback rate
+
+            track = join ({ makeBox ("edts", makeFullBox ("elst", elst)), track });
+        }
+
+        auto movie = makeBox ("moov", join ({ movieHeader, makeBox ("trak", track) }));
+
+        // The movie box after the media data, as most encoders write it
+        auto fileType = makeBox ("ftyp", MemoryBlock ("isom\0\0\0\0", 8));
+        auto mediaData = makeBox ("mdat", MemoryBlock (64, true));
+        file.replaceWithData (join ({ fileType, mediaData, movie }).getData(), fileType.getSize() + mediaData.getSize() + movie.getSize());
+    }
+};
+
+static KeyframeIndexTests keyframeIndexTests;
+
+} // namespace juce